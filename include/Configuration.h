@@ -22,12 +22,18 @@
 #define MQTT_MAX_ROOT_CA_CERT_STRLEN 2048 
 
 #define INV_MAX_NAME_STRLEN 31
-#define INV_MAX_COUNT 10
+#define INV_MAX_COUNT 50
 #define INV_MAX_CHAN_COUNT 4
 
 #define CHAN_MAX_NAME_STRLEN 31
 
-#define JSON_BUFFER_SIZE 6144
+#define VEDIRECT_MAX_NAME_STRLEN 31
+#define VEDIRECT_MAX_COUNT 2
+#define VEDIRECT_MAX_FIELD_COUNT 32
+
+#define JSON_BUFFER_SIZE 6144 // everything except the inverters
+#define INV_JSON_BUFFER_SIZE 512 // per inverter, name and all channel names at full length
+#define JSON_BUFFER_FILE_FACTOR 3 // reading needs at most this multiple of the file size, short numeric members need the most
 
 struct CHANNEL_CONFIG_T {
     uint16_t MaxChannelPower;
@@ -37,9 +43,18 @@ struct CHANNEL_CONFIG_T {
 struct INVERTER_CONFIG_T {
     uint64_t Serial;
     char Name[INV_MAX_NAME_STRLEN + 1];
+    uint32_t PollInterval; // s, 0 = shared Dtu_PollInterval
+    uint32_t AlarmLogInterval; // s, 0 = with every poll
     CHANNEL_CONFIG_T channel[INV_MAX_CHAN_COUNT];
 };
 
+struct VEDIRECT_CONFIG_T {
+    bool Enabled;
+    char Name[VEDIRECT_MAX_NAME_STRLEN + 1];
+    int8_t RxPin;
+    int8_t TxPin;
+};
+
 struct CONFIG_T {
     uint32_t Cfg_Version;
     uint Cfg_SaveCount;
@@ -85,6 +100,8 @@ struct CONFIG_T {
     bool Vedirect_Enabled;
     bool Vedirect_UpdatesOnly;
     uint32_t Vedirect_PollInterval;
+    VEDIRECT_CONFIG_T Vedirect_Device[VEDIRECT_MAX_COUNT];
+    uint32_t Vedirect_Deadband[VEDIRECT_MAX_FIELD_COUNT];
 
     char Mqtt_Hostname[MQTT_MAX_HOSTNAME_STRLEN + 1];
 
@@ -102,6 +119,7 @@ public:
     void migrate();
     CONFIG_T& get();
 
+    uint8_t getInverterCount();
     INVERTER_CONFIG_T* getFreeInverterSlot();
     INVERTER_CONFIG_T* getInverterConfig(uint64_t serial);
 };
@@ -12,6 +12,7 @@ public:
     MessageOutputClass();
     void loop();
     size_t write(uint8_t c);
+    size_t write(const uint8_t* buffer, size_t size);
     void register_ws_output(AsyncWebSocket* output);
 
 private:
@@ -13,6 +13,7 @@ public:
     static String getTopic(std::shared_ptr<InverterAbstract> inv, uint8_t channel, uint8_t fieldId);
 
 private:
+    void publishRadioStats(std::shared_ptr<InverterAbstract> inv, const String& subtopic);
     void publishField(std::shared_ptr<InverterAbstract> inv, uint8_t channel, uint8_t fieldId);
     void onMqttMessage(const espMqttClientTypes::MessageProperties& properties, const char* topic, const uint8_t* payload, size_t len, size_t index, size_t total);
 
@@ -1,25 +1,22 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 #pragma once
 
-#include "VeDirectFrameHandler.h"
+#include "VeDirect.h"
 #include "Configuration.h"
 #include <Arduino.h>
-#include <map>
-
-#ifndef VICTRON_PIN_RX
-#define VICTRON_PIN_RX 22
-#endif
-
-#ifndef VICTRON_PIN_TX
-#define VICTRON_PIN_TX 21
-#endif
+#include <espMqttClient.h>
 
 class MqttHandleVedirectClass {
 public:
     void init();
     void loop();
 private:
-    std::map<String, String> _kv_map;
+    void publishStats(uint8_t pos, VeDirectFrameHandler* dev, const String& prefix, bool updatesOnly);
+    void publishRegisters(uint8_t pos);
+    void onMqttMessage(const espMqttClientTypes::MessageProperties& properties, const char* topic, const uint8_t* payload, size_t len, size_t index, size_t total);
+
+    VeDirectParserStats _lastStats[VEDIRECT_MAX_COUNT] = {};
+    uint32_t _lastRegisterSeq[VEDIRECT_MAX_COUNT] = {};
     uint32_t _lastPublish;
 };
 
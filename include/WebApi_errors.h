@@ -81,4 +81,12 @@ enum WebApiError {
     PowerBase = 11000,
     PowerSerialZero,
     PowerInvalidInverter,
+
+    VedirectBase = 12000,
+    VedirectNameLength,
+    VedirectInvalidPin,
+    VedirectInvalidDevice,
+    VedirectRegisterSize,
+    VedirectRegisterBusy,
+    VedirectRegisterSent,
 };
\ No newline at end of file
@@ -11,8 +11,18 @@ public:
 
 private:
     void onPrometheusMetricsGet(AsyncWebServerRequest* request);
+    bool generatePart(Print* stream, uint8_t part);
 
-    void addField(AsyncResponseStream* stream, String& serial, uint8_t idx, std::shared_ptr<InverterAbstract> inv, uint8_t channel, uint8_t fieldId, const char* channelName = NULL);
+    void addSystemMetrics(Print* stream);
+    void addInverterMetrics(Print* stream, uint8_t idx);
+    void addVedirectMetrics(Print* stream, uint8_t idx);
+
+    void addField(Print* stream, String& serial, uint8_t idx, std::shared_ptr<InverterAbstract> inv, uint8_t channel, uint8_t fieldId, const char* channelName = NULL);
+    void addRadioLinkCounter(Print* stream, String& serial, uint8_t idx, std::shared_ptr<InverterAbstract> inv, const char* metric, const char* help, uint32_t value);
+    void addRadioLatencyHistogram(Print* stream, String& serial, uint8_t idx, std::shared_ptr<InverterAbstract> inv, const LinkStatistics& link);
+    void addRadioFragmentCounter(Print* stream, String& serial, uint8_t idx, std::shared_ptr<InverterAbstract> inv, uint8_t fragmentId, const char* metric, const char* help, uint32_t value);
+    void addRadioChannelCounter(Print* stream, String& serial, uint8_t idx, std::shared_ptr<InverterAbstract> inv, uint8_t chIdx, const char* metric, const char* help, uint32_t value);
+    void addVedirectCounter(Print* stream, uint8_t idx, const char* name, const char* metric, const char* help, uint32_t value);
 
     AsyncWebServer* _server;
 };
\ No newline at end of file
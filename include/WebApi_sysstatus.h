@@ -3,6 +3,9 @@
 
 #include <ESPAsyncWebServer.h>
 
+#define SYSSTATUS_JSON_BASE_SIZE 1536
+#define SYSSTATUS_JSON_INVERTER_SIZE 128
+
 class WebApiSysstatusClass {
 public:
     void init(AsyncWebServer* server);
@@ -13,6 +13,9 @@ private:
     void onVedirectStatus(AsyncWebServerRequest* request);
     void onVedirectAdminGet(AsyncWebServerRequest* request);
     void onVedirectAdminPost(AsyncWebServerRequest* request);
+    void onVedirectHistory(AsyncWebServerRequest* request);
+    void onVedirectRegisterGet(AsyncWebServerRequest* request);
+    void onVedirectRegisterPost(AsyncWebServerRequest* request);
 
     AsyncWebServer* _server;
 };
\ No newline at end of file
@@ -5,6 +5,9 @@
 #include <ESPAsyncWebServer.h>
 #include <Hoymiles.h>
 
+#define LIVEDATA_JSON_BASE_SIZE 1024 // totals and hints
+#define LIVEDATA_JSON_INVERTER_SIZE 4096 // all fields of an inverter with 4 inputs and their names
+
 class WebApiWsLiveClass {
 public:
     WebApiWsLiveClass();
@@ -12,7 +15,9 @@ public:
     void loop();
 
 private:
-    void generateJsonResponse(JsonVariant& root);
+    void sendNextInverter();
+    void generateInverterJson(JsonObject& invObject, uint8_t idx, std::shared_ptr<InverterAbstract> inv);
+    void generateTotalJson(JsonVariant& root);
     void addField(JsonObject& root, uint8_t idx, std::shared_ptr<InverterAbstract> inv, uint8_t channel, uint8_t fieldId, String topic = "");
     void addTotalField(JsonObject& root, String name, float value, String unit, uint8_t digits);
     void onLivedataStatus(AsyncWebServerRequest* request);
@@ -25,4 +30,7 @@ private:
     uint32_t _lastInvUpdateCheck = 0;
     uint32_t _lastWsCleanup = 0;
     uint32_t _newestInverterTimestamp = 0;
+
+    uint8_t _wsNextInverter = 0;
+    bool _wsRoundPending = false;
 };
\ No newline at end of file
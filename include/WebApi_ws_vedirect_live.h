@@ -5,6 +5,8 @@
 #include <ESPAsyncWebServer.h>
 #include <VeDirectFrameHandler.h>
 
+#define VEDIRECT_JSON_DEVICE_SIZE 3072 // includes the battery monitor fields and VE_MAX_EXTRA_FIELDS copied labels
+
 class WebApiWsVedirectLiveClass {
 public:
     WebApiWsVedirectLiveClass();
@@ -13,6 +15,8 @@ public:
 
 private:
     void generateJsonResponse(JsonVariant& root);
+    void generateDeviceJson(JsonObject root, VeDirectFrameHandler* dev);
+    size_t getJsonSize();
     void onLivedataStatus(AsyncWebServerRequest* request);
     void onWebsocketEvent(AsyncWebSocket* server, AsyncWebSocketClient* client, AwsEventType type, void* arg, uint8_t* data, size_t len);
 
@@ -81,4 +81,21 @@
 
 #define VEDIRECT_ENABLED false
 #define VEDIRECT_UPDATESONLY true
-#define VEDIRECT_POLL_INTERVAL 5
\ No newline at end of file
+#define VEDIRECT_POLL_INTERVAL 5
+
+#ifndef VICTRON_PIN_RX
+#define VICTRON_PIN_RX 22
+#endif
+
+#ifndef VICTRON_PIN_TX
+#define VICTRON_PIN_TX 21
+#endif
+
+// second device is not connected by default
+#ifndef VICTRON2_PIN_RX
+#define VICTRON2_PIN_RX -1
+#endif
+
+#ifndef VICTRON2_PIN_TX
+#define VICTRON2_PIN_TX -1
+#endif
\ No newline at end of file
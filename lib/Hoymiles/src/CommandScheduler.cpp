@@ -0,0 +1,111 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2022 Thomas Basler and others
+ */
+#include "CommandScheduler.h"
+#include "commands/CommandPool.h"
+
+void CommandScheduler::push(CommandAbstract* cmd, uint32_t now)
+{
+    CommandPriority priority = cmd->getPriority();
+    CommandQueue& queue = _queues[priority];
+
+    cmd->setQueueTime(now);
+    if (cmd->getDeadline() == 0) {
+        cmd->setDeadline(getDefaultDeadline(priority));
+    }
+
+    for (CommandAbstract* pending = queue.front(); pending != nullptr; pending = queue.next(pending)) {
+        if (!cmd->isDuplicateOf(pending)) {
+            continue;
+        }
+
+        _stats[priority].coalesced++;
+        if (priority == CMD_PRIORITY_CONTROL) {
+            // The latest control command wins but keeps the place of the old one
+            cmd->setQueueTime(pending->getQueueTime());
+            queue.replace(pending, cmd);
+            CommandPoolBase::release(pending);
+        } else {
+            CommandPoolBase::release(cmd);
+        }
+        return;
+    }
+
+    queue.push(cmd);
+    _stats[priority].pending++;
+}
+
+CommandAbstract* CommandScheduler::pop(uint32_t now, bool& expired)
+{
+    for (uint8_t priority = 0; priority < CMD_PRIORITY_COUNT; priority++) {
+        CommandQueue& queue = _queues[priority];
+        CommandSchedulerStatistics& stats = _stats[priority];
+
+        // Take the oldest command of the inverter with the next higher address than the
+        // one served last, wrap around to the lowest address
+        CommandAbstract* next = nullptr;
+        CommandAbstract* lowest = nullptr;
+        for (CommandAbstract* c = queue.front(); c != nullptr; c = queue.next(c)) {
+            uint64_t target = c->getTargetAddress();
+            if (lowest == nullptr || target < lowest->getTargetAddress()) {
+                lowest = c;
+            }
+            if (target > _cursor[priority] && (next == nullptr || target < next->getTargetAddress())) {
+                next = c;
+            }
+        }
+        CommandAbstract* cmd = next != nullptr ? next : lowest;
+        if (cmd == nullptr) {
+            continue;
+        }
+
+        queue.remove(cmd);
+        stats.pending--;
+
+        uint32_t wait = now - cmd->getQueueTime();
+        expired = wait > cmd->getDeadline();
+        if (expired) {
+            stats.expired++;
+            return cmd;
+        }
+
+        _cursor[priority] = cmd->getTargetAddress();
+        stats.scheduled++;
+        stats.waitSum += wait;
+        if (wait > stats.waitMax) {
+            stats.waitMax = wait;
+        }
+        return cmd;
+    }
+
+    expired = false;
+    return nullptr;
+}
+
+bool CommandScheduler::empty()
+{
+    for (uint8_t priority = 0; priority < CMD_PRIORITY_COUNT; priority++) {
+        if (!_queues[priority].empty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void CommandScheduler::getStatistics(CommandPriority priority, CommandSchedulerStatistics& stats)
+{
+    stats = _stats[priority];
+}
+
+uint32_t CommandScheduler::getDefaultDeadline(CommandPriority priority)
+{
+    switch (priority) {
+    case CMD_PRIORITY_CONTROL:
+        return HOY_CMD_DEADLINE_CONTROL;
+    case CMD_PRIORITY_STATS:
+        return HOY_CMD_DEADLINE_STATS;
+    default:
+        return HOY_CMD_DEADLINE_BACKGROUND;
+    }
+}
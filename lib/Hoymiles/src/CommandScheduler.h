@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "commands/CommandAbstract.h"
+#include "commands/CommandQueue.h"
+#include <cstdint>
+
+// maximum time a command may wait in the queue before it is dropped, per priority class
+#define HOY_CMD_DEADLINE_CONTROL (60 * 1000)
+#define HOY_CMD_DEADLINE_STATS (10 * 1000)
+#define HOY_CMD_DEADLINE_BACKGROUND (60 * 1000)
+
+struct CommandSchedulerStatistics {
+    uint32_t scheduled; // commands handed over to the radio
+    uint32_t coalesced; // duplicates merged into an already pending command
+    uint32_t expired; // commands dropped because their deadline has passed
+    uint32_t pending; // commands currently waiting
+    uint32_t waitSum; // ms, sum of the queue wait time of all scheduled commands
+    uint32_t waitMax; // ms
+};
+
+// Pending radio commands ordered by priority class. Within a class the inverters
+// are served round robin in the order of their address, the commands of one
+// inverter are kept in their order.
+// Not thread safe.
+class CommandScheduler {
+public:
+    // Adds a command or merges it into a pending duplicate. A newer control
+    // command replaces the pending one, other duplicates are dropped.
+    void push(CommandAbstract* cmd, uint32_t now);
+
+    // Returns the next command to send or nullptr. Commands which have passed
+    // their deadline are returned with expired set, the caller has to release them.
+    CommandAbstract* pop(uint32_t now, bool& expired);
+
+    bool empty();
+
+    void getStatistics(CommandPriority priority, CommandSchedulerStatistics& stats);
+
+private:
+    static uint32_t getDefaultDeadline(CommandPriority priority);
+
+    CommandQueue _queues[CMD_PRIORITY_COUNT];
+    uint64_t _cursor[CMD_PRIORITY_COUNT] = {}; // address of the inverter served last
+    CommandSchedulerStatistics _stats[CMD_PRIORITY_COUNT] = {};
+};
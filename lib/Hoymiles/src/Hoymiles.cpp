@@ -19,6 +19,7 @@ void HoymilesClass::init(SPIClass* initialisedSpiBus, uint8_t pinCE, uint8_t pin
     HOY_SEMAPHORE_GIVE();  // release before first use
 
     _pollInterval = 0;
+    rebuildIndex();
     _radio.reset(new HoymilesRadio());
     _radio->init(initialisedSpiBus, pinCE, pinIRQ);
 }
@@ -26,64 +27,138 @@ void HoymilesClass::init(SPIClass* initialisedSpiBus, uint8_t pinCE, uint8_t pin
 void HoymilesClass::loop()
 {
     HOY_SEMAPHORE_TAKE();
-    _radio->loop();
-
-    if (getNumInverters() > 0) {
-        if (millis() - _lastPoll > (_pollInterval * 1000)) {
-            static uint8_t inverterPos = 0;
-
-            if (_radio->isIdle()) {
-                std::shared_ptr<InverterAbstract> iv = getInverterByPos(inverterPos);
-                if (iv != nullptr) {
-                    _messageOutput->print(F("Fetch inverter: "));
-                    _messageOutput->println(iv->serial(), HEX);
-
-                    iv->sendStatsRequest(_radio.get());
-
-                    // Fetch event log
-                    bool force = iv->EventLog()->getLastAlarmRequestSuccess() == CMD_NOK;
-                    iv->sendAlarmLogRequest(_radio.get(), force);
-
-                    // Fetch limit
-                    if ((iv->SystemConfigPara()->getLastLimitRequestSuccess() == CMD_NOK)
-                        || ((millis() - iv->SystemConfigPara()->getLastUpdateRequest() > HOY_SYSTEM_CONFIG_PARA_POLL_INTERVAL)
-                            && (millis() - iv->SystemConfigPara()->getLastUpdateCommand() > HOY_SYSTEM_CONFIG_PARA_POLL_MIN_DURATION))) {
-                        _messageOutput->println("Request SystemConfigPara");
-                        iv->sendSystemConfigParaRequest(_radio.get());
-                    }
-
-                    // Set limit if required
-                    if (iv->SystemConfigPara()->getLastLimitCommandSuccess() == CMD_NOK) {
-                        _messageOutput->println(F("Resend ActivePowerControl"));
-                        iv->resendActivePowerControlRequest(_radio.get());
-                    }
-
-                    // Set power status if required
-                    if (iv->PowerCommand()->getLastPowerCommandSuccess() == CMD_NOK) {
-                        _messageOutput->println(F("Resend PowerCommand"));
-                        iv->resendPowerControlRequest(_radio.get());
-                    }
-
-                    // Fetch dev info (but first fetch stats)
-                    if (iv->Statistics()->getLastUpdate() > 0 && (iv->DevInfo()->getLastUpdateAll() == 0 || iv->DevInfo()->getLastUpdateSimple() == 0)) {
-                        _messageOutput->println(F("Request device info"));
-                        iv->sendDevInfoRequest(_radio.get());
-                    }
-                }
-                if (++inverterPos >= getNumInverters()) {
-                    inverterPos = 0;
+
+    // The next inverter is chosen once the radio has nothing left to do, so
+    // the choice is based on the current due times
+    if (getNumInverters() > 0 && _radio->isIdle() && _radio->isQueueEmpty()) {
+        uint32_t now = millis();
+
+        // Inverters without an own interval share the DTU poll interval in turn
+        uint32_t sharedInterval = _pollInterval * 1000;
+        int32_t sharedOverdue = static_cast<int32_t>(now - _lastPoll - sharedInterval);
+
+        // Serve the inverter whose stats request is overdue the longest
+        InverterAbstract* iv = nullptr;
+        int32_t ivOverdue = 0;
+        for (auto& inv : _inverters) {
+            PollPlan* plan = inv->Poll();
+            int32_t overdue;
+            if (plan->getStatsInterval() > 0) {
+                overdue = plan->getStatsOverdue(now, plan->getStatsInterval());
+            } else if (sharedOverdue >= 0) {
+                overdue = plan->getStatsOverdue(now, 0);
+            } else {
+                continue;
+            }
+
+            if (overdue >= 0 && (iv == nullptr || overdue > ivOverdue)) {
+                iv = inv.get();
+                ivOverdue = overdue;
+            }
+        }
+
+        if (iv != nullptr) {
+            HOY_LOG(RADIO, HOY_LOG_LEVEL_INFO, "Fetch inverter: %s\n", iv->serialString().c_str());
+
+            if (iv->Poll()->getStatsInterval() == 0) {
+                _lastPoll = now;
+            }
+            iv->Poll()->addStatsPoll(now);
+            iv->sendStatsRequest(_radio.get());
+
+            // Set limit if required
+            if (iv->SystemConfigPara()->getLastLimitCommandSuccess() == CMD_NOK) {
+                HOY_LOG(RADIO, HOY_LOG_LEVEL_INFO, "Resend ActivePowerControl\n");
+                iv->resendActivePowerControlRequest(_radio.get());
+            }
+
+            // Set power status if required
+            if (iv->PowerCommand()->getLastPowerCommandSuccess() == CMD_NOK) {
+                HOY_LOG(RADIO, HOY_LOG_LEVEL_INFO, "Resend PowerCommand\n");
+                iv->resendPowerControlRequest(_radio.get());
+            }
+
+            // Background requests have to be done before the next stats request is due
+            int32_t budget = getAirtimeBudget(iv, now) - static_cast<int32_t>(_radio->getAirtime(CMD_TYPE_STATS));
+
+            // Fetch event log
+            bool force = iv->EventLog()->getLastAlarmRequestSuccess() == CMD_NOK;
+            if ((force || iv->Poll()->isAlarmLogDue(now)) && reserveAirtime(iv, CMD_TYPE_ALARM_LOG, budget)) {
+                // records the poll itself, nothing is recorded without a valid time
+                if (!iv->sendAlarmLogRequest(_radio.get(), force)) {
+                    budget += _radio->getAirtime(CMD_TYPE_ALARM_LOG);
                 }
             }
 
-            _lastPoll = millis();
+            // Fetch limit
+            if (((iv->SystemConfigPara()->getLastLimitRequestSuccess() == CMD_NOK)
+                    || ((millis() - iv->SystemConfigPara()->getLastUpdateRequest() > HOY_SYSTEM_CONFIG_PARA_POLL_INTERVAL)
+                        && (millis() - iv->SystemConfigPara()->getLastUpdateCommand() > HOY_SYSTEM_CONFIG_PARA_POLL_MIN_DURATION)))
+                && reserveAirtime(iv, CMD_TYPE_SYSTEM_CONFIG, budget)) {
+                HOY_LOG(RADIO, HOY_LOG_LEVEL_INFO, "Request SystemConfigPara\n");
+                iv->sendSystemConfigParaRequest(_radio.get());
+            }
+
+            // Fetch dev info (but first fetch stats)
+            if (iv->Statistics()->getLastUpdate() > 0 && (iv->DevInfo()->getLastUpdateAll() == 0 || iv->DevInfo()->getLastUpdateSimple() == 0)
+                && reserveAirtime(iv, CMD_TYPE_DEV_INFO, budget)) {
+                HOY_LOG(RADIO, HOY_LOG_LEVEL_INFO, "Request device info\n");
+                iv->sendDevInfoRequest(_radio.get());
+            }
         }
     }
 
     HOY_SEMAPHORE_GIVE();
 }
 
+// ms until the stats request of any other inverter is due, INT32_MAX if there is none
+int32_t HoymilesClass::getAirtimeBudget(InverterAbstract* iv, uint32_t now)
+{
+    int32_t budget = INT32_MAX;
+    bool shared = false;
+
+    for (auto& inv : _inverters) {
+        if (inv.get() == iv) {
+            continue;
+        }
+
+        PollPlan* plan = inv->Poll();
+        if (plan->getStatsInterval() > 0) {
+            budget = min<int32_t>(budget, -plan->getStatsOverdue(now, plan->getStatsInterval()));
+        } else {
+            shared = true;
+        }
+    }
+
+    if (shared) {
+        budget = min<int32_t>(budget, static_cast<int32_t>(_pollInterval * 1000 - (now - _lastPoll)));
+    }
+
+    return max<int32_t>(budget, 0);
+}
+
+// Takes the expected airtime of a background request from the budget. If it does
+// not fit, the request is postponed unless the inverter has waited too often.
+bool HoymilesClass::reserveAirtime(InverterAbstract* iv, CommandType type, int32_t& budget)
+{
+    int32_t airtime = _radio->getAirtime(type);
+    if (airtime > budget && iv->Poll()->deferRequest()) {
+        HOY_LOG(RADIO, HOY_LOG_LEVEL_DEBUG, "Postponed request of %s, %d ms left\n", iv->serialString().c_str(), budget);
+        return false;
+    }
+
+    iv->Poll()->resetDeferCount();
+    budget -= airtime;
+    return true;
+}
+
 std::shared_ptr<InverterAbstract> HoymilesClass::addInverter(const char* name, uint64_t serial)
 {
+    if (_inverters.size() >= HOY_INVERTER_INDEX_SIZE / 2) {
+        HOY_LOG(RADIO, HOY_LOG_LEVEL_ERROR, "Too many inverters, %s not added\n", name);
+        return nullptr;
+    }
+
     std::shared_ptr<InverterAbstract> i = nullptr;
     if (HM_4CH::isValidSerial(serial)) {
         i = std::make_shared<HM_4CH>(serial);
@@ -96,8 +171,11 @@ std::shared_ptr<InverterAbstract> HoymilesClass::addInverter(const char* name, u
     if (i) {
         i->setName(name);
         i->init();
-        _inverters.push_back(std::move(i));
-        return _inverters.back();
+        HOY_SEMAPHORE_TAKE();
+        _inverters.push_back(i);
+        rebuildIndex();
+        HOY_SEMAPHORE_GIVE();
+        return i;
     }
 
     return nullptr;
@@ -114,12 +192,11 @@ std::shared_ptr<InverterAbstract> HoymilesClass::getInverterByPos(uint8_t pos)
 
 std::shared_ptr<InverterAbstract> HoymilesClass::getInverterBySerial(uint64_t serial)
 {
-    for (uint8_t i = 0; i < _inverters.size(); i++) {
-        if (_inverters[i]->serial() == serial) {
-            return _inverters[i];
-        }
+    int16_t pos = findPos(serial);
+    if (pos < 0) {
+        return nullptr;
     }
-    return nullptr;
+    return _inverters[pos];
 }
 
 std::shared_ptr<InverterAbstract> HoymilesClass::getInverterByFragment(fragment_t* fragment)
@@ -128,32 +205,118 @@ std::shared_ptr<InverterAbstract> HoymilesClass::getInverterByFragment(fragment_
         return nullptr;
     }
 
-    std::shared_ptr<InverterAbstract> inv;
-    for (uint8_t i = 0; i < _inverters.size(); i++) {
-        inv = _inverters[i];
-        serial_u p;
-        p.u64 = inv->serial();
+    int16_t pos = findPosByRadioId(fragmentRadioId(fragment));
+    if (pos < 0) {
+        return nullptr;
+    }
+    return _inverters[pos];
+}
 
-        if ((p.b[3] == fragment->fragment[1])
-            && (p.b[2] == fragment->fragment[2])
-            && (p.b[1] == fragment->fragment[3])
-            && (p.b[0] == fragment->fragment[4])) {
+InverterAbstract* HoymilesClass::getInverterPtrBySerial(uint64_t serial)
+{
+    int16_t pos = findPos(serial);
+    if (pos < 0) {
+        return nullptr;
+    }
+    return _inverters[pos].get();
+}
 
-            return inv;
-        }
+InverterAbstract* HoymilesClass::getInverterPtrByFragment(fragment_t* fragment)
+{
+    if (fragment->len <= 4) {
+        return nullptr;
     }
-    return nullptr;
+
+    int16_t pos = findPosByRadioId(fragmentRadioId(fragment));
+    if (pos < 0) {
+        return nullptr;
+    }
+    return _inverters[pos].get();
 }
 
 void HoymilesClass::removeInverterBySerial(uint64_t serial)
 {
-    for (uint8_t i = 0; i < _inverters.size(); i++) {
-        if (_inverters[i]->serial() == serial) {
-            HOY_SEMAPHORE_TAKE();
-            _inverters.erase(_inverters.begin() + i);
-            HOY_SEMAPHORE_GIVE();
-            return;
+    HOY_SEMAPHORE_TAKE();
+    int16_t pos = findPos(serial);
+    if (pos >= 0) {
+        _inverters.erase(_inverters.begin() + pos);
+        rebuildIndex();
+    }
+    HOY_SEMAPHORE_GIVE();
+}
+
+// Fibonacci hashing, spreads the mostly sequential serials over the table
+uint8_t HoymilesClass::hashIndex(uint32_t key)
+{
+    return ((key * 2654435761u) >> 24) & (HOY_INVERTER_INDEX_SIZE - 1);
+}
+
+uint32_t HoymilesClass::radioId(uint64_t serial)
+{
+    return static_cast<uint32_t>(serial & 0xFFFFFFFF);
+}
+
+// Sender of a fragment, most significant byte first
+uint32_t HoymilesClass::fragmentRadioId(fragment_t* fragment)
+{
+    return (static_cast<uint32_t>(fragment->fragment[1]) << 24)
+        | (static_cast<uint32_t>(fragment->fragment[2]) << 16)
+        | (static_cast<uint32_t>(fragment->fragment[3]) << 8)
+        | fragment->fragment[4];
+}
+
+int16_t HoymilesClass::findPos(uint64_t serial)
+{
+    uint8_t idx = hashIndex(radioId(serial) ^ static_cast<uint32_t>(serial >> 32));
+    for (uint8_t n = 0; n < HOY_INVERTER_INDEX_SIZE; n++) {
+        uint8_t pos = _indexBySerial[idx];
+        if (pos == HOY_INVERTER_INDEX_EMPTY) {
+            break;
+        }
+        if (pos < _inverters.size() && _inverters[pos]->serial() == serial) {
+            return pos;
+        }
+        idx = (idx + 1) & (HOY_INVERTER_INDEX_SIZE - 1);
+    }
+    return -1;
+}
+
+int16_t HoymilesClass::findPosByRadioId(uint32_t id)
+{
+    uint8_t idx = hashIndex(id);
+    for (uint8_t n = 0; n < HOY_INVERTER_INDEX_SIZE; n++) {
+        uint8_t pos = _indexByRadioId[idx];
+        if (pos == HOY_INVERTER_INDEX_EMPTY) {
+            break;
+        }
+        if (pos < _inverters.size() && radioId(_inverters[pos]->serial()) == id) {
+            return pos;
+        }
+        idx = (idx + 1) & (HOY_INVERTER_INDEX_SIZE - 1);
+    }
+    return -1;
+}
+
+// Called with the inverter list locked whenever it changes
+void HoymilesClass::rebuildIndex()
+{
+    memset(_indexBySerial, HOY_INVERTER_INDEX_EMPTY, sizeof(_indexBySerial));
+    memset(_indexByRadioId, HOY_INVERTER_INDEX_EMPTY, sizeof(_indexByRadioId));
+
+    for (uint8_t pos = 0; pos < _inverters.size(); pos++) {
+        uint64_t serial = _inverters[pos]->serial();
+
+        uint8_t idx = hashIndex(radioId(serial) ^ static_cast<uint32_t>(serial >> 32));
+        while (_indexBySerial[idx] != HOY_INVERTER_INDEX_EMPTY) {
+            idx = (idx + 1) & (HOY_INVERTER_INDEX_SIZE - 1);
         }
+        _indexBySerial[idx] = pos;
+
+        idx = hashIndex(radioId(serial));
+        while (_indexByRadioId[idx] != HOY_INVERTER_INDEX_EMPTY) {
+            idx = (idx + 1) & (HOY_INVERTER_INDEX_SIZE - 1);
+        }
+        _indexByRadioId[idx] = pos;
     }
 }
 
@@ -177,6 +340,16 @@ void HoymilesClass::setPollInterval(uint32_t interval)
     _pollInterval = interval;
 }
 
+void HoymilesClass::lock()
+{
+    HOY_SEMAPHORE_TAKE();
+}
+
+void HoymilesClass::unlock()
+{
+    HOY_SEMAPHORE_GIVE();
+}
+
 void HoymilesClass::setMessageOutput(Print* output)
 {
     _messageOutput = output;
@@ -185,4 +358,19 @@ void HoymilesClass::setMessageOutput(Print* output)
 Print* HoymilesClass::getMessageOutput()
 {
     return _messageOutput;
+}
+
+void HoymilesClass::setLogLevel(HoymilesLogModule module, uint8_t level)
+{
+    _logLevel[module] = level;
+}
+
+uint8_t HoymilesClass::getLogLevel(HoymilesLogModule module)
+{
+    return _logLevel[module];
+}
+
+bool HoymilesClass::isLogEnabled(HoymilesLogModule module, uint8_t level)
+{
+    return level <= _logLevel[module];
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 #pragma once
 
+#include "HoymilesLog.h"
 #include "HoymilesRadio.h"
 #include "inverters/InverterAbstract.h"
 #include "types.h"
@@ -10,6 +11,9 @@
 #include <vector>
 
 #define HOY_SYSTEM_CONFIG_PARA_POLL_INTERVAL (2 * 60 * 1000) // 2 minutes
+#define HOY_INVERTER_INDEX_SIZE 128 // power of two, at least twice the number of inverters
+#define HOY_INVERTER_INDEX_EMPTY 0xff
+
 #define HOY_SYSTEM_CONFIG_PARA_POLL_MIN_DURATION (4 * 60 * 1000) // at least 4 minutes between sending limit command and read request. Otherwise eventlog entry
 
 class HoymilesClass {
@@ -17,9 +21,18 @@ public:
     void init(SPIClass* initialisedSpiBus, uint8_t pinCE, uint8_t pinIRQ);
     void loop();
 
+    // Serializes access to the inverter list, used by loop() and the radio task
+    void lock();
+    void unlock();
+
     void setMessageOutput(Print* output);
     Print* getMessageOutput();
 
+    // Runtime log level per module, HOY_LOG_MAX_LEVEL_* still limits it
+    void setLogLevel(HoymilesLogModule module, uint8_t level);
+    uint8_t getLogLevel(HoymilesLogModule module);
+    bool isLogEnabled(HoymilesLogModule module, uint8_t level);
+
     std::shared_ptr<InverterAbstract> addInverter(const char* name, uint64_t serial);
     std::shared_ptr<InverterAbstract> getInverterByPos(uint8_t pos);
     std::shared_ptr<InverterAbstract> getInverterBySerial(uint64_t serial);
@@ -27,21 +40,41 @@ public:
     void removeInverterBySerial(uint64_t serial);
     size_t getNumInverters();
 
+    // Non-owning lookups without reference counting for hot paths. The pointer
+    // is only valid while the inverter list is locked, e.g. in the radio task.
+    InverterAbstract* getInverterPtrBySerial(uint64_t serial);
+    InverterAbstract* getInverterPtrByFragment(fragment_t* fragment);
+
     HoymilesRadio* getRadio();
 
     uint32_t PollInterval();
     void setPollInterval(uint32_t interval);
 
 private:
+    static uint8_t hashIndex(uint32_t key);
+    static uint32_t radioId(uint64_t serial);
+    static uint32_t fragmentRadioId(fragment_t* fragment);
+    int32_t getAirtimeBudget(InverterAbstract* iv, uint32_t now);
+    bool reserveAirtime(InverterAbstract* iv, CommandType type, int32_t& budget);
+    int16_t findPos(uint64_t serial);
+    int16_t findPosByRadioId(uint32_t id);
+    void rebuildIndex();
+
     std::vector<std::shared_ptr<InverterAbstract>> _inverters;
+
+    // Open addressing hash tables from serial and from radio id (lower 4 bytes of
+    // the serial as sent in every fragment) to the position in _inverters
+    uint8_t _indexBySerial[HOY_INVERTER_INDEX_SIZE];
+    uint8_t _indexByRadioId[HOY_INVERTER_INDEX_SIZE];
     std::unique_ptr<HoymilesRadio> _radio;
 
     SemaphoreHandle_t _xSemaphore;
 
-    uint32_t _pollInterval = 0;
-    uint32_t _lastPoll = 0;
+    uint32_t _pollInterval = 0; // s
+    uint32_t _lastPoll = 0; // last stats request of an inverter using _pollInterval
 
     Print* _messageOutput = &Serial;
+    uint8_t _logLevel[HOY_LOG_MODULE_COUNT] = { HOY_LOG_DEFAULT_LEVEL, HOY_LOG_DEFAULT_LEVEL };
 };
 
 extern HoymilesClass Hoymiles;
\ No newline at end of file
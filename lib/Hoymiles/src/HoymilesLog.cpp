@@ -0,0 +1,21 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2022 Thomas Basler and others
+ */
+#include "HoymilesLog.h"
+
+const char* hoyFormatHex(char* out, size_t size, const uint8_t buf[], uint8_t len)
+{
+    static const char hexDigits[] = "0123456789ABCDEF";
+
+    size_t pos = 0;
+    for (uint8_t i = 0; i < len && pos + 3 < size; i++) {
+        out[pos++] = hexDigits[buf[i] >> 4];
+        out[pos++] = hexDigits[buf[i] & 0x0f];
+        out[pos++] = ' ';
+    }
+    if (size > 0) {
+        out[pos] = '\0';
+    }
+    return out;
+}
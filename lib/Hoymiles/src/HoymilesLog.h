@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#define HOY_LOG_LEVEL_NONE 0
+#define HOY_LOG_LEVEL_ERROR 1
+#define HOY_LOG_LEVEL_WARN 2
+#define HOY_LOG_LEVEL_INFO 3
+#define HOY_LOG_LEVEL_DEBUG 4 // every request and fragment
+#define HOY_LOG_LEVEL_VERBOSE 5 // every interrupt
+
+// Messages above the compile time level of their module are removed by the
+// compiler including their arguments. Override them with build flags, e.g.
+// -DHOY_LOG_MAX_LEVEL_RADIO=HOY_LOG_LEVEL_WARN
+#ifndef HOY_LOG_MAX_LEVEL_RADIO
+#define HOY_LOG_MAX_LEVEL_RADIO HOY_LOG_LEVEL_DEBUG
+#endif
+
+#ifndef HOY_LOG_MAX_LEVEL_PARSER
+#define HOY_LOG_MAX_LEVEL_PARSER HOY_LOG_LEVEL_DEBUG
+#endif
+
+// Level used at runtime until changed with Hoymiles.setLogLevel()
+#define HOY_LOG_DEFAULT_LEVEL HOY_LOG_LEVEL_INFO
+
+enum HoymilesLogModule {
+    HOY_LOG_RADIO = 0,
+    HOY_LOG_PARSER,
+    HOY_LOG_MODULE_COUNT
+};
+
+// Usage: HOY_LOG(RADIO, HOY_LOG_LEVEL_WARN, "format\n", ...), needs Hoymiles.h
+#define HOY_LOG_ENABLED(module, level) \
+    ((level) <= HOY_LOG_MAX_LEVEL_##module && Hoymiles.isLogEnabled(HOY_LOG_##module, (level)))
+
+#define HOY_LOG(module, level, ...) \
+    do { \
+        if (HOY_LOG_ENABLED(module, level)) { \
+            Hoymiles.getMessageOutput()->printf(__VA_ARGS__); \
+        } \
+    } while (0)
+
+// "XX XX XX " for every byte, the buffer needs 3 * len + 1 bytes
+const char* hoyFormatHex(char* out, size_t size, const uint8_t buf[], uint8_t len);
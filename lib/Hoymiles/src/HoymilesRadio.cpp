@@ -6,13 +6,22 @@
 #include "Hoymiles.h"
 #include "commands/RequestFrameCommand.h"
 #include "crc.h"
-#include <Every.h>
 #include <FunctionalInterrupt.h>
 
+#define HOY_RADIO_SEMAPHORE_TAKE() xSemaphoreTake(_xSemaphore, portMAX_DELAY)
+#define HOY_RADIO_SEMAPHORE_GIVE() xSemaphoreGive(_xSemaphore)
+#define HOY_QUEUE_SEMAPHORE_TAKE() xSemaphoreTake(_queueSemaphore, portMAX_DELAY)
+#define HOY_QUEUE_SEMAPHORE_GIVE() xSemaphoreGive(_queueSemaphore)
+
 void HoymilesRadio::init(SPIClass* initialisedSpiBus, uint8_t pinCE, uint8_t pinIRQ)
 {
     _dtuSerial.u64 = 0;
 
+    _xSemaphore = xSemaphoreCreateMutex();
+    HOY_RADIO_SEMAPHORE_GIVE(); // release before first use
+    _queueSemaphore = xSemaphoreCreateMutex();
+    HOY_QUEUE_SEMAPHORE_GIVE(); // release before first use
+
     _spiPtr.reset(initialisedSpiBus);
     _radio.reset(new RF24(pinCE, initialisedSpiBus->pinSS()));
 
@@ -25,133 +34,215 @@ void HoymilesRadio::init(SPIClass* initialisedSpiBus, uint8_t pinCE, uint8_t pin
     _radio->setRetries(0, 0);
     _radio->maskIRQ(true, true, false); // enable only receiving interrupts
     if (_radio->isChipConnected()) {
-        Hoymiles.getMessageOutput()->println(F("Connection successfull"));
+        HOY_LOG(RADIO, HOY_LOG_LEVEL_INFO, "Connection successfull\n");
     } else {
-        Hoymiles.getMessageOutput()->println(F("Connection error!!"));
+        HOY_LOG(RADIO, HOY_LOG_LEVEL_ERROR, "Connection error!!\n");
     }
 
-    attachInterrupt(digitalPinToInterrupt(pinIRQ), std::bind(&HoymilesRadio::handleIntr, this), FALLING);
-
     openReadingPipe();
     _radio->startListening();
+
+    // The task has to exist before the interrupt can notify it
+    xTaskCreatePinnedToCore(radioTask, "hoymiles", HOY_RADIO_TASK_STACK_SIZE, this, HOY_RADIO_TASK_PRIORITY, &_taskHandle, HOY_RADIO_TASK_CORE);
+    attachInterrupt(digitalPinToInterrupt(pinIRQ), std::bind(&HoymilesRadio::handleIntr, this), FALLING);
 }
 
-void HoymilesRadio::loop()
+void HoymilesRadio::radioTask(void* parameter)
 {
-    EVERY_N_MILLIS(4)
-    {
-        switchRxCh();
+    HoymilesRadio* radio = static_cast<HoymilesRadio*>(parameter);
+
+    for (;;) {
+        // Hop the rx channels only while a response is expected,
+        // otherwise sleep until an interrupt or a new command arrives
+        uint32_t events = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &events,
+            radio->_busyFlag ? pdMS_TO_TICKS(HOY_RADIO_CHANNEL_SWITCH_PERIOD) : portMAX_DELAY);
+
+        Hoymiles.lock();
+        xSemaphoreTake(radio->_xSemaphore, portMAX_DELAY);
+        radio->loop(events);
+        xSemaphoreGive(radio->_xSemaphore);
+        Hoymiles.unlock();
     }
+}
 
-    if (_packetReceived) {
-        Hoymiles.getMessageOutput()->println(F("Interrupt received"));
+void HoymilesRadio::loop(uint32_t events)
+{
+    if (events & HOY_RADIO_EVENT_IRQ) {
+        HOY_LOG(RADIO, HOY_LOG_LEVEL_VERBOSE, "Interrupt received\n");
         while (_radio->available()) {
-            if (!(_rxBuffer.size() > FRAGMENT_BUFFER_SIZE)) {
-                fragment_t f;
-                memset(f.fragment, 0xcc, MAX_RF_PAYLOAD_SIZE);
-                f.len = _radio->getDynamicPayloadSize();
-                f.channel = _radio->getChannel();
-                if (f.len > MAX_RF_PAYLOAD_SIZE)
-                    f.len = MAX_RF_PAYLOAD_SIZE;
-                _radio->read(f.fragment, f.len);
-                _rxBuffer.push(f);
+            fragment_t* f = _rxBuffer.reserve();
+            if (nullptr != f) {
+                memset(f->fragment, 0xcc, MAX_RF_PAYLOAD_SIZE);
+                f->len = _radio->getDynamicPayloadSize();
+                f->channel = _radio->getChannel();
+                if (f->len > MAX_RF_PAYLOAD_SIZE)
+                    f->len = MAX_RF_PAYLOAD_SIZE;
+                _radio->read(f->fragment, f->len);
+                _rxBuffer.commit();
             } else {
-                Hoymiles.getMessageOutput()->println(F("Buffer full"));
+                HOY_LOG(RADIO, HOY_LOG_LEVEL_WARN, "Buffer full\n");
                 _radio->flush_rx();
+                _rxBufferFlushCount++;
             }
         }
-        _packetReceived = false;
+    }
 
-    } else {
-        // Perform package parsing only if no packages are received
-        if (!_rxBuffer.empty()) {
-            fragment_t f = _rxBuffer.back();
-            if (checkFragmentCrc(&f)) {
-                std::shared_ptr<InverterAbstract> inv = Hoymiles.getInverterByFragment(&f);
-
-                if (nullptr != inv) {
-                    // Save packet in inverter rx buffer
-                    char buf[30];
-                    snprintf(buf, sizeof(buf), "RX Channel: %d --> ", f.channel);
-                    dumpBuf(buf, f.fragment, f.len);
-                    inv->addRxFragment(f.fragment, f.len);
-                } else {
-                    Hoymiles.getMessageOutput()->println(F("Inverter Not found!"));
+    // Parse everything received so far in the order it was received
+    fragment_t* f;
+    while (nullptr != (f = _rxBuffer.front())) {
+        if (checkFragmentCrc(f)) {
+            InverterAbstract* inv = Hoymiles.getInverterPtrByFragment(f);
+
+            if (nullptr != inv) {
+                if (inv == _activeInverter.get()) {
+                    _rxHit = true;
                 }
 
+                // Save packet in inverter rx buffer
+                HOY_LOG(RADIO, HOY_LOG_LEVEL_DEBUG, "RX Channel: %d --> %s\n",
+                    f->channel, hoyFormatHex(_logBuffer, sizeof(_logBuffer), f->fragment, f->len));
+                inv->addRxFragment(f->fragment, f->len);
             } else {
-                Hoymiles.getMessageOutput()->println(F("Frame kaputt"));
+                HOY_LOG(RADIO, HOY_LOG_LEVEL_WARN, "Inverter Not found!\n");
+                _unknownInverterCount++;
+            }
+
+        } else {
+            HOY_LOG(RADIO, HOY_LOG_LEVEL_WARN, "Frame kaputt\n");
+            _crcErrorCount++;
+
+            // The address may still be intact
+            InverterAbstract* inv = Hoymiles.getInverterPtrByFragment(f);
+            if (nullptr != inv) {
+                inv->RadioStats()->addCrcError();
             }
+        }
+
+        // Remove paket from buffer even it was corrupted
+        _rxBuffer.pop();
+    }
+
+    // Only hop once the fragments received on the current channel were counted for it
+    if (_busyFlag && _rxChSwitchTimeout.occured()) {
+        switchRxCh();
+        _rxChSwitchTimeout.set(HOY_RADIO_CHANNEL_SWITCH_PERIOD);
+    }
+
+    // The rx period ends early if the complete response is there
+    bool rxComplete = _busyFlag && _activeInverter->isAllFragmentsReceived();
+    if (rxComplete && _rttValid) {
+        _activeInverter->RadioStats()->addRoundTrip(_activeCommand->getCommandType(), millis() - _txTime);
+        _rttValid = false;
+    }
+
+    // Request the next missing fragment as soon as the requested one arrived or its slot is over
+    bool retransmitDone = false;
+    if (_busyFlag && _retransmitFragment > 0) {
+        if (_activeInverter->isFragmentReceived(_retransmitFragment)) {
+            _activeInverter->RadioStats()->addRecovered(_retransmitFragment, millis() - _retransmitTime);
+            _retransmitFragment = 0;
+            retransmitDone = _retransmitMask == 0;
+        } else if (_rxTimeout.occured()) {
+            _retransmitFragment = 0;
+        }
 
-            // Remove paket from buffer even it was corrupted
-            _rxBuffer.pop();
+        if (_retransmitFragment == 0 && _retransmitMask != 0 && !rxComplete) {
+            sendNextRetransmitPacket();
         }
     }
 
-    if (_busyFlag && _rxTimeout.occured()) {
-        Hoymiles.getMessageOutput()->println(F("RX Period End"));
-        std::shared_ptr<InverterAbstract> inv = Hoymiles.getInverterBySerial(_commandQueue.front().get()->getTargetAddress());
+    if (_busyFlag && (rxComplete || retransmitDone || _rxTimeout.occured())) {
+        HOY_LOG(RADIO, HOY_LOG_LEVEL_DEBUG, rxComplete ? "RX Complete\n" : "RX Period End\n");
+        InverterAbstract* inv = Hoymiles.getInverterPtrBySerial(_activeCommand->getTargetAddress());
 
         if (nullptr != inv) {
-            CommandAbstract* cmd = _commandQueue.front().get();
-            uint8_t verifyResult = inv->verifyAllFragments(cmd);
+            CommandAbstract* cmd = _activeCommand;
+            uint16_t missing;
+            uint8_t verifyResult = inv->verifyAllFragments(cmd, missing);
             if (verifyResult == FRAGMENT_ALL_MISSING_RESEND) {
-                Hoymiles.getMessageOutput()->println(F("Nothing received, resend whole request"));
+                HOY_LOG(RADIO, HOY_LOG_LEVEL_INFO, "Nothing received, resend whole request\n");
+                inv->RadioStats()->addResend();
                 sendLastPacketAgain();
 
             } else if (verifyResult == FRAGMENT_ALL_MISSING_TIMEOUT) {
-                Hoymiles.getMessageOutput()->println(F("Nothing received, resend count exeeded"));
-                _commandQueue.pop();
-                _busyFlag = false;
+                HOY_LOG(RADIO, HOY_LOG_LEVEL_WARN, "Nothing received, resend count exeeded\n");
+                inv->RadioStats()->addTimeout();
+                releaseActiveCommand();
 
             } else if (verifyResult == FRAGMENT_RETRANSMIT_TIMEOUT) {
-                Hoymiles.getMessageOutput()->println(F("Retransmit timeout"));
-                _commandQueue.pop();
-                _busyFlag = false;
+                HOY_LOG(RADIO, HOY_LOG_LEVEL_WARN, "Retransmit timeout\n");
+                inv->RadioStats()->addTimeout();
+                releaseActiveCommand();
 
             } else if (verifyResult == FRAGMENT_HANDLE_ERROR) {
-                Hoymiles.getMessageOutput()->println(F("Packet handling error"));
-                _commandQueue.pop();
-                _busyFlag = false;
+                HOY_LOG(RADIO, HOY_LOG_LEVEL_WARN, "Packet handling error\n");
+                inv->RadioStats()->addHandleError();
+                releaseActiveCommand();
 
-            } else if (verifyResult > 0) {
+            } else if (verifyResult == FRAGMENT_RETRANSMIT) {
                 // Perform Retransmit
-                Hoymiles.getMessageOutput()->print(F("Request retransmit: "));
-                Hoymiles.getMessageOutput()->println(verifyResult);
-                sendRetransmitPacket(verifyResult);
+                _retransmitMask = missing;
+                sendNextRetransmitPacket();
 
             } else {
                 // Successfull received all packages
-                Hoymiles.getMessageOutput()->println(F("Success"));
-                _commandQueue.pop();
-                _busyFlag = false;
+                HOY_LOG(RADIO, HOY_LOG_LEVEL_DEBUG, "Success\n");
+                inv->RadioStats()->addResponse(millis() - _requestTime);
+                releaseActiveCommand();
             }
         } else {
             // If inverter was not found, assume the command is invalid
-            Hoymiles.getMessageOutput()->println(F("RX: Invalid inverter found"));
-            _commandQueue.pop();
-            _busyFlag = false;
+            HOY_LOG(RADIO, HOY_LOG_LEVEL_WARN, "RX: Invalid inverter found\n");
+            releaseActiveCommand();
+        }
+    }
+
+    // Currently in idle mode --> send packet if one is in the queue
+    while (!_busyFlag) {
+        bool expired;
+        HOY_QUEUE_SEMAPHORE_TAKE();
+        _activeCommand = _scheduler.pop(millis(), expired);
+        HOY_QUEUE_SEMAPHORE_GIVE();
+
+        if (nullptr == _activeCommand) {
+            break;
         }
-    } else if (!_busyFlag) {
-        // Currently in idle mode --> send packet if one is in the queue
-        if (!_commandQueue.empty()) {
-            CommandAbstract* cmd = _commandQueue.front().get();
 
-            auto inv = Hoymiles.getInverterBySerial(cmd->getTargetAddress());
+        auto inv = Hoymiles.getInverterBySerial(_activeCommand->getTargetAddress());
+        if (expired) {
+            HOY_LOG(RADIO, HOY_LOG_LEVEL_WARN, "TX: Deadline passed, dropped %s\n", _activeCommand->getCommandName().c_str());
             if (nullptr != inv) {
-                inv->clearRxFragmentBuffer();
-                sendEsbPacket(cmd);
-            } else {
-                Hoymiles.getMessageOutput()->println(F("TX: Invalid inverter found"));
-                _commandQueue.pop();
+                _activeCommand->gotTimeout(inv.get());
             }
+            releaseActiveCommand();
+        } else if (nullptr != inv) {
+            _activeInverter = inv;
+            inv->clearRxFragmentBuffer();
+            inv->RadioStats()->addRequest();
+            _requestTime = millis();
+            sendEsbPacket(_activeCommand);
+        } else {
+            HOY_LOG(RADIO, HOY_LOG_LEVEL_WARN, "TX: Invalid inverter found\n");
+            releaseActiveCommand();
         }
     }
 }
 
+void HoymilesRadio::enqueCommand(CommandAbstract* cmd)
+{
+    HOY_QUEUE_SEMAPHORE_TAKE();
+    _scheduler.push(cmd, millis());
+    HOY_QUEUE_SEMAPHORE_GIVE();
+
+    xTaskNotify(_taskHandle, HOY_RADIO_EVENT_COMMAND, eSetBits);
+}
+
 void HoymilesRadio::setPALevel(rf24_pa_dbm_e paLevel)
 {
+    HOY_RADIO_SEMAPHORE_TAKE();
     _radio->setPALevel(paLevel);
+    HOY_RADIO_SEMAPHORE_GIVE();
 }
 
 serial_u HoymilesRadio::DtuSerial()
@@ -161,8 +252,10 @@ serial_u HoymilesRadio::DtuSerial()
 
 void HoymilesRadio::setDtuSerial(uint64_t serial)
 {
+    HOY_RADIO_SEMAPHORE_TAKE();
     _dtuSerial.u64 = serial;
     openReadingPipe();
+    HOY_RADIO_SEMAPHORE_GIVE();
 }
 
 bool HoymilesRadio::isIdle()
@@ -172,12 +265,76 @@ bool HoymilesRadio::isIdle()
 
 bool HoymilesRadio::isConnected()
 {
-    return _radio->isChipConnected();
+    HOY_RADIO_SEMAPHORE_TAKE();
+    bool connected = _radio->isChipConnected();
+    HOY_RADIO_SEMAPHORE_GIVE();
+    return connected;
 }
 
 bool HoymilesRadio::isPVariant()
 {
-    return _radio->isPVariant();
+    HOY_RADIO_SEMAPHORE_TAKE();
+    bool pVariant = _radio->isPVariant();
+    HOY_RADIO_SEMAPHORE_GIVE();
+    return pVariant;
+}
+
+uint32_t HoymilesRadio::getRxBufferFlushCount()
+{
+    return _rxBufferFlushCount;
+}
+
+uint32_t HoymilesRadio::getCrcErrorCount()
+{
+    return _crcErrorCount;
+}
+
+uint32_t HoymilesRadio::getUnknownInverterCount()
+{
+    return _unknownInverterCount;
+}
+
+void HoymilesRadio::getSchedulerStatistics(CommandPriority priority, CommandSchedulerStatistics& stats)
+{
+    HOY_QUEUE_SEMAPHORE_TAKE();
+    _scheduler.getStatistics(priority, stats);
+    HOY_QUEUE_SEMAPHORE_GIVE();
+}
+
+void HoymilesRadio::getAirtimeStatistics(CommandType type, CommandAirtimeStatistics& stats)
+{
+    HOY_RADIO_SEMAPHORE_TAKE();
+    stats = _airtime[type];
+    HOY_RADIO_SEMAPHORE_GIVE();
+}
+
+uint32_t HoymilesRadio::getAirtime(CommandType type)
+{
+    HOY_RADIO_SEMAPHORE_TAKE();
+    uint32_t airtime = _airtime[type].commands > 0 ? _airtime[type].average >> HOY_AIRTIME_SHIFT : HOY_AIRTIME_DEFAULT;
+    HOY_RADIO_SEMAPHORE_GIVE();
+    return airtime;
+}
+
+bool HoymilesRadio::isQueueEmpty()
+{
+    HOY_QUEUE_SEMAPHORE_TAKE();
+    bool empty = _scheduler.empty();
+    HOY_QUEUE_SEMAPHORE_GIVE();
+    return empty;
+}
+
+void HoymilesRadio::addAirtime(CommandType type, uint32_t airtime)
+{
+    CommandAirtimeStatistics& a = _airtime[type];
+    if (a.commands++ == 0) {
+        a.average = airtime << HOY_AIRTIME_SHIFT;
+    } else {
+        a.average += airtime - (a.average >> HOY_AIRTIME_SHIFT);
+    }
+    if (airtime > a.max) {
+        a.max = airtime;
+    }
 }
 
 void HoymilesRadio::openReadingPipe()
@@ -196,27 +353,25 @@ void HoymilesRadio::openWritingPipe(serial_u serial)
 
 void ARDUINO_ISR_ATTR HoymilesRadio::handleIntr()
 {
-    _packetReceived = true;
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    xTaskNotifyFromISR(_taskHandle, HOY_RADIO_EVENT_IRQ, eSetBits, &xHigherPriorityTaskWoken);
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
 }
 
-uint8_t HoymilesRadio::getRxNxtChannel()
+void HoymilesRadio::switchRxCh()
 {
-    if (++_rxChIdx >= sizeof(_rxChLst))
-        _rxChIdx = 0;
-    return _rxChLst[_rxChIdx];
-}
+    if (nullptr != _activeInverter) {
+        _activeInverter->RadioStats()->addRxDwell(_rxChIdx, _rxHit);
+    }
+    _rxHit = false;
 
-uint8_t HoymilesRadio::getTxNxtChannel()
-{
-    if (++_txChIdx >= sizeof(_txChLst))
-        _txChIdx = 0;
-    return _txChLst[_txChIdx];
-}
+    if (++_rxHopPos >= HOY_CHANNEL_COUNT) {
+        _rxHopPos = 0;
+    }
+    _rxChIdx = _rxHopOrder[_rxHopPos];
 
-void HoymilesRadio::switchRxCh()
-{
     _radio->stopListening();
-    _radio->setChannel(getRxNxtChannel());
+    _radio->setChannel(RadioStatistics::getChannel(_rxChIdx));
     _radio->startListening();
 }
 
@@ -244,55 +399,85 @@ void HoymilesRadio::sendEsbPacket(CommandAbstract* cmd)
 
     cmd->setRouterAddress(DtuSerial().u64);
 
+    RadioStatistics* stats = _activeInverter->RadioStats();
+    uint8_t txChIdx = stats->getTxChannelIdx();
+
     _radio->stopListening();
-    _radio->setChannel(getTxNxtChannel());
+    _radio->setChannel(RadioStatistics::getChannel(txChIdx));
 
     serial_u s;
     s.u64 = cmd->getTargetAddress();
     openWritingPipe(s);
     _radio->setRetries(3, 15);
 
-    Hoymiles.getMessageOutput()->print(F("TX "));
-    Hoymiles.getMessageOutput()->print(cmd->getCommandName());
-    Hoymiles.getMessageOutput()->print(F(" Channel: "));
-    Hoymiles.getMessageOutput()->print(_radio->getChannel());
-    Hoymiles.getMessageOutput()->print(F(" --> "));
-    cmd->dumpDataPayload(Hoymiles.getMessageOutput());
-    _radio->write(cmd->getDataPayload(), cmd->getDataSize());
+    HOY_LOG(RADIO, HOY_LOG_LEVEL_DEBUG, "TX %s Channel: %d --> %s\n",
+        cmd->getCommandName().c_str(), RadioStatistics::getChannel(txChIdx),
+        hoyFormatHex(_logBuffer, sizeof(_logBuffer), cmd->getDataPayload(), cmd->getDataSize()));
+    stats->addTx(txChIdx, _radio->write(cmd->getDataPayload(), cmd->getDataSize()));
 
     _radio->setRetries(0, 0);
     openReadingPipe();
-    _radio->setChannel(getRxNxtChannel());
+
+    stats->getRxHopOrder(_rxHopOrder);
+    _rxHopPos = 0;
+    _rxChIdx = _rxHopOrder[0];
+    _rxHit = false;
+    _radio->setChannel(RadioStatistics::getChannel(_rxChIdx));
     _radio->startListening();
     _busyFlag = true;
-    _rxTimeout.set(cmd->getTimeout());
+    if (cmd == _activeCommand && cmd->getSendCount() == 1) {
+        // Only the first transmission of a request is a valid round trip sample (Karn's algorithm).
+        // Resends fall back to the full timeout of the command in case the adaptive one was too short.
+        _rttValid = true;
+        _txTime = millis();
+        _rxTimeout.set(stats->getRxTimeout(cmd->getCommandType(), cmd->getTimeout()));
+    } else {
+        _rttValid = false;
+        _rxTimeout.set(cmd->getTimeout());
+    }
+    _rxChSwitchTimeout.set(HOY_RADIO_CHANNEL_SWITCH_PERIOD);
 }
 
-void HoymilesRadio::sendRetransmitPacket(uint8_t fragment_id)
+void HoymilesRadio::sendNextRetransmitPacket()
 {
-    CommandAbstract* cmd = _commandQueue.front().get();
+    // Lowest fragment id first
+    uint8_t fragmentId = __builtin_ctz(_retransmitMask) + 1;
+    _retransmitMask &= ~(1 << (fragmentId - 1));
 
-    CommandAbstract* requestCmd = cmd->getRequestFrameCommand(fragment_id);
+    CommandAbstract* requestCmd = _activeCommand->getRequestFrameCommand(fragmentId);
 
     if (requestCmd != nullptr) {
+        HOY_LOG(RADIO, HOY_LOG_LEVEL_INFO, "Request retransmit: %d\n", fragmentId);
+        _retransmitFragment = fragmentId;
+        _retransmitTime = millis();
+        _activeInverter->RadioStats()->addRetransmit(fragmentId);
         sendEsbPacket(requestCmd);
+    } else {
+        _retransmitMask = 0;
     }
 }
 
 void HoymilesRadio::sendLastPacketAgain()
 {
-    CommandAbstract* cmd = _commandQueue.front().get();
-    sendEsbPacket(cmd);
+    _retransmitMask = 0;
+    _retransmitFragment = 0;
+    sendEsbPacket(_activeCommand);
 }
 
-void HoymilesRadio::dumpBuf(const char* info, uint8_t buf[], uint8_t len)
+void HoymilesRadio::releaseActiveCommand()
 {
+    // Commands which expired in the queue never occupied the radio
+    if (_busyFlag) {
+        addAirtime(_activeCommand->getCommandType(), millis() - _requestTime);
 
-    if (NULL != info)
-        Hoymiles.getMessageOutput()->print(String(info));
-
-    for (uint8_t i = 0; i < len; i++) {
-        Hoymiles.getMessageOutput()->printf("%02X ", buf[i]);
+        // The last rx window ends here, usually the one which completed the response
+        _activeInverter->RadioStats()->addRxDwell(_rxChIdx, _rxHit);
     }
-    Hoymiles.getMessageOutput()->println(F(""));
+
+    _retransmitMask = 0;
+    _retransmitFragment = 0;
+    CommandPoolBase::release(_activeCommand);
+    _activeCommand = nullptr;
+    _activeInverter.reset();
+    _busyFlag = false;
 }
\ No newline at end of file
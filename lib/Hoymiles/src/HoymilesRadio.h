@@ -1,21 +1,46 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 #pragma once
 
+#include "CommandScheduler.h"
+#include "RadioStatistics.h"
+#include "RingBuffer.h"
 #include "TimeoutHelper.h"
 #include "commands/CommandAbstract.h"
+#include "commands/CommandPool.h"
 #include "types.h"
 #include <RF24.h>
+#include <atomic>
 #include <memory>
 #include <nRF24L01.h>
-#include <queue>
 
-// number of fragments hold in buffer
-#define FRAGMENT_BUFFER_SIZE 30
+// number of fragments hold in buffer, has to be a power of two
+#define FRAGMENT_BUFFER_SIZE 32
+
+#define HOY_RADIO_TASK_STACK_SIZE 4096
+#define HOY_RADIO_TASK_PRIORITY 3 // above the arduino loop task
+#define HOY_RADIO_TASK_CORE 1
+#define HOY_RADIO_CHANNEL_SWITCH_PERIOD 4 // ms, rx channel hopping while waiting for a response
+
+#define HOY_AIRTIME_DEFAULT 250 // ms, expected duration of a command type until it was measured
+#define HOY_AIRTIME_SHIFT 3 // weight of a new airtime sample is 1/8
+
+// task notification bits
+#define HOY_RADIO_EVENT_IRQ (1 << 0)
+#define HOY_RADIO_EVENT_COMMAND (1 << 1)
+
+// Time the radio is occupied by one command, from its first send until it is done
+// including resends and retransmits
+struct CommandAirtimeStatistics {
+    uint32_t commands; // commands of this type which were sent
+    uint32_t average; // ms, moving average scaled by 8
+    uint32_t max; // ms
+};
+
+class InverterAbstract;
 
 class HoymilesRadio {
 public:
     void init(SPIClass* initialisedSpiBus, uint8_t pinCE, uint8_t pinIRQ);
-    void loop();
     void setPALevel(rf24_pa_dbm_e paLevel);
 
     serial_u DtuSerial();
@@ -25,44 +50,77 @@ public:
     bool isConnected();
     bool isPVariant();
 
+    uint32_t getRxBufferFlushCount(); // "Buffer full", the FIFO of the module was dropped
+    uint32_t getCrcErrorCount(); // fragments with a wrong checksum, of all inverters
+    uint32_t getUnknownInverterCount(); // valid fragments from an inverter which is not configured
+    void getSchedulerStatistics(CommandPriority priority, CommandSchedulerStatistics& stats);
+    void getAirtimeStatistics(CommandType type, CommandAirtimeStatistics& stats);
+    uint32_t getAirtime(CommandType type); // ms a command of this type is expected to take
+    bool isQueueEmpty();
+
+    // Commands are taken from a per type pool with prepareCommand(), filled by
+    // the caller and handed over to the radio task with enqueCommand(). The radio
+    // returns them to their pool once they are done.
     template <typename T>
-    T* enqueCommand()
+    T* prepareCommand()
     {
-        _commandQueue.push(std::make_shared<T>());
-        return static_cast<T*>(_commandQueue.back().get());
+        static CommandPool<T, HOY_COMMAND_POOL_SIZE> pool;
+        return pool.alloc();
     }
+    void enqueCommand(CommandAbstract* cmd);
 
 private:
+    static void radioTask(void* parameter);
+    void loop(uint32_t events);
     void ARDUINO_ISR_ATTR handleIntr();
     static serial_u convertSerialToRadioId(serial_u serial);
-    uint8_t getRxNxtChannel();
-    uint8_t getTxNxtChannel();
     void switchRxCh();
     void openReadingPipe();
     void openWritingPipe(serial_u serial);
     bool checkFragmentCrc(fragment_t* fragment);
-    void dumpBuf(const char* info, uint8_t buf[], uint8_t len);
 
     void sendEsbPacket(CommandAbstract* cmd);
-    void sendRetransmitPacket(uint8_t fragment_id);
+    void sendNextRetransmitPacket();
     void sendLastPacketAgain();
+    void releaseActiveCommand();
+    void addAirtime(CommandType type, uint32_t airtime);
 
     std::unique_ptr<SPIClass> _spiPtr;
     std::unique_ptr<RF24> _radio;
-    uint8_t _rxChLst[5] = { 3, 23, 40, 61, 75 };
+    // rx channels are visited in the order of their hit rate for the active inverter
+    uint8_t _rxHopOrder[HOY_CHANNEL_COUNT] = { 0, 1, 2, 3, 4 };
+    uint8_t _rxHopPos = 0;
     uint8_t _rxChIdx = 0;
+    bool _rxHit = false; // a fragment of the active inverter was received on the current rx channel
 
-    uint8_t _txChLst[5] = { 3, 23, 40, 61, 75 };
-    uint8_t _txChIdx = 0;
-
-    volatile bool _packetReceived = false;
+    char _logBuffer[3 * MAX_RF_PAYLOAD_SIZE + 1]; // hex dumps, only formatted if the level is enabled
 
-    std::queue<fragment_t> _rxBuffer;
+    RingBuffer<fragment_t, FRAGMENT_BUFFER_SIZE> _rxBuffer;
     TimeoutHelper _rxTimeout;
+    uint32_t _requestTime = 0; // millis() when the active command was sent the first time
+    uint32_t _txTime = 0; // millis() when the active command was sent
+    bool _rttValid = false; // the active command was sent only once, so its round trip can be measured
+
+    // Missing fragments are requested one after another within one rx period
+    uint16_t _retransmitMask = 0; // bit n set: fragment id n + 1 still has to be requested
+    uint8_t _retransmitFragment = 0; // fragment id currently requested, 0 if none
+    uint32_t _retransmitTime = 0; // millis() when _retransmitFragment was requested
+    TimeoutHelper _rxChSwitchTimeout;
 
     serial_u _dtuSerial;
 
-    bool _busyFlag = false;
+    std::atomic<bool> _busyFlag { false };
+
+    uint32_t _rxBufferFlushCount = 0;
+    uint32_t _crcErrorCount = 0;
+    uint32_t _unknownInverterCount = 0;
+    CommandAirtimeStatistics _airtime[CMD_TYPE_COUNT] = {};
+
+    CommandAbstract* _activeCommand = nullptr; // command waiting for its response, only used by the radio task
+    std::shared_ptr<InverterAbstract> _activeInverter; // target of _activeCommand
+    CommandScheduler _scheduler;
 
-    std::queue<std::shared_ptr<CommandAbstract>> _commandQueue;
+    TaskHandle_t _taskHandle = nullptr;
+    SemaphoreHandle_t _xSemaphore; // protects the RF24 module
+    SemaphoreHandle_t _queueSemaphore; // protects _scheduler
 };
\ No newline at end of file
@@ -0,0 +1,92 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2022 Thomas Basler and others
+ */
+#include "PollPlan.h"
+
+void PollPlan::setStatsInterval(uint32_t interval)
+{
+    _statsInterval = interval;
+}
+
+uint32_t PollPlan::getStatsInterval()
+{
+    return _statsInterval;
+}
+
+void PollPlan::setAlarmLogInterval(uint32_t interval)
+{
+    _alarmLogInterval = interval;
+}
+
+uint32_t PollPlan::getAlarmLogInterval()
+{
+    return _alarmLogInterval;
+}
+
+int32_t PollPlan::getStatsOverdue(uint32_t now, uint32_t interval)
+{
+    // Inverters which were never polled go first
+    if (!_statsPolled) {
+        return INT32_MAX;
+    }
+
+    return static_cast<int32_t>(now - _lastStatsPoll - interval);
+}
+
+bool PollPlan::isAlarmLogDue(uint32_t now)
+{
+    return _alarmLogInterval == 0 || !_alarmLogPolled || now - _lastAlarmLogPoll >= _alarmLogInterval;
+}
+
+void PollPlan::addStatsPoll(uint32_t now)
+{
+    _lastStatsPoll = now;
+    _statsPolled = true;
+    _stats.statsPolls++;
+}
+
+void PollPlan::addAlarmLogPoll(uint32_t now)
+{
+    _lastAlarmLogPoll = now;
+    _alarmLogPolled = true;
+}
+
+void PollPlan::addStatsUpdate(uint32_t now)
+{
+    if (_stats.statsUpdates++ > 0) {
+        uint32_t sample = now - _lastStatsUpdate;
+        if (_stats.interval == 0) {
+            _stats.interval = sample << HOY_POLL_INTERVAL_SHIFT;
+        } else {
+            _stats.interval += sample - (_stats.interval >> HOY_POLL_INTERVAL_SHIFT);
+        }
+    }
+    _lastStatsUpdate = now;
+}
+
+bool PollPlan::deferRequest()
+{
+    if (_deferCount >= HOY_POLL_MAX_DEFER) {
+        return false;
+    }
+
+    _deferCount++;
+    _stats.deferred++;
+    return true;
+}
+
+void PollPlan::resetDeferCount()
+{
+    _deferCount = 0;
+}
+
+const PollStatistics& PollPlan::getStatistics()
+{
+    return _stats;
+}
+
+uint32_t PollPlan::getAchievedInterval()
+{
+    return _stats.interval >> HOY_POLL_INTERVAL_SHIFT;
+}
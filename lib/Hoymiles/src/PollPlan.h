@@ -0,0 +1,55 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <cstdint>
+
+#define HOY_POLL_INTERVAL_SHIFT 3 // weight of a new achieved interval sample is 1/8
+#define HOY_POLL_MAX_DEFER 5 // background requests of an inverter are postponed at most this often in a row
+
+struct PollStatistics {
+    uint32_t statsPolls; // stats requests enqueued
+    uint32_t statsUpdates; // stats responses handled
+    uint32_t deferred; // background requests postponed as they would delay the stats request of another inverter
+    uint32_t interval; // ms between two stats updates, moving average scaled by 8
+};
+
+// When the requests of a single inverter are due and how often it is actually
+// updated. All intervals are in ms. A stats interval of 0 shares the DTU poll
+// interval in turn with all other inverters without an own interval, an alarm
+// log interval of 0 checks the alarm log together with every stats request.
+class PollPlan {
+public:
+    void setStatsInterval(uint32_t interval);
+    uint32_t getStatsInterval();
+    void setAlarmLogInterval(uint32_t interval);
+    uint32_t getAlarmLogInterval();
+
+    // ms since the stats request is due, negative if it is not due yet
+    int32_t getStatsOverdue(uint32_t now, uint32_t interval);
+    bool isAlarmLogDue(uint32_t now);
+
+    void addStatsPoll(uint32_t now);
+    void addAlarmLogPoll(uint32_t now);
+    void addStatsUpdate(uint32_t now);
+
+    // Counts a postponed background request. Returns false if the inverter
+    // already waited HOY_POLL_MAX_DEFER times, the request has to be sent now.
+    bool deferRequest();
+    void resetDeferCount();
+
+    const PollStatistics& getStatistics();
+    uint32_t getAchievedInterval(); // ms, 0 until two updates were received
+
+private:
+    uint32_t _statsInterval = 0;
+    uint32_t _alarmLogInterval = 0;
+
+    uint32_t _lastStatsPoll = 0;
+    uint32_t _lastAlarmLogPoll = 0;
+    uint32_t _lastStatsUpdate = 0;
+    bool _statsPolled = false;
+    bool _alarmLogPolled = false;
+    uint8_t _deferCount = 0;
+
+    PollStatistics _stats = {};
+};
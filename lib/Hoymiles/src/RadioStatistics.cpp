@@ -0,0 +1,200 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2022 Thomas Basler and others
+ */
+#include "RadioStatistics.h"
+
+static const uint8_t channelList[HOY_CHANNEL_COUNT] = HOY_CHANNEL_LIST;
+static const uint32_t latencyBucketBounds[HOY_LATENCY_BUCKET_COUNT - 1] = HOY_LATENCY_BUCKET_BOUNDS;
+
+RadioStatistics::RadioStatistics()
+{
+    // Start optimistic so every channel is tried before it is judged
+    for (uint8_t i = 0; i < HOY_CHANNEL_COUNT; i++) {
+        _channels[i].txRate = HOY_CHANNEL_RATE_ONE;
+        _channels[i].rxRate = HOY_CHANNEL_RATE_ONE;
+    }
+}
+
+uint8_t RadioStatistics::getChannel(uint8_t chIdx)
+{
+    return channelList[chIdx % HOY_CHANNEL_COUNT];
+}
+
+void RadioStatistics::addTx(uint8_t chIdx, bool acked)
+{
+    ChannelStatistics& ch = _channels[chIdx];
+    ch.txCount++;
+    if (acked) {
+        ch.txAcked++;
+    }
+    updateRate(ch.txRate, acked);
+}
+
+void RadioStatistics::addRxDwell(uint8_t chIdx, bool hit)
+{
+    ChannelStatistics& ch = _channels[chIdx];
+    ch.rxDwells++;
+    if (hit) {
+        ch.rxHits++;
+    }
+    updateRate(ch.rxRate, hit);
+}
+
+uint8_t RadioStatistics::getTxChannelIdx()
+{
+    if (++_txRequests % HOY_CHANNEL_EXPLORE_INTERVAL == 0) {
+        _exploreIdx = (_exploreIdx + 1) % HOY_CHANNEL_COUNT;
+        return _exploreIdx;
+    }
+
+    uint8_t best = 0;
+    for (uint8_t i = 1; i < HOY_CHANNEL_COUNT; i++) {
+        if (_channels[i].txRate > _channels[best].txRate) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+void RadioStatistics::getRxHopOrder(uint8_t order[HOY_CHANNEL_COUNT])
+{
+    for (uint8_t i = 0; i < HOY_CHANNEL_COUNT; i++) {
+        order[i] = i;
+    }
+
+    // insertion sort, stable for equal rates
+    for (uint8_t i = 1; i < HOY_CHANNEL_COUNT; i++) {
+        uint8_t idx = order[i];
+        int8_t j = i - 1;
+        while (j >= 0 && _channels[order[j]].rxRate < _channels[idx].rxRate) {
+            order[j + 1] = order[j];
+            j--;
+        }
+        order[j + 1] = idx;
+    }
+}
+
+const ChannelStatistics& RadioStatistics::getChannelStatistics(uint8_t chIdx)
+{
+    return _channels[chIdx];
+}
+
+void RadioStatistics::addRoundTrip(CommandType type, uint32_t rtt)
+{
+    LatencyStatistics& l = _latency[type];
+
+    if (l.samples++ == 0) {
+        l.srtt = rtt << 3;
+        l.rttvar = rtt << 1;
+        return;
+    }
+
+    int32_t delta = static_cast<int32_t>(rtt) - static_cast<int32_t>(l.srtt >> 3);
+    l.srtt += delta;
+    if (delta < 0) {
+        delta = -delta;
+    }
+    l.rttvar += delta - static_cast<int32_t>(l.rttvar >> 2);
+}
+
+uint32_t RadioStatistics::getRxTimeout(CommandType type, uint32_t maxTimeout)
+{
+    const LatencyStatistics& l = _latency[type];
+    if (l.samples < HOY_RX_TIMEOUT_MIN_SAMPLES) {
+        return maxTimeout;
+    }
+
+    uint32_t timeout = (l.srtt >> 3) + l.rttvar;
+    if (timeout < HOY_RX_TIMEOUT_MIN) {
+        timeout = HOY_RX_TIMEOUT_MIN;
+    }
+    if (timeout > maxTimeout) {
+        timeout = maxTimeout;
+    }
+    return timeout;
+}
+
+void RadioStatistics::addRetransmit(uint8_t fragmentId)
+{
+    _link.retransmits++;
+    _fragments[(fragmentId - 1) % MAX_RF_FRAGMENT_COUNT].retransmits++;
+}
+
+void RadioStatistics::addRecovered(uint8_t fragmentId, uint32_t latency)
+{
+    FragmentStatistics& f = _fragments[(fragmentId - 1) % MAX_RF_FRAGMENT_COUNT];
+    f.recovered++;
+    f.latencySum += latency;
+}
+
+const FragmentStatistics& RadioStatistics::getFragmentStatistics(uint8_t fragmentId)
+{
+    return _fragments[(fragmentId - 1) % MAX_RF_FRAGMENT_COUNT];
+}
+
+void RadioStatistics::addRequest()
+{
+    _link.requests++;
+}
+
+void RadioStatistics::addResponse(uint32_t latency)
+{
+    uint8_t bucket = 0;
+    while (bucket < HOY_LATENCY_BUCKET_COUNT - 1 && latency > latencyBucketBounds[bucket]) {
+        bucket++;
+    }
+
+    _link.responses++;
+    _link.latencyBuckets[bucket]++;
+    _link.latencySum += latency;
+}
+
+void RadioStatistics::addResend()
+{
+    _link.resends++;
+}
+
+void RadioStatistics::addCrcError()
+{
+    _link.crcErrors++;
+}
+
+void RadioStatistics::addHandleError()
+{
+    _link.handleErrors++;
+}
+
+void RadioStatistics::addTimeout()
+{
+    _link.timeouts++;
+}
+
+const LinkStatistics& RadioStatistics::getLinkStatistics()
+{
+    return _link;
+}
+
+uint32_t RadioStatistics::getLatencyBucketBound(uint8_t bucket)
+{
+    if (bucket >= HOY_LATENCY_BUCKET_COUNT - 1) {
+        return UINT32_MAX;
+    }
+    return latencyBucketBounds[bucket];
+}
+
+uint32_t RadioStatistics::getSmoothedRoundTrip(CommandType type)
+{
+    return _latency[type].srtt >> 3;
+}
+
+uint32_t RadioStatistics::getRoundTripVariation(CommandType type)
+{
+    return _latency[type].rttvar >> 2;
+}
+
+void RadioStatistics::updateRate(uint16_t& rate, bool success)
+{
+    int32_t sample = success ? HOY_CHANNEL_RATE_ONE : 0;
+    rate = rate + ((sample - rate) >> HOY_CHANNEL_RATE_SHIFT);
+}
@@ -0,0 +1,111 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "commands/CommandAbstract.h"
+#include "types.h"
+#include <cstdint>
+
+// channels used by the inverters for tx and rx
+#define HOY_CHANNEL_COUNT 5
+#define HOY_CHANNEL_LIST { 3, 23, 40, 61, 75 }
+
+#define HOY_CHANNEL_RATE_ONE 1024 // fixed point 1.0 of the success rates
+#define HOY_CHANNEL_RATE_SHIFT 3 // weight of a new sample is 1/8
+#define HOY_CHANNEL_EXPLORE_INTERVAL 8 // every n-th request is sent on the next channel in turn
+
+// upper bounds of the request to response latency histogram in ms, the last bucket has none
+#define HOY_LATENCY_BUCKET_COUNT 8
+#define HOY_LATENCY_BUCKET_BOUNDS { 50, 100, 200, 500, 1000, 2000, 5000 }
+
+#define HOY_RX_TIMEOUT_MIN 50 // ms, lower bound of the adaptive rx timeout
+#define HOY_RX_TIMEOUT_MIN_SAMPLES 4 // round trips measured before the timeout adapts
+
+struct ChannelStatistics {
+    uint32_t txCount; // requests sent on the channel
+    uint32_t txAcked; // requests acknowledged by the inverter
+    uint32_t rxDwells; // rx windows spent on the channel while waiting for a response
+    uint32_t rxHits; // rx windows in which a fragment of the inverter was received
+    uint16_t txRate; // moving average of the ack ratio, HOY_CHANNEL_RATE_ONE is 100 %
+    uint16_t rxRate; // moving average of the hit ratio
+};
+
+// Round trip time from sending a request until its last fragment was received,
+// smoothed like the TCP retransmission timer (RFC 6298)
+struct LatencyStatistics {
+    uint32_t samples;
+    uint32_t srtt; // ms, scaled by 8
+    uint32_t rttvar; // ms, scaled by 4
+};
+
+// Retransmit requests per fragment position of a response
+struct FragmentStatistics {
+    uint32_t retransmits; // fragment was requested again
+    uint32_t recovered; // requested fragment was received
+    uint32_t latencySum; // ms from the request until the fragment was received, sum over all recovered
+};
+
+// Counters of the whole request / response exchange with a single inverter
+struct LinkStatistics {
+    uint32_t requests; // requests sent, not counting resends
+    uint32_t responses; // complete responses handled successfully
+    uint32_t resends; // whole request sent again as nothing was received
+    uint32_t retransmits; // single fragments requested again
+    uint32_t crcErrors; // fragments with a wrong checksum (if the address could still be matched)
+    uint32_t handleErrors; // complete responses which could not be handled
+    uint32_t timeouts; // requests given up after all resends or retransmits
+    uint32_t latencyBuckets[HOY_LATENCY_BUCKET_COUNT]; // responses by time from the request, not cumulative
+    uint32_t latencySum; // ms
+};
+
+// Link quality of a single inverter per channel. The moving averages let a
+// channel recover after a bad period, exploration makes sure it gets the chance.
+class RadioStatistics {
+public:
+    RadioStatistics();
+
+    static uint8_t getChannel(uint8_t chIdx);
+
+    void addTx(uint8_t chIdx, bool acked);
+    void addRxDwell(uint8_t chIdx, bool hit);
+
+    // channel for the next request, usually the best one
+    uint8_t getTxChannelIdx();
+
+    // all channels ordered by their rx hit rate, best first
+    void getRxHopOrder(uint8_t order[HOY_CHANNEL_COUNT]);
+
+    const ChannelStatistics& getChannelStatistics(uint8_t chIdx);
+
+    // per command type, the responses of the types differ in their number of fragments
+    void addRoundTrip(CommandType type, uint32_t rtt);
+
+    // rx timeout for a request, maxTimeout until enough round trips were measured
+    uint32_t getRxTimeout(CommandType type, uint32_t maxTimeout);
+
+    // fragmentId starts at 1 like in the response
+    void addRetransmit(uint8_t fragmentId);
+    void addRecovered(uint8_t fragmentId, uint32_t latency);
+    const FragmentStatistics& getFragmentStatistics(uint8_t fragmentId);
+
+    void addRequest();
+    void addResponse(uint32_t latency);
+    void addResend();
+    void addCrcError();
+    void addHandleError();
+    void addTimeout();
+    const LinkStatistics& getLinkStatistics();
+    static uint32_t getLatencyBucketBound(uint8_t bucket); // ms, UINT32_MAX for the last bucket
+
+    uint32_t getSmoothedRoundTrip(CommandType type); // ms
+    uint32_t getRoundTripVariation(CommandType type); // ms
+
+private:
+    static void updateRate(uint16_t& rate, bool success);
+
+    ChannelStatistics _channels[HOY_CHANNEL_COUNT] = {};
+    LatencyStatistics _latency[CMD_TYPE_COUNT] = {};
+    FragmentStatistics _fragments[MAX_RF_FRAGMENT_COUNT] = {};
+    LinkStatistics _link = {};
+    uint32_t _txRequests = 0;
+    uint8_t _exploreIdx = 0;
+};
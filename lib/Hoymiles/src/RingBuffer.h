@@ -0,0 +1,81 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#define RING_BUFFER_PADDING 32 // keeps producer and consumer index in different cache lines
+
+// Fixed size single producer / single consumer queue without locks and heap usage.
+// The producer fills a slot in place with reserve() and publishes it with commit(),
+// the consumer reads the oldest slot with front() and releases it with pop().
+template <typename T, size_t N>
+class RingBuffer {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "RingBuffer size has to be a power of two");
+
+public:
+    // producer side
+    T* reserve()
+    {
+        uint32_t head = _head.load(std::memory_order_relaxed);
+        if (head - _tail.load(std::memory_order_acquire) >= N) {
+            return nullptr;
+        }
+        return &_buffer[head & (N - 1)];
+    }
+
+    void commit()
+    {
+        _head.store(_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    bool push(const T& item)
+    {
+        T* slot = reserve();
+        if (slot == nullptr) {
+            return false;
+        }
+        *slot = item;
+        commit();
+        return true;
+    }
+
+    // consumer side
+    T* front()
+    {
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _head.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &_buffer[tail & (N - 1)];
+    }
+
+    void pop()
+    {
+        _tail.store(_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    bool empty() const
+    {
+        return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);
+    }
+
+    size_t size() const
+    {
+        return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+    }
+
+    static constexpr size_t capacity()
+    {
+        return N;
+    }
+
+private:
+    // Padding instead of alignas() as the owning objects are created with plain new
+    std::atomic<uint32_t> _head { 0 }; // written by the producer only
+    uint8_t _padHead[RING_BUFFER_PADDING - sizeof(uint32_t)];
+    std::atomic<uint32_t> _tail { 0 }; // written by the consumer only
+    uint8_t _padTail[RING_BUFFER_PADDING - sizeof(uint32_t)];
+    T _buffer[N];
+};
@@ -44,9 +44,9 @@ void ActivePowerControlCommand::setActivePowerLimit(float limit, PowerLimitContr
     udpateCRC(CRC_SIZE);
 }
 
-bool ActivePowerControlCommand::handleResponse(InverterAbstract* inverter, fragment_t fragment[], uint8_t max_fragment_id)
+bool ActivePowerControlCommand::handleResponse(InverterAbstract* inverter, const response_t& response)
 {
-    if (!DevControlCommand::handleResponse(inverter, fragment, max_fragment_id)) {
+    if (!DevControlCommand::handleResponse(inverter, response)) {
         return false;
     }
 
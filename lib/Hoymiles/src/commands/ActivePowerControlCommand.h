@@ -16,7 +16,7 @@ public:
 
     virtual String getCommandName();
 
-    virtual bool handleResponse(InverterAbstract* inverter, fragment_t fragment[], uint8_t max_fragment_id);
+    virtual bool handleResponse(InverterAbstract* inverter, const response_t& response);
     virtual void gotTimeout(InverterAbstract* inverter);
 
     void setActivePowerLimit(float limit, PowerLimitControlType type = RelativNonPersistent);
@@ -18,20 +18,18 @@ String AlarmDataCommand::getCommandName()
     return "AlarmData";
 }
 
-bool AlarmDataCommand::handleResponse(InverterAbstract* inverter, fragment_t fragment[], uint8_t max_fragment_id)
+bool AlarmDataCommand::handleResponse(InverterAbstract* inverter, const response_t& response)
 {
     // Check CRC of whole payload
-    if (!MultiDataCommand::handleResponse(inverter, fragment, max_fragment_id)) {
+    if (!MultiDataCommand::handleResponse(inverter, response)) {
         return false;
     }
 
-    // Move all fragments into target buffer
-    uint8_t offs = 0;
+    // Copy the reassembled payload into target buffer
+    inverter->EventLog()->beginAppendFragment();
     inverter->EventLog()->clearBuffer();
-    for (uint8_t i = 0; i < max_fragment_id; i++) {
-        inverter->EventLog()->appendFragment(offs, fragment[i].fragment, fragment[i].len);
-        offs += (fragment[i].len);
-    }
+    inverter->EventLog()->appendFragment(0, response.payload, response.len);
+    inverter->EventLog()->endAppendFragment();
     inverter->EventLog()->setLastAlarmRequestSuccess(CMD_OK);
     inverter->EventLog()->setLastUpdate(millis());
     return true;
@@ -40,4 +38,9 @@ bool AlarmDataCommand::handleResponse(InverterAbstract* inverter, fragment_t fra
 void AlarmDataCommand::gotTimeout(InverterAbstract* inverter)
 {
     inverter->EventLog()->setLastAlarmRequestSuccess(CMD_NOK);
+}
+
+CommandType AlarmDataCommand::getCommandType()
+{
+    return CMD_TYPE_ALARM_LOG;
 }
\ No newline at end of file
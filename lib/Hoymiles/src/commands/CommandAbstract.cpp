@@ -88,6 +88,54 @@ CommandAbstract* CommandAbstract::getRequestFrameCommand(uint8_t frame_no)
     return nullptr;
 }
 
+CommandPriority CommandAbstract::getPriority()
+{
+    return CMD_PRIORITY_BACKGROUND;
+}
+
+CommandType CommandAbstract::getCommandType()
+{
+    return CMD_TYPE_OTHER;
+}
+
+bool CommandAbstract::isDuplicateOf(CommandAbstract* other)
+{
+    // Main command and sub command (data type or control type) are identical
+    return getTargetAddress() == other->getTargetAddress()
+        && _payload[0] == other->_payload[0]
+        && _payload[10] == other->_payload[10];
+}
+
+void CommandAbstract::setQueueTime(uint32_t time)
+{
+    _queueTime = time;
+}
+
+uint32_t CommandAbstract::getQueueTime()
+{
+    return _queueTime;
+}
+
+void CommandAbstract::setDeadline(uint32_t deadline)
+{
+    _deadline = deadline;
+}
+
+uint32_t CommandAbstract::getDeadline()
+{
+    return _deadline;
+}
+
+void CommandAbstract::setPool(CommandPoolBase* pool)
+{
+    _pool = pool;
+}
+
+CommandPoolBase* CommandAbstract::getPool()
+{
+    return _pool;
+}
+
 void CommandAbstract::convertSerialToPacketId(uint8_t buffer[], uint64_t serial)
 {
     serial_u s;
@@ -7,7 +7,27 @@
 
 #define RF_LEN 32
 
+// the radio serves the classes in this order
+enum CommandPriority {
+    CMD_PRIORITY_CONTROL = 0, // limit and power commands
+    CMD_PRIORITY_STATS, // real time data
+    CMD_PRIORITY_BACKGROUND, // alarm log, device info, system config
+    CMD_PRIORITY_COUNT
+};
+
+// the poll planning measures and predicts the airtime per type
+enum CommandType {
+    CMD_TYPE_CONTROL = 0, // limit and power commands
+    CMD_TYPE_STATS,
+    CMD_TYPE_ALARM_LOG,
+    CMD_TYPE_DEV_INFO,
+    CMD_TYPE_SYSTEM_CONFIG,
+    CMD_TYPE_OTHER,
+    CMD_TYPE_COUNT
+};
+
 class InverterAbstract;
+class CommandPoolBase;
 
 class CommandAbstract {
 public:
@@ -36,9 +56,25 @@ public:
 
     virtual CommandAbstract* getRequestFrameCommand(uint8_t frame_no);
 
-    virtual bool handleResponse(InverterAbstract* inverter, fragment_t fragment[], uint8_t max_fragment_id) = 0;
+    virtual bool handleResponse(InverterAbstract* inverter, const response_t& response) = 0;
     virtual void gotTimeout(InverterAbstract* inverter);
 
+    virtual CommandPriority getPriority();
+    virtual CommandType getCommandType();
+
+    // true if both commands request the same data or action from the same inverter
+    bool isDuplicateOf(CommandAbstract* other);
+
+    void setQueueTime(uint32_t time);
+    uint32_t getQueueTime();
+
+    // ms a command may wait in the queue, 0 uses the default of its priority class
+    void setDeadline(uint32_t deadline);
+    uint32_t getDeadline();
+
+    void setPool(CommandPoolBase* pool);
+    CommandPoolBase* getPool();
+
 protected:
     uint8_t _payload[RF_LEN];
     uint8_t _payload_size;
@@ -48,6 +84,14 @@ protected:
     uint64_t _targetAddress;
     uint64_t _routerAddress;
 
+    uint32_t _queueTime = 0;
+    uint32_t _deadline = 0;
+
 private:
     void convertSerialToPacketId(uint8_t buffer[], uint64_t serial);
+
+    CommandPoolBase* _pool = nullptr; // pool the command was taken from, nullptr if created on the heap
+
+    friend class CommandQueue;
+    CommandAbstract* _next = nullptr; // intrusive link used by CommandQueue
 };
\ No newline at end of file
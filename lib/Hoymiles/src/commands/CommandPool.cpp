@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2022 Thomas Basler and others
+ */
+#include "CommandPool.h"
+
+std::atomic<uint32_t> CommandPoolBase::_poolAllocations(0);
+std::atomic<uint32_t> CommandPoolBase::_heapAllocations(0);
+std::atomic<uint32_t> CommandPoolBase::_inUse(0);
+std::atomic<uint32_t> CommandPoolBase::_maxInUse(0);
+
+void CommandPoolBase::release(CommandAbstract* cmd)
+{
+    if (cmd == nullptr) {
+        return;
+    }
+
+    CommandPoolBase* pool = cmd->getPool();
+    if (pool != nullptr) {
+        pool->releaseSlot(cmd);
+    } else {
+        delete cmd;
+    }
+    _inUse--;
+}
+
+void CommandPoolBase::getStatistics(CommandPoolStatistics& stats)
+{
+    stats.poolAllocations = _poolAllocations;
+    stats.heapAllocations = _heapAllocations;
+    stats.inUse = _inUse;
+    stats.maxInUse = _maxInUse;
+}
+
+void CommandPoolBase::countAllocation(bool fromPool)
+{
+    if (fromPool) {
+        _poolAllocations++;
+    } else {
+        _heapAllocations++;
+    }
+
+    uint32_t inUse = ++_inUse;
+    uint32_t maxInUse = _maxInUse;
+    while (inUse > maxInUse && !_maxInUse.compare_exchange_weak(maxInUse, inUse)) { }
+}
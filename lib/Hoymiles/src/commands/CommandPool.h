@@ -0,0 +1,92 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "CommandAbstract.h"
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <new>
+#include <type_traits>
+
+// number of commands of each type which can be pending without using the heap
+#define HOY_COMMAND_POOL_SIZE 8
+
+struct CommandPoolStatistics {
+    uint32_t poolAllocations; // commands taken from a pool
+    uint32_t heapAllocations; // commands created on the heap because their pool was exhausted
+    uint32_t inUse; // commands currently allocated
+    uint32_t maxInUse;
+};
+
+class CommandPoolBase {
+public:
+    virtual ~CommandPoolBase() {};
+
+    // Returns a command to its pool or deletes it if it was created on the heap
+    static void release(CommandAbstract* cmd);
+
+    static void getStatistics(CommandPoolStatistics& stats);
+
+protected:
+    virtual void releaseSlot(CommandAbstract* cmd) = 0;
+
+    static void countAllocation(bool fromPool);
+
+private:
+    static std::atomic<uint32_t> _poolAllocations;
+    static std::atomic<uint32_t> _heapAllocations;
+    static std::atomic<uint32_t> _inUse;
+    static std::atomic<uint32_t> _maxInUse;
+};
+
+// Preallocated storage for N commands of type T. Every allocation constructs a
+// fresh command in a free slot, so reused commands start from their default state.
+template <typename T, size_t N>
+class CommandPool : public CommandPoolBase {
+    static_assert(N <= 32, "CommandPool uses a 32 bit mask for its slots");
+
+public:
+    T* alloc()
+    {
+        T* cmd = nullptr;
+
+        portENTER_CRITICAL(&_mux);
+        for (uint8_t i = 0; i < N; i++) {
+            if (!(_used & (1UL << i))) {
+                _used |= (1UL << i);
+                cmd = reinterpret_cast<T*>(&_storage[i]);
+                break;
+            }
+        }
+        portEXIT_CRITICAL(&_mux);
+
+        if (cmd != nullptr) {
+            new (cmd) T();
+            cmd->setPool(this);
+        } else {
+            cmd = new T();
+        }
+        countAllocation(cmd->getPool() != nullptr);
+
+        return cmd;
+    }
+
+protected:
+    void releaseSlot(CommandAbstract* cmd)
+    {
+        T* slot = static_cast<T*>(cmd);
+        size_t i = reinterpret_cast<Storage*>(slot) - _storage;
+
+        slot->~T();
+
+        portENTER_CRITICAL(&_mux);
+        _used &= ~(1UL << i);
+        portEXIT_CRITICAL(&_mux);
+    }
+
+private:
+    typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type Storage;
+
+    Storage _storage[N];
+    uint32_t _used = 0;
+    portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+};
@@ -0,0 +1,95 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2022 Thomas Basler and others
+ */
+#include "CommandQueue.h"
+
+void CommandQueue::push(CommandAbstract* cmd)
+{
+    cmd->_next = nullptr;
+    if (_tail != nullptr) {
+        _tail->_next = cmd;
+    } else {
+        _head = cmd;
+    }
+    _tail = cmd;
+    _size++;
+}
+
+CommandAbstract* CommandQueue::pop()
+{
+    CommandAbstract* cmd = _head;
+    if (cmd != nullptr) {
+        _head = cmd->_next;
+        if (_head == nullptr) {
+            _tail = nullptr;
+        }
+        cmd->_next = nullptr;
+        _size--;
+    }
+    return cmd;
+}
+
+CommandAbstract* CommandQueue::front()
+{
+    return _head;
+}
+
+CommandAbstract* CommandQueue::next(CommandAbstract* cmd)
+{
+    return cmd->_next;
+}
+
+void CommandQueue::remove(CommandAbstract* cmd)
+{
+    CommandAbstract* prev = nullptr;
+    for (CommandAbstract* c = _head; c != nullptr; prev = c, c = c->_next) {
+        if (c != cmd) {
+            continue;
+        }
+
+        if (prev != nullptr) {
+            prev->_next = c->_next;
+        } else {
+            _head = c->_next;
+        }
+        if (_tail == c) {
+            _tail = prev;
+        }
+        c->_next = nullptr;
+        _size--;
+        return;
+    }
+}
+
+void CommandQueue::replace(CommandAbstract* oldCmd, CommandAbstract* newCmd)
+{
+    CommandAbstract* prev = nullptr;
+    for (CommandAbstract* c = _head; c != nullptr; prev = c, c = c->_next) {
+        if (c != oldCmd) {
+            continue;
+        }
+
+        newCmd->_next = c->_next;
+        if (prev != nullptr) {
+            prev->_next = newCmd;
+        } else {
+            _head = newCmd;
+        }
+        if (_tail == c) {
+            _tail = newCmd;
+        }
+        c->_next = nullptr;
+        return;
+    }
+}
+
+bool CommandQueue::empty()
+{
+    return _head == nullptr;
+}
+
+size_t CommandQueue::size()
+{
+    return _size;
+}
@@ -0,0 +1,26 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "CommandAbstract.h"
+#include <cstddef>
+
+// FIFO of commands linked through the commands themselves, needs no allocation.
+// Not thread safe, a command can only be part of one queue at a time.
+class CommandQueue {
+public:
+    void push(CommandAbstract* cmd);
+    CommandAbstract* pop();
+
+    CommandAbstract* front();
+    CommandAbstract* next(CommandAbstract* cmd); // command queued after cmd
+    void remove(CommandAbstract* cmd);
+    void replace(CommandAbstract* oldCmd, CommandAbstract* newCmd); // newCmd takes the position of oldCmd
+
+    bool empty();
+    size_t size();
+
+private:
+    CommandAbstract* _head = nullptr;
+    CommandAbstract* _tail = nullptr;
+    size_t _size = 0;
+};
@@ -22,13 +22,17 @@ void DevControlCommand::udpateCRC(uint8_t len)
     _payload[10 + len + 1] = (uint8_t)(crc);
 }
 
-bool DevControlCommand::handleResponse(InverterAbstract* inverter, fragment_t fragment[], uint8_t max_fragment_id)
+bool DevControlCommand::handleResponse(InverterAbstract* inverter, const response_t& response)
 {
-    for (uint8_t i = 0; i < max_fragment_id; i++) {
-        if (fragment[i].mainCmd != (_payload[0] | 0x80)) {
-            return false;
-        }
-    }
+    return response.mainCmd == (_payload[0] | 0x80);
+}
 
-    return true;
+CommandPriority DevControlCommand::getPriority()
+{
+    return CMD_PRIORITY_CONTROL;
+}
+
+CommandType DevControlCommand::getCommandType()
+{
+    return CMD_TYPE_CONTROL;
 }
\ No newline at end of file
@@ -7,7 +7,10 @@ class DevControlCommand : public CommandAbstract {
 public:
     explicit DevControlCommand(uint64_t target_address = 0, uint64_t router_address = 0);
 
-    virtual bool handleResponse(InverterAbstract* inverter, fragment_t fragment[], uint8_t max_fragment_id);
+    virtual bool handleResponse(InverterAbstract* inverter, const response_t& response);
+
+    virtual CommandPriority getPriority();
+    virtual CommandType getCommandType();
 
 protected:
     void udpateCRC(uint8_t len);
@@ -18,20 +18,23 @@ String DevInfoAllCommand::getCommandName()
     return "DevInfoAll";
 }
 
-bool DevInfoAllCommand::handleResponse(InverterAbstract* inverter, fragment_t fragment[], uint8_t max_fragment_id)
+bool DevInfoAllCommand::handleResponse(InverterAbstract* inverter, const response_t& response)
 {
     // Check CRC of whole payload
-    if (!MultiDataCommand::handleResponse(inverter, fragment, max_fragment_id)) {
+    if (!MultiDataCommand::handleResponse(inverter, response)) {
         return false;
     }
 
-    // Move all fragments into target buffer
-    uint8_t offs = 0;
+    // Copy the reassembled payload into target buffer
+    inverter->DevInfo()->beginAppendFragment();
     inverter->DevInfo()->clearBufferAll();
-    for (uint8_t i = 0; i < max_fragment_id; i++) {
-        inverter->DevInfo()->appendFragmentAll(offs, fragment[i].fragment, fragment[i].len);
-        offs += (fragment[i].len);
-    }
+    inverter->DevInfo()->appendFragmentAll(0, response.payload, response.len);
+    inverter->DevInfo()->endAppendFragment();
     inverter->DevInfo()->setLastUpdateAll(millis());
     return true;
+}
+
+CommandType DevInfoAllCommand::getCommandType()
+{
+    return CMD_TYPE_DEV_INFO;
 }
\ No newline at end of file
@@ -9,5 +9,7 @@ public:
 
     virtual String getCommandName();
 
-    virtual bool handleResponse(InverterAbstract* inverter, fragment_t fragment[], uint8_t max_fragment_id);
+    virtual bool handleResponse(InverterAbstract* inverter, const response_t& response);
+
+    virtual CommandType getCommandType();
 };
\ No newline at end of file
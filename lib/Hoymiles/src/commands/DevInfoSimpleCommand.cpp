@@ -18,20 +18,23 @@ String DevInfoSimpleCommand::getCommandName()
     return "DevInfoSimple";
 }
 
-bool DevInfoSimpleCommand::handleResponse(InverterAbstract* inverter, fragment_t fragment[], uint8_t max_fragment_id)
+bool DevInfoSimpleCommand::handleResponse(InverterAbstract* inverter, const response_t& response)
 {
     // Check CRC of whole payload
-    if (!MultiDataCommand::handleResponse(inverter, fragment, max_fragment_id)) {
+    if (!MultiDataCommand::handleResponse(inverter, response)) {
         return false;
     }
 
-    // Move all fragments into target buffer
-    uint8_t offs = 0;
+    // Copy the reassembled payload into target buffer
+    inverter->DevInfo()->beginAppendFragment();
     inverter->DevInfo()->clearBufferSimple();
-    for (uint8_t i = 0; i < max_fragment_id; i++) {
-        inverter->DevInfo()->appendFragmentSimple(offs, fragment[i].fragment, fragment[i].len);
-        offs += (fragment[i].len);
-    }
+    inverter->DevInfo()->appendFragmentSimple(0, response.payload, response.len);
+    inverter->DevInfo()->endAppendFragment();
     inverter->DevInfo()->setLastUpdateSimple(millis());
     return true;
+}
+
+CommandType DevInfoSimpleCommand::getCommandType()
+{
+    return CMD_TYPE_DEV_INFO;
 }
\ No newline at end of file
@@ -62,23 +62,17 @@ CommandAbstract* MultiDataCommand::getRequestFrameCommand(uint8_t frame_no)
     return &_cmdRequestFrame;
 }
 
-bool MultiDataCommand::handleResponse(InverterAbstract* inverter, fragment_t fragment[], uint8_t max_fragment_id)
+bool MultiDataCommand::handleResponse(InverterAbstract* inverter, const response_t& response)
 {
     // All fragments are available --> Check CRC
-    uint16_t crc = 0xffff, crcRcv = 0;
-
-    for (uint8_t i = 0; i < max_fragment_id; i++) {
-        if (i == max_fragment_id - 1) {
-            // Last packet
-            crc = crc16(fragment[i].fragment, fragment[i].len - 2, crc);
-            crcRcv = (fragment[i].fragment[fragment[i].len - 2] << 8)
-                | (fragment[i].fragment[fragment[i].len - 1]);
-        } else {
-            crc = crc16(fragment[i].fragment, fragment[i].len, crc);
-        }
+    if (response.len < 2) {
+        return false;
     }
 
-    return crc == crcRcv;
+    uint16_t crcRcv = (response.payload[response.len - 2] << 8)
+        | (response.payload[response.len - 1]);
+
+    return response.crc == crcRcv;
 }
 
 void MultiDataCommand::udpateCRC()
@@ -14,7 +14,7 @@ public:
 
     CommandAbstract* getRequestFrameCommand(uint8_t frame_no);
 
-    virtual bool handleResponse(InverterAbstract* inverter, fragment_t fragment[], uint8_t max_fragment_id);
+    virtual bool handleResponse(InverterAbstract* inverter, const response_t& response);
 
 protected:
     void setDataType(uint8_t data_type);
@@ -25,9 +25,9 @@ String PowerControlCommand::getCommandName()
     return "PowerControl";
 }
 
-bool PowerControlCommand::handleResponse(InverterAbstract* inverter, fragment_t fragment[], uint8_t max_fragment_id)
+bool PowerControlCommand::handleResponse(InverterAbstract* inverter, const response_t& response)
 {
-    if (!DevControlCommand::handleResponse(inverter, fragment, max_fragment_id)) {
+    if (!DevControlCommand::handleResponse(inverter, response)) {
         return false;
     }
 
@@ -18,26 +18,35 @@ String RealTimeRunDataCommand::getCommandName()
     return "RealTimeRunData";
 }
 
-bool RealTimeRunDataCommand::handleResponse(InverterAbstract* inverter, fragment_t fragment[], uint8_t max_fragment_id)
+bool RealTimeRunDataCommand::handleResponse(InverterAbstract* inverter, const response_t& response)
 {
     // Check CRC of whole payload
-    if (!MultiDataCommand::handleResponse(inverter, fragment, max_fragment_id)) {
+    if (!MultiDataCommand::handleResponse(inverter, response)) {
         return false;
     }
 
-    // Move all fragments into target buffer
-    uint8_t offs = 0;
+    // Copy the reassembled payload into target buffer
+    inverter->Statistics()->beginAppendFragment();
     inverter->Statistics()->clearBuffer();
-    for (uint8_t i = 0; i < max_fragment_id; i++) {
-        inverter->Statistics()->appendFragment(offs, fragment[i].fragment, fragment[i].len);
-        offs += (fragment[i].len);
-    }
+    inverter->Statistics()->appendFragment(0, response.payload, response.len);
+    inverter->Statistics()->endAppendFragment();
     inverter->Statistics()->resetRxFailureCount();
     inverter->Statistics()->setLastUpdate(millis());
+    inverter->Poll()->addStatsUpdate(millis());
     return true;
 }
 
 void RealTimeRunDataCommand::gotTimeout(InverterAbstract* inverter)
 {
     inverter->Statistics()->incrementRxFailureCount();
+}
+
+CommandPriority RealTimeRunDataCommand::getPriority()
+{
+    return CMD_PRIORITY_STATS;
+}
+
+CommandType RealTimeRunDataCommand::getCommandType()
+{
+    return CMD_TYPE_STATS;
 }
\ No newline at end of file
@@ -9,6 +9,9 @@ public:
 
     virtual String getCommandName();
 
-    virtual bool handleResponse(InverterAbstract* inverter, fragment_t fragment[], uint8_t max_fragment_id);
+    virtual bool handleResponse(InverterAbstract* inverter, const response_t& response);
     virtual void gotTimeout(InverterAbstract* inverter);
+
+    virtual CommandPriority getPriority();
+    virtual CommandType getCommandType();
 };
\ No newline at end of file
@@ -29,7 +29,7 @@ uint8_t RequestFrameCommand::getFrameNo()
     return _payload[9] & (~0x80);
 }
 
-bool RequestFrameCommand::handleResponse(InverterAbstract* inverter, fragment_t fragment[], uint8_t max_fragment_id)
+bool RequestFrameCommand::handleResponse(InverterAbstract* inverter, const response_t& response)
 {
     return true;
 }
\ No newline at end of file
@@ -12,5 +12,5 @@ public:
     void setFrameNo(uint8_t frame_no);
     uint8_t getFrameNo();
 
-    virtual bool handleResponse(InverterAbstract* inverter, fragment_t fragment[], uint8_t max_fragment_id);
+    virtual bool handleResponse(InverterAbstract* inverter, const response_t& response);
 };
\ No newline at end of file
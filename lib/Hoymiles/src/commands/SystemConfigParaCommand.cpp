@@ -18,20 +18,18 @@ String SystemConfigParaCommand::getCommandName()
     return "SystemConfigPara";
 }
 
-bool SystemConfigParaCommand::handleResponse(InverterAbstract* inverter, fragment_t fragment[], uint8_t max_fragment_id)
+bool SystemConfigParaCommand::handleResponse(InverterAbstract* inverter, const response_t& response)
 {
     // Check CRC of whole payload
-    if (!MultiDataCommand::handleResponse(inverter, fragment, max_fragment_id)) {
+    if (!MultiDataCommand::handleResponse(inverter, response)) {
         return false;
     }
 
-    // Move all fragments into target buffer
-    uint8_t offs = 0;
+    // Copy the reassembled payload into target buffer
+    inverter->SystemConfigPara()->beginAppendFragment();
     inverter->SystemConfigPara()->clearBuffer();
-    for (uint8_t i = 0; i < max_fragment_id; i++) {
-        inverter->SystemConfigPara()->appendFragment(offs, fragment[i].fragment, fragment[i].len);
-        offs += (fragment[i].len);
-    }
+    inverter->SystemConfigPara()->appendFragment(0, response.payload, response.len);
+    inverter->SystemConfigPara()->endAppendFragment();
     inverter->SystemConfigPara()->setLastUpdateRequest(millis());
     inverter->SystemConfigPara()->setLastLimitRequestSuccess(CMD_OK);
     return true;
@@ -40,4 +38,9 @@ bool SystemConfigParaCommand::handleResponse(InverterAbstract* inverter, fragmen
 void SystemConfigParaCommand::gotTimeout(InverterAbstract* inverter)
 {
     inverter->SystemConfigPara()->setLastLimitRequestSuccess(CMD_NOK);
+}
+
+CommandType SystemConfigParaCommand::getCommandType()
+{
+    return CMD_TYPE_SYSTEM_CONFIG;
 }
\ No newline at end of file
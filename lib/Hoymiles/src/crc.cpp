@@ -4,14 +4,93 @@
  */
 #include "crc.h"
 
+// The lookup tables are generated by the compiler from the bitwise definitions
+// below and end up in flash. gnu++11 has no std::index_sequence, hence the own one.
+namespace {
+
+template <uint8_t... Is>
+struct CrcIndices {
+};
+
+template <unsigned N, uint8_t... Is>
+struct MakeCrcIndices : MakeCrcIndices<N - 1, N - 1, Is...> {
+};
+
+template <uint8_t... Is>
+struct MakeCrcIndices<0, Is...> {
+    typedef CrcIndices<Is...> type;
+};
+
+template <typename T>
+struct CrcTable {
+    T v[256];
+};
+
+// One bit per recursion, C++11 constexpr functions consist of a single return statement
+constexpr uint8_t crc8Bits(uint8_t crc, uint8_t bits)
+{
+    return bits == 0 ? crc : crc8Bits(static_cast<uint8_t>((crc << 1) ^ ((crc & 0x80) ? CRC8_POLY : 0x00)), bits - 1);
+}
+
+constexpr uint16_t crc16Bits(uint16_t crc, uint8_t bits)
+{
+    return bits == 0 ? crc : crc16Bits(static_cast<uint16_t>((crc >> 1) ^ ((crc & 0x0001) ? CRC16_MODBUS_POLYNOM : 0x0000)), bits - 1);
+}
+
+constexpr uint16_t crc16nrf24Bits(uint16_t crc, uint8_t bits)
+{
+    return bits == 0 ? crc : crc16nrf24Bits(static_cast<uint16_t>((crc << 1) ^ ((crc & 0x8000) ? CRC16_NRF24_POLYNOM : 0x0000)), bits - 1);
+}
+
+template <uint8_t... Is>
+constexpr CrcTable<uint8_t> makeCrc8Table(CrcIndices<Is...>)
+{
+    return { { crc8Bits(Is, 8)... } };
+}
+
+template <uint8_t... Is>
+constexpr CrcTable<uint16_t> makeCrc16Table(CrcIndices<Is...>)
+{
+    return { { crc16Bits(Is, 8)... } };
+}
+
+template <uint8_t... Is>
+constexpr CrcTable<uint16_t> makeCrc16nrf24Table(CrcIndices<Is...>)
+{
+    return { { crc16nrf24Bits(static_cast<uint16_t>(Is << 8), 8)... } };
+}
+
+constexpr CrcTable<uint8_t> crc8Table = makeCrc8Table(MakeCrcIndices<256>::type());
+constexpr CrcTable<uint16_t> crc16Table = makeCrc16Table(MakeCrcIndices<256>::type());
+constexpr CrcTable<uint16_t> crc16nrf24Table = makeCrc16nrf24Table(MakeCrcIndices<256>::type());
+
+// Compile time check of the tables against the standard check value of "123456789"
+constexpr uint8_t crc8Check(const char* s, uint8_t crc)
+{
+    return *s == '\0' ? crc : crc8Check(s + 1, crc8Table.v[crc ^ static_cast<uint8_t>(*s)]);
+}
+
+constexpr uint16_t crc16Check(const char* s, uint16_t crc)
+{
+    return *s == '\0' ? crc : crc16Check(s + 1, (crc >> 8) ^ crc16Table.v[(crc ^ static_cast<uint8_t>(*s)) & 0xff]);
+}
+
+constexpr uint16_t crc16nrf24Check(const char* s, uint16_t crc)
+{
+    return *s == '\0' ? crc : crc16nrf24Check(s + 1, static_cast<uint16_t>(crc << 8) ^ crc16nrf24Table.v[(crc >> 8) ^ static_cast<uint8_t>(*s)]);
+}
+
+static_assert(crc8Check("123456789", CRC8_INIT) == 0x31, "crc8 table is broken"); // CRC-8 poly 0x01, init 0x00
+static_assert(crc16Check("123456789", 0xffff) == 0x4B37, "crc16 table is broken"); // CRC-16/MODBUS
+static_assert(crc16nrf24Check("123456789", 0xffff) == 0x29B1, "crc16nrf24 table is broken"); // CRC-16/CCITT-FALSE
+
+}
+
 uint8_t crc8(const uint8_t buf[], uint8_t len)
 {
     uint8_t crc = CRC8_INIT;
     for (uint8_t i = 0; i < len; i++) {
-        crc ^= buf[i];
-        for (uint8_t b = 0; b < 8; b++) {
-            crc = (crc << 1) ^ ((crc & 0x80) ? CRC8_POLY : 0x00);
-        }
+        crc = crc8Table.v[crc ^ buf[i]];
     }
     return crc;
 }
@@ -19,16 +98,8 @@ uint8_t crc8(const uint8_t buf[], uint8_t len)
 uint16_t crc16(const uint8_t buf[], uint8_t len, uint16_t start)
 {
     uint16_t crc = start;
-    uint8_t shift = 0;
-
     for (uint8_t i = 0; i < len; i++) {
-        crc = crc ^ buf[i];
-        for (uint8_t bit = 0; bit < 8; bit++) {
-            shift = (crc & 0x0001);
-            crc = crc >> 1;
-            if (shift != 0)
-                crc = crc ^ 0xA001;
-        }
+        crc = (crc >> 8) ^ crc16Table.v[(crc ^ buf[i]) & 0xff];
     }
     return crc;
 }
@@ -36,15 +107,22 @@ uint16_t crc16(const uint8_t buf[], uint8_t len, uint16_t start)
 uint16_t crc16nrf24(const uint8_t buf[], uint16_t lenBits, uint16_t startBit, uint16_t crcIn)
 {
     uint16_t crc = crcIn;
-    uint8_t idx, val = buf[(startBit >> 3)];
+    uint16_t bit = startBit;
+
+    // Bitwise until the start is byte aligned, whole bytes by table, bitwise for the rest
+    for (; bit < lenBits && (bit & 0x07) != 0; bit++) {
+        crc ^= 0x8000 & (buf[(bit >> 3)] << (8 + (bit & 0x07)));
+        crc = (crc & 0x8000) ? ((crc << 1) ^ CRC16_NRF24_POLYNOM) : (crc << 1);
+    }
 
-    for (uint16_t bit = startBit; bit < lenBits; bit++) {
-        idx = bit & 0x07;
-        if (0 == idx)
-            val = buf[(bit >> 3)];
-        crc ^= 0x8000 & (val << (8 + idx));
+    for (; bit + 8 <= lenBits; bit += 8) {
+        crc = (crc << 8) ^ crc16nrf24Table.v[(crc >> 8) ^ buf[(bit >> 3)]];
+    }
+
+    for (; bit < lenBits; bit++) {
+        crc ^= 0x8000 & (buf[(bit >> 3)] << (8 + (bit & 0x07)));
         crc = (crc & 0x8000) ? ((crc << 1) ^ CRC16_NRF24_POLYNOM) : (crc << 1);
     }
 
     return crc;
-}
\ No newline at end of file
+}
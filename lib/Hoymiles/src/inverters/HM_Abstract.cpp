@@ -25,9 +25,10 @@ bool HM_Abstract::sendStatsRequest(HoymilesRadio* radio)
     time_t now;
     time(&now);
 
-    RealTimeRunDataCommand* cmd = radio->enqueCommand<RealTimeRunDataCommand>();
+    auto cmd = radio->prepareCommand<RealTimeRunDataCommand>();
     cmd->setTime(now);
     cmd->setTargetAddress(serial());
+    radio->enqueCommand(cmd);
 
     return true;
 }
@@ -39,6 +40,9 @@ bool HM_Abstract::sendAlarmLogRequest(HoymilesRadio* radio, bool force)
         return false;
     }
 
+    // an unchanged counter counts as checked, the log is not requested again before the next interval
+    Poll()->addAlarmLogPoll(millis());
+
     if (!force) {
         if (Statistics()->hasChannelFieldValue(CH0, FLD_EVT_LOG)) {
             if ((uint8_t)Statistics()->getChannelFieldValue(CH0, FLD_EVT_LOG) == _lastAlarmLogCnt) {
@@ -52,10 +56,11 @@ bool HM_Abstract::sendAlarmLogRequest(HoymilesRadio* radio, bool force)
     time_t now;
     time(&now);
 
-    AlarmDataCommand* cmd = radio->enqueCommand<AlarmDataCommand>();
+    auto cmd = radio->prepareCommand<AlarmDataCommand>();
     cmd->setTime(now);
     cmd->setTargetAddress(serial());
     EventLog()->setLastAlarmRequestSuccess(CMD_PENDING);
+    radio->enqueCommand(cmd);
 
     return true;
 }
@@ -70,13 +75,15 @@ bool HM_Abstract::sendDevInfoRequest(HoymilesRadio* radio)
     time_t now;
     time(&now);
 
-    DevInfoAllCommand* cmdAll = radio->enqueCommand<DevInfoAllCommand>();
+    auto cmdAll = radio->prepareCommand<DevInfoAllCommand>();
     cmdAll->setTime(now);
     cmdAll->setTargetAddress(serial());
+    radio->enqueCommand(cmdAll);
 
-    DevInfoSimpleCommand* cmdSimple = radio->enqueCommand<DevInfoSimpleCommand>();
+    auto cmdSimple = radio->prepareCommand<DevInfoSimpleCommand>();
     cmdSimple->setTime(now);
     cmdSimple->setTargetAddress(serial());
+    radio->enqueCommand(cmdSimple);
 
     return true;
 }
@@ -91,10 +98,11 @@ bool HM_Abstract::sendSystemConfigParaRequest(HoymilesRadio* radio)
     time_t now;
     time(&now);
 
-    SystemConfigParaCommand* cmd = radio->enqueCommand<SystemConfigParaCommand>();
+    auto cmd = radio->prepareCommand<SystemConfigParaCommand>();
     cmd->setTime(now);
     cmd->setTargetAddress(serial());
     SystemConfigPara()->setLastLimitRequestSuccess(CMD_PENDING);
+    radio->enqueCommand(cmd);
 
     return true;
 }
@@ -108,10 +116,11 @@ bool HM_Abstract::sendActivePowerControlRequest(HoymilesRadio* radio, float limi
     _activePowerControlLimit = limit;
     _activePowerControlType = type;
 
-    ActivePowerControlCommand* cmd = radio->enqueCommand<ActivePowerControlCommand>();
+    auto cmd = radio->prepareCommand<ActivePowerControlCommand>();
     cmd->setActivePowerLimit(limit, type);
     cmd->setTargetAddress(serial());
     SystemConfigPara()->setLastLimitCommandSuccess(CMD_PENDING);
+    radio->enqueCommand(cmd);
 
     return true;
 }
@@ -129,10 +138,11 @@ bool HM_Abstract::sendPowerControlRequest(HoymilesRadio* radio, bool turnOn)
         _powerState = 0;
     }
 
-    PowerControlCommand* cmd = radio->enqueCommand<PowerControlCommand>();
+    auto cmd = radio->prepareCommand<PowerControlCommand>();
     cmd->setPowerOn(turnOn);
     cmd->setTargetAddress(serial());
     PowerCommand()->setLastPowerCommandSuccess(CMD_PENDING);
+    radio->enqueCommand(cmd);
 
     return true;
 }
@@ -141,10 +151,11 @@ bool HM_Abstract::sendRestartControlRequest(HoymilesRadio* radio)
 {
     _powerState = 2;
 
-    PowerControlCommand* cmd = radio->enqueCommand<PowerControlCommand>();
+    auto cmd = radio->prepareCommand<PowerControlCommand>();
     cmd->setRestart();
     cmd->setTargetAddress(serial());
     PowerCommand()->setLastPowerCommandSuccess(CMD_PENDING);
+    radio->enqueCommand(cmd);
 
     return true;
 }
@@ -166,4 +177,10 @@ bool HM_Abstract::resendPowerControlRequest(HoymilesRadio* radio)
         return false;
         break;
     }
+}
+
+size_t HM_Abstract::getMemoryUsage()
+{
+    // The HM_xCH types add no members
+    return InverterAbstract::getMemoryUsage() + sizeof(HM_Abstract) - sizeof(InverterAbstract);
 }
\ No newline at end of file
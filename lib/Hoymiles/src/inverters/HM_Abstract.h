@@ -15,6 +15,7 @@ public:
     bool sendPowerControlRequest(HoymilesRadio* radio, bool turnOn);
     bool sendRestartControlRequest(HoymilesRadio* radio);
     bool resendPowerControlRequest(HoymilesRadio* radio);
+    size_t getMemoryUsage();
 
 private:
     uint8_t _lastAlarmLogCnt = 0;
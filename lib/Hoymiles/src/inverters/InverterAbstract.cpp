@@ -7,6 +7,9 @@
 #include "crc.h"
 #include <cstring>
 
+InverterAbstract::RxResponseState InverterAbstract::_rx;
+InverterAbstract* InverterAbstract::_rxOwner = nullptr;
+
 InverterAbstract::InverterAbstract(uint64_t serial)
 {
     _serial.u64 = serial;
@@ -16,12 +19,6 @@ InverterAbstract::InverterAbstract(uint64_t serial)
         ((uint32_t)((serial >> 32) & 0xFFFFFFFF)),
         ((uint32_t)(serial & 0xFFFFFFFF)));
     _serialString = serial_buff;
-
-    _alarmLogParser.reset(new AlarmLogParser());
-    _devInfoParser.reset(new DevInfoParser());
-    _powerCommandParser.reset(new PowerCommandParser());
-    _statisticsParser.reset(new StatisticsParser());
-    _systemConfigParaParser.reset(new SystemConfigParaParser());
 }
 
 void InverterAbstract::init()
@@ -30,7 +27,7 @@ void InverterAbstract::init()
     // Not possible in constructor --> virtual function
     // Not possible in verifyAllFragments --> Because no data if nothing is ever received
     // It has to be executed because otherwise the getChannelCount method in stats always returns 0
-    _statisticsParser.get()->setByteAssignment(getByteAssignment(), getAssignmentCount());
+    _statisticsParser.setByteAssignment(getByteAssignment(), getAssignmentCount());
 }
 
 uint64_t InverterAbstract::serial()
@@ -74,79 +71,162 @@ bool InverterAbstract::isReachable()
 
 AlarmLogParser* InverterAbstract::EventLog()
 {
-    return _alarmLogParser.get();
+    return &_alarmLogParser;
 }
 
 DevInfoParser* InverterAbstract::DevInfo()
 {
-    return _devInfoParser.get();
+    return &_devInfoParser;
 }
 
 PowerCommandParser* InverterAbstract::PowerCommand()
 {
-    return _powerCommandParser.get();
+    return &_powerCommandParser;
 }
 
 StatisticsParser* InverterAbstract::Statistics()
 {
-    return _statisticsParser.get();
+    return &_statisticsParser;
 }
 
 SystemConfigParaParser* InverterAbstract::SystemConfigPara()
 {
-    return _systemConfigParaParser.get();
+    return &_systemConfigParaParser;
+}
+
+RadioStatistics* InverterAbstract::RadioStats()
+{
+    return &_radioStatistics;
+}
+
+PollPlan* InverterAbstract::Poll()
+{
+    return &_pollPlan;
+}
+
+size_t InverterAbstract::getMemoryUsage()
+{
+    return sizeof(InverterAbstract) + _serialString.length() + 1 + _statisticsParser.getPayloadSize();
+}
+
+size_t InverterAbstract::getSharedMemoryUsage()
+{
+    return sizeof(_rx);
 }
 
 void InverterAbstract::clearRxFragmentBuffer()
 {
-    memset(_rxFragmentBuffer, 0, MAX_RF_FRAGMENT_COUNT * sizeof(fragment_t));
-    _rxFragmentMaxPacketId = 0;
-    _rxFragmentLastPacketId = 0;
-    _rxFragmentRetransmitCnt = 0;
+    _rxOwner = this;
+    _rx.fragmentMask = 0;
+    _rx.lastFragmentLen = 0;
+    _rx.mainCmd = 0;
+    _rx.crc = 0xffff;
+    _rx.crcFragmentCnt = 0;
+    _rx.fragmentMaxPacketId = 0;
+    _rx.fragmentLastPacketId = 0;
+    _rx.fragmentRetransmitCnt = 0;
 }
 
 void InverterAbstract::addRxFragment(uint8_t fragment[], uint8_t len)
 {
+    if (_rxOwner != this) {
+        HOY_LOG(RADIO, HOY_LOG_LEVEL_DEBUG, "Fragment of %s without pending request dropped\n", _serialString.c_str());
+        return;
+    }
+
     if (len < 11) {
-        Hoymiles.getMessageOutput()->printf("FATAL: (%s, %d) fragment too short\n", __FILE__, __LINE__);
+        HOY_LOG(RADIO, HOY_LOG_LEVEL_ERROR, "FATAL: (%s, %d) fragment too short\n", __FILE__, __LINE__);
         return;
     }
 
     if (len - 11 > MAX_RF_PAYLOAD_SIZE) {
-        Hoymiles.getMessageOutput()->printf("FATAL: (%s, %d) fragment too large\n", __FILE__, __LINE__);
+        HOY_LOG(RADIO, HOY_LOG_LEVEL_ERROR, "FATAL: (%s, %d) fragment too large\n", __FILE__, __LINE__);
         return;
     }
 
     uint8_t fragmentCount = fragment[9];
     if (fragmentCount == 0) {
-        Hoymiles.getMessageOutput()->println("ERROR: fragment number zero received and ignored");
+        HOY_LOG(RADIO, HOY_LOG_LEVEL_WARN, "ERROR: fragment number zero received and ignored\n");
         return;
     }
 
-    if ((fragmentCount & 0b01111111) < MAX_RF_FRAGMENT_COUNT) {
-        // Packets with 0x81 will be seen as 1
-        memcpy(_rxFragmentBuffer[(fragmentCount & 0b01111111) - 1].fragment, &fragment[10], len - 11);
-        _rxFragmentBuffer[(fragmentCount & 0b01111111) - 1].len = len - 11;
-        _rxFragmentBuffer[(fragmentCount & 0b01111111) - 1].mainCmd = fragment[0];
-        _rxFragmentBuffer[(fragmentCount & 0b01111111) - 1].wasReceived = true;
+    // Packets with 0x81 will be seen as 1
+    uint8_t fragmentId = fragmentCount & 0b01111111;
+    // 0b10000000 == 0x80
+    bool isLast = (fragmentCount & 0b10000000) == 0b10000000;
+    uint8_t dataLen = len - 11;
+
+    if (fragmentId < MAX_RF_FRAGMENT_COUNT) {
+        if (_rx.fragmentMask & (1 << (fragmentId - 1))) {
+            // Duplicate, e.g. answer to a retransmit request which arrived late
+            return;
+        }
+
+        if (!isLast && dataLen != MAX_RF_FRAGMENT_DATA_SIZE) {
+            HOY_LOG(RADIO, HOY_LOG_LEVEL_WARN, "ERROR: fragment %d has unexpected length %d\n", fragmentId, dataLen);
+            return;
+        }
+
+        memcpy(&_rx.buffer[(fragmentId - 1) * MAX_RF_FRAGMENT_DATA_SIZE], &fragment[10], dataLen);
+        _rx.fragmentMask |= 1 << (fragmentId - 1);
 
-        if ((fragmentCount & 0b01111111) > _rxFragmentLastPacketId) {
-            _rxFragmentLastPacketId = fragmentCount & 0b01111111;
+        // main command of all fragments, 0 marks a mismatch
+        if (_rx.fragmentMask == (1 << (fragmentId - 1))) {
+            _rx.mainCmd = fragment[0];
+        } else if (_rx.mainCmd != fragment[0]) {
+            _rx.mainCmd = 0;
+        }
+
+        if (fragmentId > _rx.fragmentLastPacketId) {
+            _rx.fragmentLastPacketId = fragmentId;
         }
     }
 
-    // 0b10000000 == 0x80
-    if ((fragmentCount & 0b10000000) == 0b10000000) {
-        _rxFragmentMaxPacketId = fragmentCount & 0b01111111;
+    if (isLast) {
+        _rx.fragmentMaxPacketId = fragmentId;
+        _rx.lastFragmentLen = dataLen;
+    }
+
+    // Add all fragments which are now complete from the start to the CRC
+    while (_rx.crcFragmentCnt != _rx.fragmentMaxPacketId && (_rx.fragmentMask & (1 << _rx.crcFragmentCnt))) {
+        const uint8_t* data = &_rx.buffer[_rx.crcFragmentCnt * MAX_RF_FRAGMENT_DATA_SIZE];
+        _rx.crcFragmentCnt++;
+        if (_rx.crcFragmentCnt == _rx.fragmentMaxPacketId) {
+            // The last two bytes are the CRC itself
+            if (_rx.lastFragmentLen >= 2) {
+                _rx.crc = crc16(data, _rx.lastFragmentLen - 2, _rx.crc);
+            }
+        } else {
+            _rx.crc = crc16(data, MAX_RF_FRAGMENT_DATA_SIZE, _rx.crc);
+        }
     }
 }
 
-// Returns Zero on Success or the Fragment ID for retransmit or error code
-uint8_t InverterAbstract::verifyAllFragments(CommandAbstract* cmd)
+// True as soon as the last fragment (0x80) and all fragments before it are there
+bool InverterAbstract::isAllFragmentsReceived()
 {
+    if (_rxOwner != this || _rx.fragmentMaxPacketId == 0) {
+        return false;
+    }
+
+    uint16_t all = (1 << _rx.fragmentMaxPacketId) - 1;
+    return (_rx.fragmentMask & all) == all;
+}
+
+bool InverterAbstract::isFragmentReceived(uint8_t fragmentId)
+{
+    return _rxOwner == this && fragmentId > 0 && fragmentId <= MAX_RF_FRAGMENT_COUNT && (_rx.fragmentMask & (1 << (fragmentId - 1)));
+}
+
+// Returns Zero on Success, FRAGMENT_RETRANSMIT or an error code.
+// On FRAGMENT_RETRANSMIT bit n of missing is set for every missing fragment id n + 1.
+uint8_t InverterAbstract::verifyAllFragments(CommandAbstract* cmd, uint16_t& missing)
+{
+    missing = 0;
+
     // All missing
-    if (_rxFragmentLastPacketId == 0) {
-        Hoymiles.getMessageOutput()->println(F("All missing"));
+    if (_rxOwner != this || _rx.fragmentLastPacketId == 0) {
+        HOY_LOG(RADIO, HOY_LOG_LEVEL_INFO, "All missing\n");
         if (cmd->getSendCount() <= MAX_RESEND_COUNT) {
             return FRAGMENT_ALL_MISSING_RESEND;
         } else {
@@ -155,31 +235,35 @@ uint8_t InverterAbstract::verifyAllFragments(CommandAbstract* cmd)
         }
     }
 
+    // Middle fragments are missing
+    uint8_t lastId = _rx.fragmentMaxPacketId > 0 ? _rx.fragmentMaxPacketId - 1 : _rx.fragmentLastPacketId;
+    missing = ~_rx.fragmentMask & ((1 << lastId) - 1);
+
     // Last fragment is missing (thte one with 0x80)
-    if (_rxFragmentMaxPacketId == 0) {
-        Hoymiles.getMessageOutput()->println(F("Last missing"));
-        if (_rxFragmentRetransmitCnt++ < MAX_RETRANSMIT_COUNT) {
-            return _rxFragmentLastPacketId + 1;
+    if (_rx.fragmentMaxPacketId == 0) {
+        HOY_LOG(RADIO, HOY_LOG_LEVEL_INFO, "Last missing\n");
+        missing |= 1 << _rx.fragmentLastPacketId;
+    } else if (missing != 0) {
+        HOY_LOG(RADIO, HOY_LOG_LEVEL_INFO, "Middle missing\n");
+    }
+
+    // All missing fragments are requested in one go, so one retransmit round covers them all
+    if (missing != 0) {
+        if (_rx.fragmentRetransmitCnt++ < MAX_RETRANSMIT_COUNT) {
+            return FRAGMENT_RETRANSMIT;
         } else {
             cmd->gotTimeout(this);
             return FRAGMENT_RETRANSMIT_TIMEOUT;
         }
     }
 
-    // Middle fragment is missing
-    for (uint8_t i = 0; i < _rxFragmentMaxPacketId - 1; i++) {
-        if (!_rxFragmentBuffer[i].wasReceived) {
-            Hoymiles.getMessageOutput()->println(F("Middle missing"));
-            if (_rxFragmentRetransmitCnt++ < MAX_RETRANSMIT_COUNT) {
-                return i + 1;
-            } else {
-                cmd->gotTimeout(this);
-                return FRAGMENT_RETRANSMIT_TIMEOUT;
-            }
-        }
-    }
+    response_t response;
+    response.payload = _rx.buffer;
+    response.len = (_rx.fragmentMaxPacketId - 1) * MAX_RF_FRAGMENT_DATA_SIZE + _rx.lastFragmentLen;
+    response.mainCmd = _rx.mainCmd;
+    response.crc = _rx.crc;
 
-    if (!cmd->handleResponse(this, _rxFragmentBuffer, _rxFragmentMaxPacketId)) {
+    if (!cmd->handleResponse(this, response)) {
         cmd->gotTimeout(this);
         return FRAGMENT_HANDLE_ERROR;
     }
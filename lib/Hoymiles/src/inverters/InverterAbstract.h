@@ -8,6 +8,8 @@
 #include "../parser/StatisticsParser.h"
 #include "../parser/SystemConfigParaParser.h"
 #include "HoymilesRadio.h"
+#include "PollPlan.h"
+#include "RadioStatistics.h"
 #include "types.h"
 #include <Arduino.h>
 #include <cstdint>
@@ -19,10 +21,10 @@ enum {
     FRAGMENT_ALL_MISSING_TIMEOUT = 254,
     FRAGMENT_RETRANSMIT_TIMEOUT = 253,
     FRAGMENT_HANDLE_ERROR = 252,
+    FRAGMENT_RETRANSMIT = 251,
     FRAGMENT_OK = 0
 };
 
-#define MAX_RF_FRAGMENT_COUNT 13
 #define MAX_RETRANSMIT_COUNT 5 // Used to send the retransmit package
 #define MAX_RESEND_COUNT 4 // Used if all packages are missing
 #define MAX_ONLINE_FAILURE_COUNT 2
@@ -46,7 +48,9 @@ public:
 
     void clearRxFragmentBuffer();
     void addRxFragment(uint8_t fragment[], uint8_t len);
-    uint8_t verifyAllFragments(CommandAbstract* cmd);
+    uint8_t verifyAllFragments(CommandAbstract* cmd, uint16_t& missing);
+    bool isAllFragmentsReceived();
+    bool isFragmentReceived(uint8_t fragmentId);
 
     virtual bool sendStatsRequest(HoymilesRadio* radio) = 0;
     virtual bool sendAlarmLogRequest(HoymilesRadio* radio, bool force = false) = 0;
@@ -63,19 +67,45 @@ public:
     PowerCommandParser* PowerCommand();
     StatisticsParser* Statistics();
     SystemConfigParaParser* SystemConfigPara();
+    RadioStatistics* RadioStats();
+    PollPlan* Poll();
+
+    // RAM used by this inverter including its heap allocations
+    virtual size_t getMemoryUsage();
+    // RAM of the reassembly buffer shared by all inverters
+    static size_t getSharedMemoryUsage();
 
 private:
     serial_u _serial;
     String _serialString;
     char _name[MAX_NAME_LENGTH] = "";
-    fragment_t _rxFragmentBuffer[MAX_RF_FRAGMENT_COUNT];
-    uint8_t _rxFragmentMaxPacketId = 0;
-    uint8_t _rxFragmentLastPacketId = 0;
-    uint8_t _rxFragmentRetransmitCnt = 0;
 
-    std::unique_ptr<AlarmLogParser> _alarmLogParser;
-    std::unique_ptr<DevInfoParser> _devInfoParser;
-    std::unique_ptr<PowerCommandParser> _powerCommandParser;
-    std::unique_ptr<StatisticsParser> _statisticsParser;
-    std::unique_ptr<SystemConfigParaParser> _systemConfigParaParser;
+    // Reassembly state of the response to the request in flight. There is only
+    // one request in flight at a time, so all inverters share it. It belongs to
+    // the inverter which called clearRxFragmentBuffer() last, fragments of all
+    // other inverters are late answers to earlier requests and are dropped.
+    struct RxResponseState {
+        // Every fragment is written to its final position, fragment id n starts at
+        // (n - 1) * MAX_RF_FRAGMENT_DATA_SIZE, the CRC16 is accumulated in order
+        uint8_t buffer[MAX_RF_RESPONSE_SIZE];
+        uint16_t fragmentMask; // bit n set: fragment id n + 1 was received
+        uint8_t lastFragmentLen; // payload length of the fragment with 0x80
+        uint8_t mainCmd;
+        uint16_t crc;
+        uint8_t crcFragmentCnt; // leading fragments already included in crc
+        uint8_t fragmentMaxPacketId;
+        uint8_t fragmentLastPacketId;
+        uint8_t fragmentRetransmitCnt;
+    };
+    static RxResponseState _rx;
+    static InverterAbstract* _rxOwner;
+
+    AlarmLogParser _alarmLogParser;
+    DevInfoParser _devInfoParser;
+    PowerCommandParser _powerCommandParser;
+    StatisticsParser _statisticsParser;
+    SystemConfigParaParser _systemConfigParaParser;
+
+    RadioStatistics _radioStatistics;
+    PollPlan _pollPlan;
 };
\ No newline at end of file
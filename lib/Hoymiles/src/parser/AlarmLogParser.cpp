@@ -12,10 +12,10 @@ void AlarmLogParser::clearBuffer()
     _alarmLogLength = 0;
 }
 
-void AlarmLogParser::appendFragment(uint8_t offset, uint8_t* payload, uint8_t len)
+void AlarmLogParser::appendFragment(uint8_t offset, const uint8_t* payload, uint8_t len)
 {
     if (offset + len > ALARM_LOG_PAYLOAD_SIZE) {
-        Hoymiles.getMessageOutput()->printf("FATAL: (%s, %d) stats packet too large for buffer (%d > %d)\n", __FILE__, __LINE__, offset + len, ALARM_LOG_PAYLOAD_SIZE);
+        HOY_LOG(PARSER, HOY_LOG_LEVEL_ERROR, "FATAL: (%s, %d) stats packet too large for buffer (%d > %d)\n", __FILE__, __LINE__, offset + len, ALARM_LOG_PAYLOAD_SIZE);
         return;
     }
     memcpy(&_payloadAlarmLog[offset], payload, len);
@@ -24,7 +24,10 @@ void AlarmLogParser::appendFragment(uint8_t offset, uint8_t* payload, uint8_t le
 
 uint8_t AlarmLogParser::getEntryCount()
 {
-    return (_alarmLogLength - 2) / ALARM_LOG_ENTRY_SIZE;
+    HOY_PARSER_SEMAPHORE_TAKE();
+    uint8_t count = (_alarmLogLength - 2) / ALARM_LOG_ENTRY_SIZE;
+    HOY_PARSER_SEMAPHORE_GIVE();
+    return count;
 }
 
 void AlarmLogParser::setLastAlarmRequestSuccess(LastCommandSuccess status)
@@ -43,6 +46,8 @@ void AlarmLogParser::getLogEntry(uint8_t entryId, AlarmLogEntry_t* entry)
 
     int timezoneOffset = getTimezoneOffset();
 
+    HOY_PARSER_SEMAPHORE_TAKE();
+
     uint32_t wcode = (uint16_t)_payloadAlarmLog[entryStartOffset] << 8 | _payloadAlarmLog[entryStartOffset + 1];
     uint32_t startTimeOffset = 0;
     if (((wcode >> 13) & 0x01) == 1) {
@@ -58,6 +63,8 @@ void AlarmLogParser::getLogEntry(uint8_t entryId, AlarmLogEntry_t* entry)
     entry->StartTime = (((uint16_t)_payloadAlarmLog[entryStartOffset + 4] << 8) | ((uint16_t)_payloadAlarmLog[entryStartOffset + 5])) + startTimeOffset + timezoneOffset;
     entry->EndTime = ((uint16_t)_payloadAlarmLog[entryStartOffset + 6] << 8) | ((uint16_t)_payloadAlarmLog[entryStartOffset + 7]);
 
+    HOY_PARSER_SEMAPHORE_GIVE();
+
     if (entry->EndTime > 0) {
         entry->EndTime += (endTimeOffset + timezoneOffset);
     }
@@ -18,7 +18,7 @@ struct AlarmLogEntry_t {
 class AlarmLogParser : public Parser {
 public:
     void clearBuffer();
-    void appendFragment(uint8_t offset, uint8_t* payload, uint8_t len);
+    void appendFragment(uint8_t offset, const uint8_t* payload, uint8_t len);
 
     uint8_t getEntryCount();
     void getLogEntry(uint8_t entryId, AlarmLogEntry_t* entry);
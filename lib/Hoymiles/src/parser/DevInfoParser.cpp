@@ -34,10 +34,10 @@ void DevInfoParser::clearBufferAll()
     _devInfoAllLength = 0;
 }
 
-void DevInfoParser::appendFragmentAll(uint8_t offset, uint8_t* payload, uint8_t len)
+void DevInfoParser::appendFragmentAll(uint8_t offset, const uint8_t* payload, uint8_t len)
 {
     if (offset + len > DEV_INFO_SIZE) {
-        Hoymiles.getMessageOutput()->printf("FATAL: (%s, %d) dev info all packet too large for buffer\n", __FILE__, __LINE__);
+        HOY_LOG(PARSER, HOY_LOG_LEVEL_ERROR, "FATAL: (%s, %d) dev info all packet too large for buffer\n", __FILE__, __LINE__);
         return;
     }
     memcpy(&_payloadDevInfoAll[offset], payload, len);
@@ -50,10 +50,10 @@ void DevInfoParser::clearBufferSimple()
     _devInfoSimpleLength = 0;
 }
 
-void DevInfoParser::appendFragmentSimple(uint8_t offset, uint8_t* payload, uint8_t len)
+void DevInfoParser::appendFragmentSimple(uint8_t offset, const uint8_t* payload, uint8_t len)
 {
     if (offset + len > DEV_INFO_SIZE) {
-        Hoymiles.getMessageOutput()->printf("FATAL: (%s, %d) dev info Simple packet too large for buffer\n", __FILE__, __LINE__);
+        HOY_LOG(PARSER, HOY_LOG_LEVEL_ERROR, "FATAL: (%s, %d) dev info Simple packet too large for buffer\n", __FILE__, __LINE__);
         return;
     }
     memcpy(&_payloadDevInfoSimple[offset], payload, len);
@@ -84,12 +84,16 @@ void DevInfoParser::setLastUpdateSimple(uint32_t lastUpdate)
 
 uint16_t DevInfoParser::getFwBuildVersion()
 {
-    return (((uint16_t)_payloadDevInfoAll[0]) << 8) | _payloadDevInfoAll[1];
+    HOY_PARSER_SEMAPHORE_TAKE();
+    uint16_t ret = (((uint16_t)_payloadDevInfoAll[0]) << 8) | _payloadDevInfoAll[1];
+    HOY_PARSER_SEMAPHORE_GIVE();
+    return ret;
 }
 
 time_t DevInfoParser::getFwBuildDateTime()
 {
     struct tm timeinfo = {};
+    HOY_PARSER_SEMAPHORE_TAKE();
     timeinfo.tm_year = ((((uint16_t)_payloadDevInfoAll[2]) << 8) | _payloadDevInfoAll[3]) - 1900;
 
     timeinfo.tm_mon = ((((uint16_t)_payloadDevInfoAll[4]) << 8) | _payloadDevInfoAll[5]) / 100 - 1;
@@ -97,13 +101,17 @@ time_t DevInfoParser::getFwBuildDateTime()
 
     timeinfo.tm_hour = ((((uint16_t)_payloadDevInfoAll[6]) << 8) | _payloadDevInfoAll[7]) / 100;
     timeinfo.tm_min = ((((uint16_t)_payloadDevInfoAll[6]) << 8) | _payloadDevInfoAll[7]) % 100;
+    HOY_PARSER_SEMAPHORE_GIVE();
 
     return timegm(&timeinfo);
 }
 
 uint16_t DevInfoParser::getFwBootloaderVersion()
 {
-    return (((uint16_t)_payloadDevInfoAll[8]) << 8) | _payloadDevInfoAll[9];
+    HOY_PARSER_SEMAPHORE_TAKE();
+    uint16_t ret = (((uint16_t)_payloadDevInfoAll[8]) << 8) | _payloadDevInfoAll[9];
+    HOY_PARSER_SEMAPHORE_GIVE();
+    return ret;
 }
 
 uint32_t DevInfoParser::getHwPartNumber()
@@ -111,8 +119,10 @@ uint32_t DevInfoParser::getHwPartNumber()
     uint16_t hwpn_h;
     uint16_t hwpn_l;
 
+    HOY_PARSER_SEMAPHORE_TAKE();
     hwpn_h = (((uint16_t)_payloadDevInfoSimple[2]) << 8) | _payloadDevInfoSimple[3];
     hwpn_l = (((uint16_t)_payloadDevInfoSimple[4]) << 8) | _payloadDevInfoSimple[5];
+    HOY_PARSER_SEMAPHORE_GIVE();
 
     return ((uint32_t)hwpn_h << 16) | ((uint32_t)hwpn_l);
 }
@@ -120,7 +130,9 @@ uint32_t DevInfoParser::getHwPartNumber()
 String DevInfoParser::getHwVersion()
 {
     char buf[8];
+    HOY_PARSER_SEMAPHORE_TAKE();
     snprintf(buf, sizeof(buf), "%02d.%02d", _payloadDevInfoSimple[6], _payloadDevInfoSimple[7]);
+    HOY_PARSER_SEMAPHORE_GIVE();
     return buf;
 }
 
@@ -144,26 +156,32 @@ String DevInfoParser::getHwModelName()
 
 uint8_t DevInfoParser::getDevIdx()
 {
+    uint8_t ret = 0xff;
     uint8_t pos;
+
+    HOY_PARSER_SEMAPHORE_TAKE();
     // Check for all 4 bytes first
     for (pos = 0; pos < sizeof(devInfo) / sizeof(devInfo_t); pos++) {
         if (devInfo[pos].hwPart[0] == _payloadDevInfoSimple[2]
             && devInfo[pos].hwPart[1] == _payloadDevInfoSimple[3]
             && devInfo[pos].hwPart[2] == _payloadDevInfoSimple[4]
             && devInfo[pos].hwPart[3] == _payloadDevInfoSimple[5]) {
-            return pos;
+            ret = pos;
+            break;
         }
     }
 
     // Then only for 3 bytes
-    for (pos = 0; pos < sizeof(devInfo) / sizeof(devInfo_t); pos++) {
+    for (pos = 0; ret == 0xff && pos < sizeof(devInfo) / sizeof(devInfo_t); pos++) {
         if (devInfo[pos].hwPart[0] == _payloadDevInfoSimple[2]
             && devInfo[pos].hwPart[1] == _payloadDevInfoSimple[3]
             && devInfo[pos].hwPart[2] == _payloadDevInfoSimple[4]) {
-            return pos;
+            ret = pos;
         }
     }
-    return 0xff;
+    HOY_PARSER_SEMAPHORE_GIVE();
+
+    return ret;
 }
 
 /* struct tm to seconds since Unix epoch */
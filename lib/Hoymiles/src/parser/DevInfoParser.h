@@ -8,10 +8,10 @@
 class DevInfoParser : public Parser {
 public:
     void clearBufferAll();
-    void appendFragmentAll(uint8_t offset, uint8_t* payload, uint8_t len);
+    void appendFragmentAll(uint8_t offset, const uint8_t* payload, uint8_t len);
 
     void clearBufferSimple();
-    void appendFragmentSimple(uint8_t offset, uint8_t* payload, uint8_t len);
+    void appendFragmentSimple(uint8_t offset, const uint8_t* payload, uint8_t len);
 
     uint32_t getLastUpdateAll();
     void setLastUpdateAll(uint32_t lastUpdate);
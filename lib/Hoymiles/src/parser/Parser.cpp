@@ -4,6 +4,16 @@
  */
 #include "Parser.h"
 
+SemaphoreHandle_t Parser::_xSemaphore = nullptr;
+
+Parser::Parser()
+{
+    // Parsers are created together with their inverter by the main task
+    if (nullptr == _xSemaphore) {
+        _xSemaphore = xSemaphoreCreateRecursiveMutex();
+    }
+}
+
 uint32_t Parser::getLastUpdate()
 {
     return _lastUpdate;
@@ -12,4 +22,14 @@ uint32_t Parser::getLastUpdate()
 void Parser::setLastUpdate(uint32_t lastUpdate)
 {
     _lastUpdate = lastUpdate;
+}
+
+void Parser::beginAppendFragment()
+{
+    HOY_PARSER_SEMAPHORE_TAKE();
+}
+
+void Parser::endAppendFragment()
+{
+    HOY_PARSER_SEMAPHORE_GIVE();
 }
\ No newline at end of file
@@ -1,6 +1,11 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 #pragma once
 #include <cstdint>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#define HOY_PARSER_SEMAPHORE_TAKE() xSemaphoreTakeRecursive(_xSemaphore, portMAX_DELAY)
+#define HOY_PARSER_SEMAPHORE_GIVE() xSemaphoreGiveRecursive(_xSemaphore)
 
 typedef enum {
     CMD_OK,
@@ -10,9 +15,18 @@ typedef enum {
 
 class Parser {
 public:
+    Parser();
     uint32_t getLastUpdate();
     void setLastUpdate(uint32_t lastUpdate);
 
+    // The payload is written by the radio task and read by the web and mqtt handlers
+    void beginAppendFragment();
+    void endAppendFragment();
+
+protected:
+    // Shared by all parsers of all inverters, the sections it protects only copy a few bytes
+    static SemaphoreHandle_t _xSemaphore;
+
 private:
     uint32_t _lastUpdate = 0;
 };
\ No newline at end of file
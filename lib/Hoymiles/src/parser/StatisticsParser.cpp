@@ -32,21 +32,42 @@ void StatisticsParser::setByteAssignment(const byteAssign_t* byteAssignment, con
 {
     _byteAssignment = byteAssignment;
     _byteAssignmentCount = count;
+
+    // Bytes behind the last assigned field (e.g. the CRC) are never read
+    uint8_t size = 0;
+    for (uint8_t pos = 0; pos < count; pos++) {
+        if (byteAssignment[pos].div != CMD_CALC && byteAssignment[pos].start + byteAssignment[pos].num > size) {
+            size = byteAssignment[pos].start + byteAssignment[pos].num;
+        }
+    }
+
+    HOY_PARSER_SEMAPHORE_TAKE();
+    _payloadStatistic.reset(new uint8_t[size]());
+    _payloadSize = size;
+    _statisticLength = 0;
+    HOY_PARSER_SEMAPHORE_GIVE();
+}
+
+uint8_t StatisticsParser::getPayloadSize()
+{
+    return _payloadSize;
 }
 
 void StatisticsParser::clearBuffer()
 {
-    memset(_payloadStatistic, 0, STATISTIC_PACKET_SIZE);
+    memset(_payloadStatistic.get(), 0, _payloadSize);
     _statisticLength = 0;
 }
 
-void StatisticsParser::appendFragment(uint8_t offset, uint8_t* payload, uint8_t len)
+void StatisticsParser::appendFragment(uint8_t offset, const uint8_t* payload, uint8_t len)
 {
     if (offset + len > STATISTIC_PACKET_SIZE) {
-        Hoymiles.getMessageOutput()->printf("FATAL: (%s, %d) stats packet too large for buffer\n", __FILE__, __LINE__);
+        HOY_LOG(PARSER, HOY_LOG_LEVEL_ERROR, "FATAL: (%s, %d) stats packet too large for buffer\n", __FILE__, __LINE__);
         return;
     }
-    memcpy(&_payloadStatistic[offset], payload, len);
+    if (offset < _payloadSize) {
+        memcpy(&_payloadStatistic[offset], payload, min<uint8_t>(len, _payloadSize - offset));
+    }
     _statisticLength += len;
 }
 
@@ -79,10 +100,12 @@ float StatisticsParser::getChannelFieldValue(uint8_t channel, uint8_t fieldId)
     if (CMD_CALC != div) {
         // Value is a static value
         uint32_t val = 0;
+        HOY_PARSER_SEMAPHORE_TAKE();
         do {
             val <<= 8;
             val |= _payloadStatistic[ptr];
         } while (++ptr != end);
+        HOY_PARSER_SEMAPHORE_GIVE();
 
         float result;
         if (b[pos].isSigned && b[pos].num == 2) {
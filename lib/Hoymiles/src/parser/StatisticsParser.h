@@ -3,8 +3,9 @@
 #include "Parser.h"
 #include <Arduino.h>
 #include <cstdint>
+#include <memory>
 
-#define STATISTIC_PACKET_SIZE (4 * 16)
+#define STATISTIC_PACKET_SIZE (4 * 16) // largest payload of all inverter types
 
 // units
 enum {
@@ -76,9 +77,11 @@ typedef struct {
 class StatisticsParser : public Parser {
 public:
     void clearBuffer();
-    void appendFragment(uint8_t offset, uint8_t* payload, uint8_t len);
+    void appendFragment(uint8_t offset, const uint8_t* payload, uint8_t len);
 
+    // Also sizes the payload buffer to the last byte used by the assignment
     void setByteAssignment(const byteAssign_t* byteAssignment, const uint8_t count);
+    uint8_t getPayloadSize();
 
     uint8_t getAssignIdxByChannelField(uint8_t channel, uint8_t fieldId);
     float getChannelFieldValue(uint8_t channel, uint8_t fieldId);
@@ -97,7 +100,8 @@ public:
     uint32_t getRxFailureCount();
 
 private:
-    uint8_t _payloadStatistic[STATISTIC_PACKET_SIZE] = {};
+    std::unique_ptr<uint8_t[]> _payloadStatistic;
+    uint8_t _payloadSize = 0;
     uint8_t _statisticLength = 0;
     uint16_t _chanMaxPower[CH4];
 
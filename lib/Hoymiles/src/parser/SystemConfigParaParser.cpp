@@ -12,10 +12,10 @@ void SystemConfigParaParser::clearBuffer()
     _payloadLength = 0;
 }
 
-void SystemConfigParaParser::appendFragment(uint8_t offset, uint8_t* payload, uint8_t len)
+void SystemConfigParaParser::appendFragment(uint8_t offset, const uint8_t* payload, uint8_t len)
 {
     if (offset + len > (SYSTEM_CONFIG_PARA_SIZE)) {
-        Hoymiles.getMessageOutput()->printf("FATAL: (%s, %d) stats packet too large for buffer\n", __FILE__, __LINE__);
+        HOY_LOG(PARSER, HOY_LOG_LEVEL_ERROR, "FATAL: (%s, %d) stats packet too large for buffer\n", __FILE__, __LINE__);
         return;
     }
     memcpy(&_payload[offset], payload, len);
@@ -24,13 +24,18 @@ void SystemConfigParaParser::appendFragment(uint8_t offset, uint8_t* payload, ui
 
 float SystemConfigParaParser::getLimitPercent()
 {
-    return ((((uint16_t)_payload[2]) << 8) | _payload[3]) / 10.0;
+    HOY_PARSER_SEMAPHORE_TAKE();
+    float ret = ((((uint16_t)_payload[2]) << 8) | _payload[3]) / 10.0;
+    HOY_PARSER_SEMAPHORE_GIVE();
+    return ret;
 }
 
 void SystemConfigParaParser::setLimitPercent(float value)
 {
+    HOY_PARSER_SEMAPHORE_TAKE();
     _payload[2] = ((uint16_t)(value * 10)) >> 8;
     _payload[3] = ((uint16_t)(value * 10));
+    HOY_PARSER_SEMAPHORE_GIVE();
 }
 
 void SystemConfigParaParser::setLastLimitCommandSuccess(LastCommandSuccess status)
@@ -8,7 +8,7 @@
 class SystemConfigParaParser : public Parser {
 public:
     void clearBuffer();
-    void appendFragment(uint8_t offset, uint8_t* payload, uint8_t len);
+    void appendFragment(uint8_t offset, const uint8_t* payload, uint8_t len);
 
     float getLimitPercent();
     void setLimitPercent(float value);
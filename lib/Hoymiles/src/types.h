@@ -11,10 +11,25 @@ union serial_u {
 // maximum buffer length of packet received / sent to RF24 module
 #define MAX_RF_PAYLOAD_SIZE 32
 
+// maximum number of fragments of a response
+#define MAX_RF_FRAGMENT_COUNT 13
+
+// payload bytes of every fragment of a response but the last one
+#define MAX_RF_FRAGMENT_DATA_SIZE 16
+
+// largest reassembled response, the last fragment may be longer than the others
+#define MAX_RF_RESPONSE_SIZE ((MAX_RF_FRAGMENT_COUNT - 1) * MAX_RF_FRAGMENT_DATA_SIZE + MAX_RF_PAYLOAD_SIZE)
+
 typedef struct {
-    uint8_t mainCmd;
     uint8_t fragment[MAX_RF_PAYLOAD_SIZE];
     uint8_t len;
     uint8_t channel;
-    bool wasReceived;
 } fragment_t;
+
+// View of a completely reassembled response, valid during handleResponse() only
+typedef struct {
+    const uint8_t* payload; // data of all fragments in order, the last two bytes are the CRC16
+    uint8_t len;
+    uint8_t mainCmd; // main command of all fragments, 0 if they differ
+    uint16_t crc; // CRC16 over all but the last two bytes, accumulated while the fragments arrived
+} response_t;
@@ -0,0 +1,160 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "VeDirect.h"
+
+VeDirectClass VeDirect;
+
+// Adds the latest frame of every device to its history once per second
+void VeDirectClass::loop()
+{
+    uint32_t now = esp_timer_get_time() / 1000000;
+    if (now == _lastHistorySample) {
+        return;
+    }
+    _lastHistorySample = now;
+
+    for (uint8_t pos = 0; pos < _devices.size(); pos++) {
+        auto dev = _devices[pos];
+        if (dev->getLastUpdate() > 0 && millis() - dev->getLastUpdate() < VE_HISTORY_MAX_AGE) {
+            VeDirectRecord frame;
+            dev->getFrame(frame);
+            _histories[pos]->addSample(&frame, now);
+        } else {
+            _histories[pos]->addSample(nullptr, now);
+        }
+    }
+}
+
+// Devices are only added during setup, so the list is not protected against concurrent access
+std::shared_ptr<VeDirectFrameHandler> VeDirectClass::addDevice(const char* name, uint8_t uartNum, int8_t rxPin, int8_t txPin)
+{
+    if (_devices.size() >= VE_MAX_DEVICE_COUNT) {
+        return nullptr;
+    }
+
+    // the rx tasks of the devices added before may store registers meanwhile, so _registers is never reallocated
+    if (_xSemaphore == nullptr) {
+        _xSemaphore = xSemaphoreCreateMutex();
+        _registers.reserve(VE_MAX_DEVICE_COUNT);
+    }
+    uint8_t pos = _devices.size();
+    _registers.push_back(std::unique_ptr<RegisterCache>(new RegisterCache()));
+
+    std::shared_ptr<VeDirectFrameHandler> d = std::make_shared<VeDirectFrameHandler>(uartNum);
+    d->setName(name);
+    d->init(rxPin, txPin);
+    d->setHexAsyncCallback([this, pos](const VeDirectHexData& data) { storeRegister(pos, data); });
+    _devices.push_back(d);
+    _histories.push_back(std::make_shared<VeDirectHistory>());
+    return d;
+}
+
+std::shared_ptr<VeDirectFrameHandler> VeDirectClass::getDeviceByPos(uint8_t pos)
+{
+    if (pos >= _devices.size()) {
+        return nullptr;
+    } else {
+        return _devices[pos];
+    }
+}
+
+std::shared_ptr<VeDirectHistory> VeDirectClass::getHistoryByPos(uint8_t pos)
+{
+    if (pos >= _histories.size()) {
+        return nullptr;
+    } else {
+        return _histories[pos];
+    }
+}
+
+size_t VeDirectClass::getNumDevices()
+{
+    return _devices.size();
+}
+
+bool VeDirectClass::readRegister(uint8_t pos, uint16_t id)
+{
+    if (pos >= _devices.size()) {
+        return false;
+    }
+    return _devices[pos]->sendHexGet(id, [this, pos](const VeDirectHexData& data) { storeRegister(pos, data); });
+}
+
+bool VeDirectClass::writeRegister(uint8_t pos, uint16_t id, uint32_t value, uint8_t size)
+{
+    if (pos >= _devices.size()) {
+        return false;
+    }
+    return _devices[pos]->sendHexSet(id, value, size, [this, pos](const VeDirectHexData& data) { storeRegister(pos, data); });
+}
+
+uint8_t VeDirectClass::getRegisters(uint8_t pos, VeDirectRegister* registers, uint8_t max)
+{
+    if (pos >= _registers.size()) {
+        return 0;
+    }
+
+    xSemaphoreTake(_xSemaphore, portMAX_DELAY);
+    const RegisterCache& cache = *_registers[pos];
+    uint8_t count = min(cache.count, max);
+    memcpy(registers, cache.registers, count * sizeof(VeDirectRegister));
+    xSemaphoreGive(_xSemaphore);
+    return count;
+}
+
+uint32_t VeDirectClass::getRegisterSeq(uint8_t pos)
+{
+    if (pos >= _registers.size()) {
+        return 0;
+    }
+
+    xSemaphoreTake(_xSemaphore, portMAX_DELAY);
+    uint32_t seq = _registers[pos]->seq;
+    xSemaphoreGive(_xSemaphore);
+    return seq;
+}
+
+void VeDirectClass::storeRegister(uint8_t pos, const VeDirectHexData& data)
+{
+    // only responses which belong to a register
+    switch (data.response) {
+    case VE_HEX_RSP_GET:
+    case VE_HEX_RSP_SET:
+    case VE_HEX_RSP_ASYNC:
+    case VE_HEX_RSP_TIMEOUT:
+        break;
+    default:
+        return;
+    }
+
+    xSemaphoreTake(_xSemaphore, portMAX_DELAY);
+    RegisterCache& cache = *_registers[pos];
+
+    // same register, a free slot or the oldest one
+    uint8_t slot = 0;
+    for (; slot < cache.count; slot++) {
+        if (cache.registers[slot].data.id == data.id) {
+            break;
+        }
+    }
+    bool isNew = slot == cache.count;
+    if (slot == VE_REGISTER_CACHE_SIZE) {
+        slot = 0;
+        for (uint8_t i = 1; i < cache.count; i++) {
+            if (static_cast<int32_t>(cache.registers[i].timestamp - cache.registers[slot].timestamp) < 0) {
+                slot = i;
+            }
+        }
+    } else if (isNew) {
+        cache.count++;
+    }
+
+    // async notifications are repeated by the device, only changes count as update
+    VeDirectRegister& reg = cache.registers[slot];
+    if (isNew || data.response != VE_HEX_RSP_ASYNC || reg.data.response != data.response
+        || reg.data.flags != data.flags || reg.data.value != data.value) {
+        reg.seq = ++cache.seq;
+    }
+    reg.data = data;
+    reg.timestamp = millis();
+    xSemaphoreGive(_xSemaphore);
+}
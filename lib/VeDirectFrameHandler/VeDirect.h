@@ -0,0 +1,52 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "VeDirectFrameHandler.h"
+#include "VeDirectHistory.h"
+#include <memory>
+#include <vector>
+
+#define VE_MAX_DEVICE_COUNT 2 // UART0 is used for the console, UART1 and UART2 are left
+#define VE_HISTORY_MAX_AGE 3000 // ms, older frames are stored as no data in the history
+#define VE_REGISTER_CACHE_SIZE 16 // hex registers kept per device, the oldest one is replaced
+
+// Last response of the device for a hex register, also updated by async notifications
+struct VeDirectRegister {
+    VeDirectHexData data; // data.response is VE_HEX_RSP_TIMEOUT if the device did not answer
+    uint32_t timestamp; // millis() of the response
+    uint32_t seq; // getRegisterSeq() of the device after storing it
+};
+
+class VeDirectClass {
+public:
+    void loop();
+
+    std::shared_ptr<VeDirectFrameHandler> addDevice(const char* name, uint8_t uartNum, int8_t rxPin, int8_t txPin);
+    std::shared_ptr<VeDirectFrameHandler> getDeviceByPos(uint8_t pos);
+    std::shared_ptr<VeDirectHistory> getHistoryByPos(uint8_t pos);
+    size_t getNumDevices();
+
+    // Registers are read and written asynchronously, the result shows up in the register cache
+    bool readRegister(uint8_t pos, uint16_t id);
+    bool writeRegister(uint8_t pos, uint16_t id, uint32_t value, uint8_t size);
+    uint8_t getRegisters(uint8_t pos, VeDirectRegister* registers, uint8_t max); // copy of the register cache
+    uint32_t getRegisterSeq(uint8_t pos); // incremented for every register update of the device
+
+private:
+    struct RegisterCache {
+        VeDirectRegister registers[VE_REGISTER_CACHE_SIZE];
+        uint8_t count;
+        uint32_t seq;
+    };
+
+    void storeRegister(uint8_t pos, const VeDirectHexData& data); // called from the rx task of the device
+
+    std::vector<std::shared_ptr<VeDirectFrameHandler>> _devices;
+    std::vector<std::shared_ptr<VeDirectHistory>> _histories; // same order as _devices
+    std::vector<std::unique_ptr<RegisterCache>> _registers; // same order as _devices
+    SemaphoreHandle_t _xSemaphore = nullptr; // protects _registers
+
+    uint32_t _lastHistorySample = 0;
+};
+
+extern VeDirectClass VeDirect;
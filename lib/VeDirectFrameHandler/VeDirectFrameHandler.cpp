@@ -30,64 +30,292 @@
  * 2020.05.05 - 0.2 - initial release
  * 2020.06.21 - 0.2 - add MIT license, no code changes
  * 2020.08.20 - 0.3 - corrected #include reference
+ * 2022.10.23 - 0.4 - HEX protocol with pipelined register get/set
+ * 2022.10.25 - 0.5 - one instance per uart
+ * 2022.10.26 - 0.6 - chunked input and parser statistics
+ * 2022.10.27 - 0.7 - lookup tables for readable texts
+ * 2022.10.28 - 0.8 - per field change mask with deadbands
+ * 2022.10.29 - 0.9 - double buffered snapshot, readers do not lock
+ * 2022.10.31 - 0.10 - link quality counters and decode latency histogram
+ * 2022.11.02 - 0.11 - battery monitor fields, other labels are passed through
  * 
  */
  
 #include <Arduino.h>
 #include "VeDirectFrameHandler.h"
+#include "VeDirectTexts.h"
 
 char MODULE[] = "VE.Frame";	// Victron seems to use this to find out where logging messages were generated
 
 // The name of the record that contains the checksum.
 static constexpr char checksumTagName[] = "CHECKSUM";
 
-HardwareSerial VedirectSerial(1);
+enum {
+	VE_TYPE_BOOL = 0,  // "ON" / "OFF"
+	VE_TYPE_U8,
+	VE_TYPE_U16,
+	VE_TYPE_HEX16,
+	VE_TYPE_U32,
+	VE_TYPE_HEX32,
+	VE_TYPE_I32,
+	VE_TYPE_STR
+};
 
-VeDirectFrameHandler VeDirect;
+typedef struct {
+	const char* name;  // label as sent by the device (upper case)
+	uint8_t type;      // how the value is decoded
+	uint8_t offset;    // position of the value within VeDirectRecord
+} veFieldAssign_t;
 
-VeDirectFrameHandler::VeDirectFrameHandler() :
+static_assert(VE_FIELD_COUNT < 32, "present and changed masks hold 32 bits including VE_CHANGED_EXTRA");
+
+// Has to be in the same order as VeDirectField
+static const veFieldAssign_t veFieldAssignment[VE_FIELD_COUNT] = {
+	{ "PID", VE_TYPE_HEX16, offsetof(VeDirectRecord, PID) },
+	{ "SER", VE_TYPE_STR, offsetof(VeDirectRecord, SER) },
+	{ "FW", VE_TYPE_STR, offsetof(VeDirectRecord, FW) },
+	{ "LOAD", VE_TYPE_BOOL, offsetof(VeDirectRecord, LOAD) },
+	{ "CS", VE_TYPE_U8, offsetof(VeDirectRecord, CS) },
+	{ "ERR", VE_TYPE_U8, offsetof(VeDirectRecord, ERR) },
+	{ "OR", VE_TYPE_HEX32, offsetof(VeDirectRecord, OR) },
+	{ "MPPT", VE_TYPE_U8, offsetof(VeDirectRecord, MPPT) },
+	{ "HSDS", VE_TYPE_U16, offsetof(VeDirectRecord, HSDS) },
+	{ "V", VE_TYPE_I32, offsetof(VeDirectRecord, V) },
+	{ "I", VE_TYPE_I32, offsetof(VeDirectRecord, I) },
+	{ "VPV", VE_TYPE_I32, offsetof(VeDirectRecord, VPV) },
+	{ "PPV", VE_TYPE_I32, offsetof(VeDirectRecord, PPV) },
+	{ "IL", VE_TYPE_I32, offsetof(VeDirectRecord, IL) },
+	{ "H19", VE_TYPE_U32, offsetof(VeDirectRecord, H19) },
+	{ "H20", VE_TYPE_U32, offsetof(VeDirectRecord, H20) },
+	{ "H21", VE_TYPE_U32, offsetof(VeDirectRecord, H21) },
+	{ "H22", VE_TYPE_U32, offsetof(VeDirectRecord, H22) },
+	{ "H23", VE_TYPE_U32, offsetof(VeDirectRecord, H23) },
+	{ "VS", VE_TYPE_I32, offsetof(VeDirectRecord, VS) },
+	{ "VM", VE_TYPE_I32, offsetof(VeDirectRecord, VM) },
+	{ "DM", VE_TYPE_I32, offsetof(VeDirectRecord, DM) },
+	{ "T", VE_TYPE_I32, offsetof(VeDirectRecord, T) },
+	{ "P", VE_TYPE_I32, offsetof(VeDirectRecord, P) },
+	{ "CE", VE_TYPE_I32, offsetof(VeDirectRecord, CE) },
+	{ "SOC", VE_TYPE_U16, offsetof(VeDirectRecord, SOC) },
+	{ "TTG", VE_TYPE_I32, offsetof(VeDirectRecord, TTG) },
+	{ "ALARM", VE_TYPE_BOOL, offsetof(VeDirectRecord, ALARM) },
+	{ "RELAY", VE_TYPE_BOOL, offsetof(VeDirectRecord, RELAY) },
+	{ "AR", VE_TYPE_U16, offsetof(VeDirectRecord, AR) },
+	{ "MON", VE_TYPE_I32, offsetof(VeDirectRecord, MON) }
+};
+
+typedef struct {
+	uint32_t code;
+	const char* text;
+} veText_t;
+
+#define VE_TEXT_ENTRY(code, text) { code, text },
+
+static constexpr veText_t veProductTexts[] = { VE_PRODUCT_LIST(VE_TEXT_ENTRY) };
+static constexpr veText_t veStateTexts[] = { VE_STATE_LIST(VE_TEXT_ENTRY) };
+static constexpr veText_t veErrorTexts[] = { VE_ERROR_LIST(VE_TEXT_ENTRY) };
+static constexpr veText_t veOffReasonTexts[] = { VE_OFF_REASON_LIST(VE_TEXT_ENTRY) };
+static constexpr veText_t veMpptTexts[] = { VE_MPPT_LIST(VE_TEXT_ENTRY) };
+
+// lookupText() does a binary search, so the tables have to be sorted
+static constexpr bool isSorted(const veText_t* table, size_t count)
+{
+	return count < 2 || (table[0].code < table[1].code && isSorted(table + 1, count - 1));
+}
+#define VE_TEXT_TABLE_SORTED(table) static_assert(isSorted(table, sizeof(table) / sizeof(table[0])), #table " is not sorted by code")
+VE_TEXT_TABLE_SORTED(veProductTexts);
+VE_TEXT_TABLE_SORTED(veStateTexts);
+VE_TEXT_TABLE_SORTED(veErrorTexts);
+VE_TEXT_TABLE_SORTED(veOffReasonTexts);
+VE_TEXT_TABLE_SORTED(veMpptTexts);
+
+#define VE_SEMAPHORE_TAKE() xSemaphoreTake(_xSemaphore, portMAX_DELAY)
+#define VE_SEMAPHORE_GIVE() xSemaphoreGive(_xSemaphore)
+
+VeDirectFrameHandler::VeDirectFrameHandler(uint8_t uartNum) :
 	//mStop(false),	// don't know what Victron uses this for, not using
 	_state(IDLE),
+	_prevState(IDLE),
 	_checksum(0),
+	_textPointer(0),
 	_name(""),
 	_value(""),
-	_pollInterval(5),
-	_lastPoll(0)
+	_hexSize(0),
+	_seq(0),
+	_changed(0),
+	_lastPoll(0),
+	_rxEventTime(0),
+	_rxTaskHandle(nullptr),
+	_serial(uartNum),
+	_deviceName("")
+{
+	memset(&_snapshot[0].frame, 0, sizeof(_snapshot[0].frame));
+	memset(&_stats, 0, sizeof(_stats));
+	memset(&_reported, 0, sizeof(_reported));
+	memset(_deadband, 0, sizeof(_deadband));
+	updateFrameText(_snapshot[0], _snapshot[0], true);
+	_snapshot[1] = _snapshot[0];
+	for (uint8_t i = 0; i < VE_HEX_MAX_OUTSTANDING; i++) {
+		_hexRequests[i].active = false;
+	}
+}
+
+void VeDirectFrameHandler::init(int8_t rxPin, int8_t txPin)
+{
+    _xSemaphore = xSemaphoreCreateMutex();
+    VE_SEMAPHORE_GIVE(); // release before first use
+
+    _serial.setRxBufferSize(VE_RX_BUFFER_SIZE);
+    _serial.begin(19200, SERIAL_8N1, rxPin, txPin);
+    _serial.flush();
+
+    xTaskCreatePinnedToCore(rxTask, "vedirect", VE_TASK_STACK_SIZE, this, VE_TASK_PRIORITY, &_rxTaskHandle, VE_TASK_CORE);
+    _serial.onReceive(std::bind(&VeDirectFrameHandler::onReceive, this));
+    _serial.onReceiveError(std::bind(&VeDirectFrameHandler::onReceiveError, this, std::placeholders::_1));
+}
+
+void VeDirectFrameHandler::setName(const char* name)
+{
+	strlcpy(_deviceName, name, sizeof(_deviceName));
+}
+
+const char* VeDirectFrameHandler::name()
+{
+	return _deviceName;
+}
+
+/*
+ * onReceive
+ * This function is called from the HardwareSerial event task every time data was received.
+ * It only wakes up the rx task which does the parsing.
+ */
+void VeDirectFrameHandler::onReceive()
+{
+	_rxEventTime = esp_timer_get_time();
+	xTaskNotifyGive(_rxTaskHandle);
+}
+
+/*
+ * onReceiveError
+ * This function is called from the HardwareSerial event task if received data was lost or corrupted.
+ */
+void VeDirectFrameHandler::onReceiveError(hardwareSerial_error_t error)
 {
+	switch (error) {
+	case UART_BUFFER_FULL_ERROR:
+	case UART_FIFO_OVF_ERROR:
+		_stats.uartOverruns++;
+		break;
+	case UART_BREAK_ERROR:
+	case UART_FRAME_ERROR:
+	case UART_PARITY_ERROR:
+		_stats.uartFrameErrors++;
+		break;
+	default:
+		break;
+	}
 }
 
-void VeDirectFrameHandler::init()
+/*
+ * rxTask
+ * Every device has its own task. Every byte is decoded as soon as it arrives. This prevents overflows of the uart hardware fifo
+ * which would result in frames starting in the middle and therefore failing checksums.
+ */
+void VeDirectFrameHandler::rxTask(void* parameter)
 {
-    VedirectSerial.begin(19200, SERIAL_8N1, VICTRON_PIN_RX, VICTRON_PIN_TX);
-    VedirectSerial.flush();
+	VeDirectFrameHandler* handler = static_cast<VeDirectFrameHandler*>(parameter);
+	uint8_t buffer[VE_RX_CHUNK_SIZE];
+
+	for (;;) {
+		ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(VE_TASK_WAKEUP_PERIOD));
+
+		// read in chunks, every single read() locks the uart driver
+		size_t len;
+		while ( (len = handler->_serial.available()) > 0) {
+			len = handler->_serial.read(buffer, min(len, sizeof(buffer)));
+			handler->feed(buffer, len);
+		}
+
+		handler->checkHexTimeouts();
+	}
 }
 
-void VeDirectFrameHandler::setPollInterval(unsigned long interval)
+/*
+ * feed
+ * This function passes a chunk of received data to the parser. Besides the rx task it can be used
+ * to replay recorded data, the result is the same as if it was received from the device.
+ */
+void VeDirectFrameHandler::feed(const uint8_t* data, size_t len)
 {
-    _pollInterval = interval;
+	_stats.bytes += len;
+	for (size_t i = 0; i < len; i++) {
+		rxData(data[i]);
+	}
 }
 
-void VeDirectFrameHandler::loop()
+/*
+ * updateLinkStats
+ * This function is called after a frame was published. A long gap between frames means data was lost
+ * on the cable, a high latency that the rx task did not get the cpu in time.
+ */
+void VeDirectFrameHandler::updateLinkStats()
 {
-	if ((millis() - getLastUpdate()) < _pollInterval * 1000) {
+	if (_lastPoll > 0 && millis() - _lastPoll > _stats.maxFrameGap) {
+		_stats.maxFrameGap = millis() - _lastPoll;
+	}
+
+	// no uart event if the data was passed to feed() by other means
+	if (_rxEventTime == 0) {
 		return;
 	}
-	
-	while ( VedirectSerial.available()) {
-		rxData(VedirectSerial.read());
+
+	uint32_t latency = static_cast<uint32_t>(esp_timer_get_time()) - _rxEventTime;
+	_stats.latencySum += latency;
+
+	uint8_t bucket = 0;
+	latency >>= VE_LATENCY_MIN_BITS;
+	while (latency > 0 && bucket < VE_LATENCY_BUCKETS - 1) {
+		latency >>= 1;
+		bucket++;
 	}
+	_stats.latency[bucket]++;
+}
+
+uint32_t VeDirectFrameHandler::getLatencyBucketLimit(uint8_t bucket)
+{
+	if (bucket >= VE_LATENCY_BUCKETS - 1) {
+		return 0;
+	}
+	return 1UL << (bucket + VE_LATENCY_MIN_BITS);
+}
+
+/*
+ * getParserStats
+ * This function returns a copy of the parser and uart counters. Every counter is only incremented
+ * by a single task, so every single counter is consistent.
+ */
+void VeDirectFrameHandler::getParserStats(VeDirectParserStats& stats)
+{
+	stats = _stats;
 }
 
 /*
  *	rxData
- *  This function is called by loop() which passes a byte of serial data
- *  Based on Victron's example code. But using String and Map instead of pointer and arrays
+ *  This function is called by feed() which passes a byte of serial data
+ *  Based on Victron's example code. Name and value are collected in fixed size buffers
+ *  and decoded into a VeDirectRecord, so no heap allocation is done while parsing.
  */
 void VeDirectFrameHandler::rxData(uint8_t inbyte)
 {
 	//if (mStop) return;
 	if ( (inbyte == ':') && (_state != CHECKSUM) ) {
+		// a hex frame may interrupt a text frame, continue the text frame afterwards
+		if (_state != RECORD_HEX) {
+			_prevState = _state;
+		}
 		_state = RECORD_HEX;
+		_hexSize = 0;
+		return;
 	}
 	if (_state != RECORD_HEX) {
 		_checksum += inbyte;
@@ -107,7 +335,8 @@ void VeDirectFrameHandler::rxData(uint8_t inbyte)
 		}
 		break;
 	case RECORD_BEGIN:
-		_name = (char) inbyte;
+		_textPointer = _name;
+		*_textPointer++ = inbyte;
 		_state = RECORD_NAME;
 		break;
 	case RECORD_NAME:
@@ -115,18 +344,22 @@ void VeDirectFrameHandler::rxData(uint8_t inbyte)
 		switch(inbyte) {
 		case '\t':
 			// the Checksum record indicates a EOR
-			if (_name.equals(checksumTagName)) {
-				_state = CHECKSUM;
-				break;
+			if ( _textPointer < (_name + sizeof(_name)) ) {
+				*_textPointer = 0; /* Zero terminate */
+				if (strcmp(_name, checksumTagName) == 0) {
+					_state = CHECKSUM;
+					break;
+				}
 			}
+			_textPointer = _value; /* Reset value pointer */
 			_state = RECORD_VALUE;
-			_value = "";
 			break;
 		case '#': /* Ignore # from serial number*/
 			break;
 		default:
 			// add byte to name, but do no overflow
-			_name += (char) inbyte;
+			if ( _textPointer < (_name + sizeof(_name) - 1) )
+				*_textPointer++ = inbyte;
 			break;
 		}
 		break;
@@ -134,48 +367,379 @@ void VeDirectFrameHandler::rxData(uint8_t inbyte)
 		// The record value is being received.  The \r indicates a new record.
 		switch(inbyte) {
 		case '\n':
-			_tmpMap[_name] = _value;
+			if ( _textPointer < (_value + sizeof(_value)) ) {
+				*_textPointer = 0; // make zero ended
+				textRxEvent(_name, _value);
+			}
 			_state = RECORD_BEGIN;
 			break;
 		case '\r': /* Skip */
 			break;
 		default:
 			// add byte to value, but do no overflow
-			_value += (char) inbyte;
+			if ( _textPointer < (_value + sizeof(_value) - 1) )
+				*_textPointer++ = inbyte;
 			break;
 		}
 		break;
 	case CHECKSUM:
 	{
 		bool valid = _checksum == 0;
-		if (!valid)
+		if (valid) {
+			_stats.frames++;
+		} else {
+			_stats.checksumErrors++;
 			logE(MODULE,"[CHECKSUM] Invalid frame");
+		}
 		_checksum = 0;
 		_state = IDLE;
 		frameEndEvent(valid);
 		break;
 	}
 	case RECORD_HEX:
+		// hex frames are not part of the text frame checksum
 		if (hexRxEvent(inbyte)) {
-			_checksum = 0;
-			_state = IDLE;
+			_state = _prevState;
 		}
 		break;
 	}
 }
 
+static bool isNumber(const char* value)
+{
+	char* end;
+	strtol(value, &end, 0);
+	return end != value;
+}
+
+/*
+ * textRxEvent
+ * This function is called every time a new name/value is successfully parsed. It decodes the value
+ * according to veFieldAssignment into the temp record. Unknown names and numeric fields with a value
+ * which is not a number (e.g. "---" if not available) are passed through as text.
+ */
+void VeDirectFrameHandler::textRxEvent(const char* name, const char* value)
+{
+	VeDirectRecord& frame = backBuffer().frame;
+
+	for (uint8_t field = 0; field < VE_FIELD_COUNT; field++) {
+		const veFieldAssign_t* f = &veFieldAssignment[field];
+		if (strcmp(name, f->name) != 0) {
+			continue;
+		}
+		if (f->type != VE_TYPE_BOOL && f->type != VE_TYPE_STR && !isNumber(value)) {
+			break;
+		}
+
+		uint8_t* ptr = reinterpret_cast<uint8_t*>(&frame) + f->offset;
+		switch (f->type) {
+		case VE_TYPE_BOOL:
+			*reinterpret_cast<bool*>(ptr) = (strcmp(value, "ON") == 0);
+			break;
+		case VE_TYPE_U8:
+			*ptr = static_cast<uint8_t>(strtoul(value, nullptr, 0));
+			break;
+		case VE_TYPE_U16:
+		case VE_TYPE_HEX16:
+			*reinterpret_cast<uint16_t*>(ptr) = static_cast<uint16_t>(strtoul(value, nullptr, 0));
+			break;
+		case VE_TYPE_U32:
+		case VE_TYPE_HEX32:
+			*reinterpret_cast<uint32_t*>(ptr) = strtoul(value, nullptr, 0);
+			break;
+		case VE_TYPE_I32:
+			*reinterpret_cast<int32_t*>(ptr) = strtol(value, nullptr, 10);
+			break;
+		case VE_TYPE_STR:
+			strlcpy(reinterpret_cast<char*>(ptr), value, VE_MAX_VALUE_LEN);
+			break;
+		}
+		frame.present |= (1UL << field);
+		return;
+	}
+
+	if (frame.extraCount < VE_MAX_EXTRA_FIELDS) {
+		VeDirectExtraField& extra = frame.extra[frame.extraCount++];
+		strlcpy(extra.name, name, sizeof(extra.name));
+		strlcpy(extra.value, value, sizeof(extra.value));
+	}
+}
+
+/*
+ * backBuffer
+ * The snapshot which is not published. It is only accessed by the parser which decodes the
+ * received name/value pairs directly into it.
+ */
+VeDirectFrameHandler::Snapshot& VeDirectFrameHandler::backBuffer()
+{
+	return _snapshot[(_seq.load(std::memory_order_relaxed) + 1) & 1];
+}
+
 /*
  *	frameEndEvent
- *  This function is called at the end of the received frame.  If the checksum is valid, the temp buffer is read line by line.
- *  If the name exists in the public buffer, the new value is copied to the public buffer.	If not, a new name/value entry
- *  is created in the public buffer.
+ *  This function is called at the end of the received frame.  If the checksum is valid, the back buffer
+ *  is published by incrementing the sequence number. The new back buffer is cleared in any case.
+ *  It is the snapshot published before, readers may still be copying it. The release store makes
+ *  the frame visible before the new sequence number, the fence after it makes the new sequence
+ *  number visible before the old snapshot is overwritten. A reader which copied any of these
+ *  writes therefore sees a different sequence number afterwards and repeats the copy.
  */
 void VeDirectFrameHandler::frameEndEvent(bool valid) {
 	if ( valid ) {
-		veMap = _tmpMap;
+		uint32_t seq = _seq.load(std::memory_order_relaxed);
+		Snapshot& next = _snapshot[(seq + 1) & 1];
+		uint32_t changed = getChangedFields(next.frame);
+		updateFrameText(next, _snapshot[seq & 1], false);
+
+		_seq.store(seq + 1, std::memory_order_release);
+		std::atomic_thread_fence(std::memory_order_release);
+		// after publishing, see getChangedFrame()
+		_changed.fetch_or(changed, std::memory_order_release);
+
+		updateLinkStats();
 		setLastUpdate();
 	}
-	_tmpMap.clear();
+	memset(&backBuffer().frame, 0, sizeof(VeDirectRecord));
+}
+
+static size_t getFieldSize(uint8_t type)
+{
+	switch (type) {
+	case VE_TYPE_BOOL:
+		return sizeof(bool);
+	case VE_TYPE_U8:
+		return sizeof(uint8_t);
+	case VE_TYPE_U16:
+	case VE_TYPE_HEX16:
+		return sizeof(uint16_t);
+	case VE_TYPE_STR:
+		return VE_MAX_VALUE_LEN;
+	default:
+		return sizeof(uint32_t);
+	}
+}
+
+static int64_t getFieldValue(const VeDirectRecord& frame, const veFieldAssign_t* f)
+{
+	const uint8_t* ptr = reinterpret_cast<const uint8_t*>(&frame) + f->offset;
+	switch (f->type) {
+	case VE_TYPE_BOOL:
+		return *reinterpret_cast<const bool*>(ptr);
+	case VE_TYPE_U8:
+		return *ptr;
+	case VE_TYPE_U16:
+	case VE_TYPE_HEX16:
+		return *reinterpret_cast<const uint16_t*>(ptr);
+	case VE_TYPE_U32:
+	case VE_TYPE_HEX32:
+		return *reinterpret_cast<const uint32_t*>(ptr);
+	case VE_TYPE_I32:
+		return *reinterpret_cast<const int32_t*>(ptr);
+	default:
+		return 0;
+	}
+}
+
+/*
+ * getChangedFields
+ * This function compares a new frame with the values reported as changed before. A numeric field
+ * is changed if it differs by more than its deadband, all others if they differ at all. Fields
+ * not reported before are always changed. The extra fields are compared as a whole.
+ */
+uint32_t VeDirectFrameHandler::getChangedFields(const VeDirectRecord& frame)
+{
+	uint32_t changed = 0;
+
+	for (uint8_t field = 0; field < VE_FIELD_COUNT; field++) {
+		const veFieldAssign_t* f = &veFieldAssignment[field];
+		uint32_t bit = 1UL << field;
+		if (!(frame.present & bit)) {
+			continue;
+		}
+
+		bool isChanged;
+		if (!(_reported.present & bit)) {
+			isChanged = true;
+		} else if (f->type == VE_TYPE_STR) {
+			isChanged = strcmp(reinterpret_cast<const char*>(&frame) + f->offset, reinterpret_cast<const char*>(&_reported) + f->offset) != 0;
+		} else {
+			int64_t diff = getFieldValue(frame, f) - getFieldValue(_reported, f);
+			isChanged = (diff > _deadband[field]) || (-diff > _deadband[field]);
+		}
+
+		if (isChanged) {
+			memcpy(reinterpret_cast<uint8_t*>(&_reported) + f->offset, reinterpret_cast<const uint8_t*>(&frame) + f->offset, getFieldSize(f->type));
+			changed |= bit;
+		}
+	}
+	_reported.present = (_reported.present | changed) & frame.present;
+
+	if (frame.extraCount != _reported.extraCount
+		|| memcmp(frame.extra, _reported.extra, frame.extraCount * sizeof(VeDirectExtraField)) != 0) {
+		_reported.extraCount = frame.extraCount;
+		memcpy(_reported.extra, frame.extra, frame.extraCount * sizeof(VeDirectExtraField));
+		changed |= VE_CHANGED_EXTRA;
+	}
+
+	return changed;
+}
+
+/*
+ * setDeadband
+ * Changes of a numeric field smaller or equal than deadband (in units of VeDirectRecord) are not
+ * marked as changed.
+ */
+void VeDirectFrameHandler::setDeadband(uint8_t field, uint32_t deadband)
+{
+	if (field >= VE_FIELD_COUNT) {
+		return;
+	}
+	switch (veFieldAssignment[field].type) {
+	case VE_TYPE_U8:
+	case VE_TYPE_U16:
+	case VE_TYPE_U32:
+	case VE_TYPE_I32:
+		_deadband[field] = deadband;
+		break;
+	default:
+		break;
+	}
+}
+
+/*
+ * getChangedFrame
+ * This function returns a copy of the last valid frame and a bit mask of the fields which changed
+ * since the last call. It is meant for a single consumer as every call clears the mask.
+ */
+uint32_t VeDirectFrameHandler::getChangedFrame(VeDirectRecord& frame)
+{
+	// fetch the mask before the frame, so the frame is at least as new as the mask.
+	// Changes of a newer frame may be reported twice but never get lost.
+	uint32_t changed = _changed.exchange(0, std::memory_order_acquire);
+	readSnapshot(&frame, nullptr);
+	return changed;
+}
+
+/*
+ * updateFrameText
+ * This function looks up the readable texts of the coded fields of a new frame. Only codes which
+ * differ from the last valid frame are looked up again.
+ */
+void VeDirectFrameHandler::updateFrameText(Snapshot& next, const Snapshot& prev, bool force)
+{
+	const VeDirectRecord& frame = next.frame;
+	next.text = prev.text;
+
+	if (force || frame.PID != prev.frame.PID) {
+		next.text.PID = getPidAsString(frame.PID);
+	}
+	if (force || frame.CS != prev.frame.CS) {
+		next.text.CS = getCsAsString(frame.CS);
+	}
+	if (force || frame.ERR != prev.frame.ERR) {
+		next.text.ERR = getErrAsString(frame.ERR);
+	}
+	if (force || frame.OR != prev.frame.OR) {
+		next.text.OR = getOrAsString(frame.OR);
+	}
+	if (force || frame.MPPT != prev.frame.MPPT) {
+		next.text.MPPT = getMpptAsString(frame.MPPT);
+	}
+}
+
+/*
+ * getFrame
+ * This function returns a copy of the last valid frame. It is safe to be called from any task
+ * and never blocks the parser.
+ */
+void VeDirectFrameHandler::getFrame(VeDirectRecord& frame)
+{
+	readSnapshot(&frame, nullptr);
+}
+
+/*
+ * getFrame
+ * This function returns a copy of the last valid frame together with the readable texts of its coded fields.
+ */
+void VeDirectFrameHandler::getFrame(VeDirectRecord& frame, VeDirectRecordText& text)
+{
+	readSnapshot(&frame, &text);
+}
+
+/*
+ * readSnapshot
+ * This function copies the published snapshot without blocking the parser. The parser only writes
+ * the other buffer until it publishes the next frame and then starts to clear this one. The acquire
+ * load pairs with the release store in frameEndEvent(), the acquire fence keeps the copy before the
+ * second load of the sequence number. If it changed, the copy may be torn and is repeated. With one
+ * frame per second this is rarely the case. The copy goes directly to the caller, the record is too
+ * large for another copy on the stack.
+ */
+void VeDirectFrameHandler::readSnapshot(VeDirectRecord* frame, VeDirectRecordText* text)
+{
+	uint32_t seq;
+	do {
+		seq = _seq.load(std::memory_order_acquire);
+		*frame = _snapshot[seq & 1].frame;
+		if (text != nullptr) {
+			*text = _snapshot[seq & 1].text;
+		}
+		std::atomic_thread_fence(std::memory_order_acquire);
+	} while (seq != _seq.load(std::memory_order_relaxed));
+}
+
+/*
+ * getFieldName
+ * This function returns the label of a field as it is sent by the device.
+ */
+const char* VeDirectFrameHandler::getFieldName(uint8_t field)
+{
+	if (field >= VE_FIELD_COUNT) {
+		return "";
+	}
+	return veFieldAssignment[field].name;
+}
+
+/*
+ * getFieldAsString
+ * This function writes the value of a field in the format of the VE.Direct text protocol into buffer.
+ * Returns false if the field was not part of the frame.
+ */
+bool VeDirectFrameHandler::getFieldAsString(const VeDirectRecord& frame, uint8_t field, char* buffer, size_t len)
+{
+	if (field >= VE_FIELD_COUNT || !(frame.present & (1UL << field))) {
+		return false;
+	}
+
+	const veFieldAssign_t* f = &veFieldAssignment[field];
+	const uint8_t* ptr = reinterpret_cast<const uint8_t*>(&frame) + f->offset;
+	switch (f->type) {
+	case VE_TYPE_BOOL:
+		strlcpy(buffer, *reinterpret_cast<const bool*>(ptr) ? "ON" : "OFF", len);
+		break;
+	case VE_TYPE_U8:
+		snprintf(buffer, len, "%u", *ptr);
+		break;
+	case VE_TYPE_U16:
+		snprintf(buffer, len, "%u", *reinterpret_cast<const uint16_t*>(ptr));
+		break;
+	case VE_TYPE_HEX16:
+		snprintf(buffer, len, "0x%04X", *reinterpret_cast<const uint16_t*>(ptr));
+		break;
+	case VE_TYPE_U32:
+		snprintf(buffer, len, "%u", *reinterpret_cast<const uint32_t*>(ptr));
+		break;
+	case VE_TYPE_HEX32:
+		snprintf(buffer, len, "0x%08X", *reinterpret_cast<const uint32_t*>(ptr));
+		break;
+	case VE_TYPE_I32:
+		snprintf(buffer, len, "%d", *reinterpret_cast<const int32_t*>(ptr));
+		break;
+	case VE_TYPE_STR:
+		strlcpy(buffer, reinterpret_cast<const char*>(ptr), len);
+		break;
+	}
+	return true;
 }
 
 /*
@@ -190,437 +754,396 @@ void VeDirectFrameHandler::logE(const char * module, const char * error) {
 	return;
 }
 
+static int8_t hexNibble(char c)
+{
+	if (c >= '0' && c <= '9') {
+		return c - '0';
+	}
+	if (c >= 'A' && c <= 'F') {
+		return c - 'A' + 10;
+	}
+	return -1;
+}
+
 /*
  *	hexRxEvent
- *  This function included for continuity and possible future use.	
+ *  This function collects the characters of a hex frame between ':' and '\n'.
+ *  Returns true if the hex frame is complete and the text frame can be continued.
  */
 bool VeDirectFrameHandler::hexRxEvent(uint8_t inbyte) {
-	return true;		// stubbed out for future
-}
-
-unsigned long VeDirectFrameHandler::getLastUpdate()
-{
-    return _lastPoll;
+	switch (inbyte) {
+	case '\n':
+		hexFrameEvent();
+		return true;
+	case '\r': /* Skip */
+		return false;
+	default:
+		if (_hexSize < sizeof(_hexBuffer)) {
+			_hexBuffer[_hexSize++] = inbyte;
+			return false;
+		}
+		// no hex frame is that long, we lost sync with the device
+		_stats.hexErrors++;
+		logE(MODULE, "[HEX] Frame too long");
+		_prevState = IDLE;
+		return true;
+	}
 }
 
 /*
- * setLastUpdate
- * This function is called every time a new ve.direct frame was read.
+ *	hexFrameEvent
+ *  This function decodes a complete hex frame. It consists of the command nibble followed by
+ *  data bytes and the checksum byte, two characters each. All bytes sum up to 0x55.
  */
-void VeDirectFrameHandler::setLastUpdate()
+void VeDirectFrameHandler::hexFrameEvent()
 {
-    _lastPoll = millis();
+	if (_hexSize < 3 || (_hexSize % 2) == 0) {
+		_stats.hexErrors++;
+		logE(MODULE, "[HEX] Invalid frame length");
+		return;
+	}
+
+	int8_t command = hexNibble(_hexBuffer[0]);
+	if (command < 0) {
+		_stats.hexErrors++;
+		logE(MODULE, "[HEX] Invalid character");
+		return;
+	}
+
+	uint8_t data[VE_MAX_HEX_LEN / 2];
+	uint8_t len = 0;
+	uint8_t checksum = command;
+	for (uint8_t i = 1; i < _hexSize; i += 2) {
+		int8_t high = hexNibble(_hexBuffer[i]);
+		int8_t low = hexNibble(_hexBuffer[i + 1]);
+		if (high < 0 || low < 0) {
+			_stats.hexErrors++;
+		logE(MODULE, "[HEX] Invalid character");
+			return;
+		}
+		data[len] = (high << 4) | low;
+		checksum += data[len++];
+	}
+	if (checksum != 0x55) {
+		_stats.hexErrors++;
+		logE(MODULE, "[HEX] Invalid checksum");
+		return;
+	}
+	len--; // strip checksum byte
+
+	VeDirectHexData rsp = {};
+	rsp.response = command;
+	uint8_t valueOffset = 0;
+
+	switch (command) {
+	case VE_HEX_RSP_GET:
+	case VE_HEX_RSP_SET:
+	case VE_HEX_RSP_ASYNC:
+		// register id (little endian) and flags precede the value
+		if (len < 3) {
+			_stats.hexErrors++;
+		logE(MODULE, "[HEX] Invalid register frame");
+			return;
+		}
+		rsp.id = data[0] | (data[1] << 8);
+		rsp.flags = data[2];
+		valueOffset = 3;
+		break;
+	case VE_HEX_RSP_DONE:
+	case VE_HEX_RSP_UNKNOWN:
+	case VE_HEX_RSP_ERROR:
+	case VE_HEX_RSP_PING:
+		break;
+	default:
+		return;
+	}
+	_stats.hexFrames++;
+
+	rsp.size = min(len - valueOffset, 4);
+	for (uint8_t i = 0; i < rsp.size; i++) {
+		rsp.value |= static_cast<uint32_t>(data[valueOffset + i]) << (8 * i);
+	}
+
+	if (command == VE_HEX_RSP_ASYNC) {
+		VE_SEMAPHORE_TAKE();
+		VeDirectHexCallback callback = _hexAsyncCallback;
+		VE_SEMAPHORE_GIVE();
+		if (callback) {
+			callback(rsp);
+		}
+		return;
+	}
+
+	hexComplete(rsp);
 }
 
 /*
- * getPidAsString
- * This function returns the product id (PID) as readable text.
+ *	hexComplete
+ *  This function passes a response to the oldest pending request it belongs to. Responses to
+ *  get and set carry the register id, all others are assigned by their command.
  */
-String VeDirectFrameHandler::getPidAsString(const char* pid)
+void VeDirectFrameHandler::hexComplete(const VeDirectHexData& data)
 {
-	String strPID ="";
+	VeDirectHexCallback callback;
+	int8_t oldest = -1;
 
-	long lPID = strtol(pid, nullptr, 0);
-	switch(lPID) {
-		case 0x0300:
-			strPID =  "BlueSolar MPPT 70|15";
-			break;
-		case 0xA040:
-			strPID =  "BlueSolar MPPT 75|50";
-			break;
-		case 0xA041:
-			strPID =  "BlueSolar MPPT 150|35";
-			break;
-		case 0xA042:
-			strPID =  "BlueSolar MPPT 75|15";
-			break;
-		case 0xA043:
-			strPID =  "BlueSolar MPPT 100|15";
-			break;
-		case 0xA044:
-			strPID =  "BlueSolar MPPT 100|30";
-			break;
-		case 0xA045:
-			strPID =  "BlueSolar MPPT 100|50";
-			break;
-		case 0xA046:
-			strPID =  "BlueSolar MPPT 100|70";
-			break;
-		case 0xA047:
-			strPID =  "BlueSolar MPPT 150|100";
-			break;
-		case 0xA049:
-			strPID =  "BlueSolar MPPT 100|50 rev2";
-			break;
-		case 0xA04A:
-			strPID =  "BlueSolar MPPT 100|30 rev2";
-			break;
-		case 0xA04B:
-			strPID =  "BlueSolar MPPT 150|35 rev2";
-			break;
-		case 0XA04C:
-			strPID =  "BlueSolar MPPT 75|10";
-			break;
-		case 0XA04D:
-			strPID =  "BlueSolar MPPT 150|45";
-			break;
-		case 0XA04E:
-			strPID =  "BlueSolar MPPT 150|60";
-			break;
-		case 0XA04F:
-			strPID =  "BlueSolar MPPT 150|85";
-			break;
-		case 0XA050:
-			strPID =  "SmartSolar MPPT 250|100";
-			break;
-		case 0XA051:
-			strPID =  "SmartSolar MPPT 150|100";
-			break;
-		case 0XA052:
-			strPID =  "SmartSolar MPPT 150|85";
-			break;
-		case 0XA053:
-			strPID =  "SmartSolar MPPT 75|15";
-			break;
-		case 0XA054:
-			strPID =  "SmartSolar MPPT 75|10";
-			break;
-		case 0XA055:
-			strPID =  "SmartSolar MPPT 100|15";
-			break;
-		case 0XA056:
-			strPID =  "SmartSolar MPPT 100|30";
-			break;
-		case 0XA057:
-			strPID =  "SmartSolar MPPT 100|50";
-			break;
-		case 0XA058:
-			strPID =  "SmartSolar MPPT 100|35";
-			break;
-		case 0XA059:
-			strPID =  "SmartSolar MPPT 150|10 rev2";
-			break;
-		case 0XA05A:
-			strPID =  "SmartSolar MPPT 150|85 rev2";
-			break;
-		case 0XA05B:
-			strPID =  "SmartSolar MPPT 250|70";
-			break;
-		case 0XA05C:
-			strPID =  "SmartSolar MPPT 250|85";
-			break;
-		case 0XA05D:
-			strPID =  "SmartSolar MPPT 250|60";
-			break;
-		case 0XA05E:
-			strPID =  "SmartSolar MPPT 250|45";
-			break;
-		case 0XA05F:
-			strPID =  "SmartSolar MPPT 100|20";
-			break;
-		case 0XA060:
-			strPID =  "SmartSolar MPPT 100|20 48V";
-			break;
-		case 0XA061:
-			strPID =  "SmartSolar MPPT 150|45";
-			break;
-		case 0XA062:
-			strPID =  "SmartSolar MPPT 150|60";
-			break;
-		case 0XA063:
-			strPID =  "SmartSolar MPPT 150|70";
-			break;
-		case 0XA064:
-			strPID =  "SmartSolar MPPT 250|85 rev2";
-			break;
-		case 0XA065:
-			strPID =  "SmartSolar MPPT 250|100 rev2";
-			break;
-		case 0XA066:
-			strPID =  "BlueSolar MPPT 100|20";
-			break;
-		case 0XA067:
-			strPID =  "BlueSolar MPPT 100|20 48V";
-			break;
-		case 0XA068:
-			strPID =  "SmartSolar MPPT 250|60 rev2";
-			break;
-		case 0XA069:
-			strPID =  "SmartSolar MPPT 250|70 rev2";
-			break;
-		case 0XA06A:
-			strPID =  "SmartSolar MPPT 150|45 rev2";
-			break;
-		case 0XA06B:
-			strPID =  "SmartSolar MPPT 150|60 rev2";
-			break;
-		case 0XA06C:
-			strPID =  "SmartSolar MPPT 150|70 rev2";
-			break;
-		case 0XA06D:
-			strPID =  "SmartSolar MPPT 150|85 rev3";
-			break;
-		case 0XA06E:
-			strPID =  "SmartSolar MPPT 150|100 rev3";
-			break;
-		case 0XA06F:
-			strPID =  "BlueSolar MPPT 150|45 rev2";
-			break;
-		case 0XA070:
-			strPID =  "BlueSolar MPPT 150|60 rev2";
-			break;
-		case 0XA071:
-			strPID =  "BlueSolar MPPT 150|70 rev2";
-			break;
-		case 0XA102:
-			strPID =  "SmartSolar MPPT VE.Can 150|70";
-			break;
-		case 0XA103:
-			strPID =  "SmartSolar MPPT VE.Can 150|45";
-			break;
-		case 0XA104:
-			strPID =  "SmartSolar MPPT VE.Can 150|60";
-			break;
-		case 0XA105:
-			strPID =  "SmartSolar MPPT VE.Can 150|85";
-			break;
-		case 0XA106:
-			strPID =  "SmartSolar MPPT VE.Can 150|100";
-			break;
-		case 0XA107:
-			strPID =  "SmartSolar MPPT VE.Can 250|45";
-			break;
-		case 0XA108:
-			strPID =  "SmartSolar MPPT VE.Can 250|60";
-			break;
-		case 0XA109:
-			strPID =  "SmartSolar MPPT VE.Can 250|80";
-			break;
-		case 0XA10A:
-			strPID =  "SmartSolar MPPT VE.Can 250|85";
-			break;
-		case 0XA10B:
-			strPID =  "SmartSolar MPPT VE.Can 250|100";
-			break;
-		case 0XA10C:
-			strPID =  "SmartSolar MPPT VE.Can 150|70 rev2";
-			break;
-		case 0XA10D:
-			strPID =  "SmartSolar MPPT VE.Can 150|85 rev2";
-			break;
-		case 0XA10E:
-			strPID =  "SmartSolar MPPT VE.Can 150|100 rev2";
-			break;
-		case 0XA10F:
-			strPID =  "BlueSolar MPPT VE.Can 150|100";
-			break;
-		case 0XA112:
-			strPID =  "BlueSolar MPPT VE.Can 250|70";
-			break;
-		case 0XA113:
-			strPID =  "BlueSolar MPPT VE.Can 250|100";
-			break;
-		case 0XA114:
-			strPID =  "SmartSolar MPPT VE.Can 250|70 rev2";
+	VE_SEMAPHORE_TAKE();
+	for (uint8_t i = 0; i < VE_HEX_MAX_OUTSTANDING; i++) {
+		const HexRequest& req = _hexRequests[i];
+		if (!req.active) {
+			continue;
+		}
+
+		bool match;
+		switch (data.response) {
+		case VE_HEX_RSP_GET:
+		case VE_HEX_RSP_SET:
+			match = (req.command == data.response) && (req.id == data.id);
 			break;
-		case 0XA115:
-			strPID =  "SmartSolar MPPT VE.Can 250|100 rev2";
+		case VE_HEX_RSP_PING:
+			match = (req.command == VE_HEX_CMD_PING);
 			break;
-		case 0XA116:
-			strPID =  "SmartSolar MPPT VE.Can 250|85 rev2";
+		case VE_HEX_RSP_DONE:
+			match = (req.command == VE_HEX_CMD_APP_VERSION) || (req.command == VE_HEX_CMD_PRODUCT_ID);
 			break;
 		default:
-			strPID = pid;
+			// unknown command or framing error, belongs to the oldest request
+			match = true;
+			break;
+		}
+
+		if (match && (oldest < 0 || static_cast<int32_t>(req.sentAt - _hexRequests[oldest].sentAt) < 0)) {
+			oldest = i;
+		}
+	}
+	if (oldest >= 0) {
+		callback = std::move(_hexRequests[oldest].callback);
+		_hexRequests[oldest].callback = nullptr;
+		_hexRequests[oldest].active = false;
+	}
+	VE_SEMAPHORE_GIVE();
+
+	if (callback) {
+		callback(data);
 	}
-	return strPID;
 }
 
 /*
- * getCsAsString
- * This function returns the state of operations (CS) as readable text.
+ *	checkHexTimeouts
+ *  This function is called periodically by rxTask() and frees the slots of requests
+ *  the device did not answer. Their callbacks get a VE_HEX_RSP_TIMEOUT response.
  */
-String VeDirectFrameHandler::getCsAsString(const char* cs)
+void VeDirectFrameHandler::checkHexTimeouts()
 {
-	String strCS ="";
+	VeDirectHexCallback callbacks[VE_HEX_MAX_OUTSTANDING];
+	uint16_t ids[VE_HEX_MAX_OUTSTANDING];
+	uint8_t count = 0;
+	uint32_t now = millis();
 
-	int iCS = atoi(cs);
-	switch(iCS) {
-		case 0:
-			strCS =  "OFF";
-			break;
-		case 2:
-			strCS =  "Fault";
-			break;
-		case 3:
-			strCS =  "Bulk";
-			break;
-		case 4:
-			strCS =  "Absorbtion";
-			break;
-		case 5:
-			strCS =  "Float";
-			break;
-		case 7:
-			strCS =  "Equalize (manual)";
-			break;
-		case 245:
-			strCS =  "Starting-up";
-			break;
-		case 247:
-			strCS =  "Auto equalize / Recondition";
-			break;
-		case 252:
-			strCS =  "External Control";
-			break;
-		default:
-			strCS = cs;
+	VE_SEMAPHORE_TAKE();
+	for (uint8_t i = 0; i < VE_HEX_MAX_OUTSTANDING; i++) {
+		HexRequest& req = _hexRequests[i];
+		if (req.active && (now - req.sentAt > VE_HEX_TIMEOUT)) {
+			ids[count] = req.id;
+			callbacks[count++] = std::move(req.callback);
+			req.callback = nullptr;
+			req.active = false;
+		}
+	}
+	VE_SEMAPHORE_GIVE();
+
+	for (uint8_t i = 0; i < count; i++) {
+		if (callbacks[i]) {
+			VeDirectHexData rsp = {};
+			rsp.response = VE_HEX_RSP_TIMEOUT;
+			rsp.id = ids[i];
+			callbacks[i](rsp);
+		}
 	}
-	return strCS;
 }
 
 /*
- * getErrAsString
- * This function returns error state (ERR) as readable text.
+ *	hexTx
+ *  This function encodes and sends a hex frame and reserves a slot for the response.
+ *  Returns false if too many requests are pending.
  */
-String VeDirectFrameHandler::getErrAsString(const char* err)
+bool VeDirectFrameHandler::hexTx(uint8_t command, const uint8_t* data, uint8_t len, uint16_t id, VeDirectHexCallback callback)
 {
-	String strERR ="";
+	static const char hexChars[] = "0123456789ABCDEF";
 
-	int iERR = atoi(err);
-	switch(iERR) {
-		case 0:
-			strERR =  "No error";
-			break;
-		case 2:
-			strERR =  "Battery voltage too high";
-			break;
-		case 17:
-			strERR =  "Charger temperature too high";
-			break;
-		case 18:
-			strERR =  "Charger over current";
-			break;
-		case 19:
-			strERR =  "Charger current reversed";
-			break;
-		case 20:
-			strERR =  "Bulk time limit exceeded";
-			break;
-		case 21:
-			strERR =  "Current sensor issue(sensor bias/sensor broken)";
-			break;
-		case 26:
-			strERR =  "Terminals overheated";
-			break;
-		case 28:
-			strERR =  "Converter issue (dual converter models only)";
-			break;
-		case 33:
-			strERR =  "Input voltage too high (solar panel)";
-			break;
-		case 34:
-			strERR =  "Input current too high (solar panel)";
-			break;
-		case 38:
-			strERR =  "Input shutdown (due to excessive battery voltage)";
-			break;
-		case 39:
-			strERR =  "Input shutdown (due to current flow during off mode)";
-			break;
-		case 40:
-			strERR =  "Input";
-			break;
-		case 65:
-			strERR =  "Lost communication with one of devices";
-			break;
-		case 67:
-			strERR =  "Synchronisedcharging device configuration issue";
-			break;
-		case 68:
-			strERR =  "BMS connection lost";
-			break;
-		case 116:
-			strERR =  "Factory calibration data lost";
-			break;
-		case 117:
-			strERR =  "Invalid/incompatible firmware";
-			break;
-		case 118:
-			strERR =  "User settings invalid";
-			break;
-		default:
-			strERR = err;
+	// ':' + command + two characters for max. 7 data bytes and the checksum + '\n'
+	char buffer[2 + 2 * 8 + 1];
+	char* ptr = buffer;
+	uint8_t checksum = 0x55 - command;
+
+	*ptr++ = ':';
+	*ptr++ = hexChars[command & 0x0F];
+	for (uint8_t i = 0; i < len; i++) {
+		*ptr++ = hexChars[data[i] >> 4];
+		*ptr++ = hexChars[data[i] & 0x0F];
+		checksum -= data[i];
 	}
-	return strERR;
+	*ptr++ = hexChars[checksum >> 4];
+	*ptr++ = hexChars[checksum & 0x0F];
+	*ptr++ = '\n';
+
+	// the device does not answer a restart
+	if (command != VE_HEX_CMD_RESTART) {
+		int8_t slot = -1;
+
+		VE_SEMAPHORE_TAKE();
+		for (uint8_t i = 0; i < VE_HEX_MAX_OUTSTANDING; i++) {
+			if (!_hexRequests[i].active) {
+				slot = i;
+				break;
+			}
+		}
+		if (slot >= 0) {
+			HexRequest& req = _hexRequests[slot];
+			req.active = true;
+			req.command = command;
+			req.id = id;
+			req.sentAt = millis();
+			req.callback = std::move(callback);
+		}
+		VE_SEMAPHORE_GIVE();
+
+		if (slot < 0) {
+			return false;
+		}
+	}
+
+	_serial.write(reinterpret_cast<const uint8_t*>(buffer), ptr - buffer);
+	return true;
 }
 
 /*
- * getOrAsString
- * This function returns the off reason (OR) as readable text.
+ * sendHexCommand
+ * This function sends one of the commands without parameters (ping, app version, product id, restart).
  */
-String VeDirectFrameHandler::getOrAsString(const char* offReason)
+bool VeDirectFrameHandler::sendHexCommand(uint8_t command, VeDirectHexCallback callback)
 {
-	String strOR ="";
+	switch (command) {
+	case VE_HEX_CMD_PING:
+	case VE_HEX_CMD_APP_VERSION:
+	case VE_HEX_CMD_PRODUCT_ID:
+	case VE_HEX_CMD_RESTART:
+		return hexTx(command, nullptr, 0, 0, std::move(callback));
+	default:
+		return false;
+	}
+}
 
-	long lOR = strtol(offReason, nullptr, 0);
-	switch(lOR) {
-		case 0x00000000:
-			strOR =  "Not off";
-			break;
-		case 0x00000001:
-			strOR =  "No input power";
-			break;
-		case 0x00000002:
-			strOR =  "Switched off (power switch)";
-			break;
-		case 0x00000004:
-			strOR =  "Switched off (device moderegister)";
-			break;
-		case 0x00000008:
-			strOR =  "Remote input";
-			break;
-		case 0x00000010:
-			strOR =  "Protection active";
-			break;
-		case 0x00000020:
-			strOR =  "Paygo";
-			break;
-		case 0x00000040:
-			strOR =  "BMS";
-			break;
-		case 0x00000080:
-			strOR =  "Engine shutdown detection";
-			break;
-		case 0x00000100:
-			strOR =  "Analysing input voltage";
-			break;
-		default:
-			strOR = offReason;
+/*
+ * sendHexGet
+ * This function requests the value of a register. The callback is called from the rx task
+ * with the response or a timeout. Several requests may be pending at the same time.
+ */
+bool VeDirectFrameHandler::sendHexGet(uint16_t id, VeDirectHexCallback callback)
+{
+	uint8_t data[] = { static_cast<uint8_t>(id & 0xFF), static_cast<uint8_t>(id >> 8), 0x00 };
+	return hexTx(VE_HEX_CMD_GET, data, sizeof(data), id, std::move(callback));
+}
+
+/*
+ * sendHexSet
+ * This function writes size (1, 2 or 4) bytes of value to a register.
+ */
+bool VeDirectFrameHandler::sendHexSet(uint16_t id, uint32_t value, uint8_t size, VeDirectHexCallback callback)
+{
+	if (size != 1 && size != 2 && size != 4) {
+		return false;
+	}
+
+	uint8_t data[7] = { static_cast<uint8_t>(id & 0xFF), static_cast<uint8_t>(id >> 8), 0x00 };
+	for (uint8_t i = 0; i < size; i++) {
+		data[3 + i] = (value >> (8 * i)) & 0xFF;
 	}
-	return strOR;
+	return hexTx(VE_HEX_CMD_SET, data, 3 + size, id, std::move(callback));
 }
 
 /*
- * getMpptAsString
- * This function returns the state of MPPT (MPPT) as readable text.
+ * setHexAsyncCallback
+ * The callback is called from the rx task for every register change the device reports on its own.
  */
-String VeDirectFrameHandler::getMpptAsString(const char* mppt)
+void VeDirectFrameHandler::setHexAsyncCallback(VeDirectHexCallback callback)
 {
-	String strMPPT ="";
+	VE_SEMAPHORE_TAKE();
+	_hexAsyncCallback = std::move(callback);
+	VE_SEMAPHORE_GIVE();
+}
 
-	int iMPPT = atoi(mppt);
-	switch(iMPPT) {
-		case 0:
-			strMPPT =  "Off";
-			break;
-		case 1:
-			strMPPT =  "Voltage or current limited";
-			break;
-		case 2:
-			strMPPT =  "MPP Tracker active";
-			break;
-		default:
-			strMPPT = mppt;
+unsigned long VeDirectFrameHandler::getLastUpdate()
+{
+    return _lastPoll;
+}
+
+/*
+ * setLastUpdate
+ * This function is called every time a new ve.direct frame was read.
+ */
+void VeDirectFrameHandler::setLastUpdate()
+{
+    _lastPoll = millis();
+}
+
+template <size_t N>
+static const char* lookupText(const veText_t (&table)[N], uint32_t code)
+{
+	size_t low = 0;
+	size_t high = N;
+	while (low < high) {
+		size_t mid = (low + high) / 2;
+		if (table[mid].code < code) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
 	}
-	return strMPPT;
-}
\ No newline at end of file
+	return (low < N && table[low].code == code) ? table[low].text : nullptr;
+}
+
+/*
+ * getPidAsString
+ * This function returns the product id (PID) as readable text or nullptr if it is unknown.
+ */
+const char* VeDirectFrameHandler::getPidAsString(uint16_t pid)
+{
+	return lookupText(veProductTexts, pid);
+}
+
+/*
+ * getCsAsString
+ * This function returns the state of operations (CS) as readable text or nullptr if it is unknown.
+ */
+const char* VeDirectFrameHandler::getCsAsString(uint8_t cs)
+{
+	return lookupText(veStateTexts, cs);
+}
+
+/*
+ * getErrAsString
+ * This function returns error state (ERR) as readable text or nullptr if it is unknown.
+ */
+const char* VeDirectFrameHandler::getErrAsString(uint8_t err)
+{
+	return lookupText(veErrorTexts, err);
+}
+
+/*
+ * getOrAsString
+ * This function returns the off reason (OR) as readable text or nullptr if it is unknown.
+ */
+const char* VeDirectFrameHandler::getOrAsString(uint32_t offReason)
+{
+	return lookupText(veOffReasonTexts, offReason);
+}
+
+/*
+ * getMpptAsString
+ * This function returns the state of MPPT (MPPT) as readable text or nullptr if it is unknown.
+ */
+const char* VeDirectFrameHandler::getMpptAsString(uint8_t mppt)
+{
+	return lookupText(veMpptTexts, mppt);
+}
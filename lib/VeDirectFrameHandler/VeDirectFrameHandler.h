@@ -6,47 +6,241 @@
  * 2020.05.05 - 0.2 - initial release
  * 2021.02.23 - 0.3 - change frameLen to 22 per VE.Direct Protocol version 3.30
  * 2022.08.20 - 0.4 - changes for OpenDTU
+ * 2022.10.20 - 0.5 - decode into typed record using fixed buffers
+ * 2022.10.21 - 0.6 - drain serial continuously from a separate task
+ * 2022.10.23 - 0.7 - HEX protocol with pipelined register get/set
+ * 2022.10.25 - 0.8 - one instance per uart
+ * 2022.10.26 - 0.9 - chunked input and parser statistics
+ * 2022.10.27 - 0.10 - lookup tables for readable texts
+ * 2022.10.28 - 0.11 - per field change mask with deadbands
+ * 2022.10.29 - 0.12 - double buffered snapshot, readers do not lock
+ * 2022.10.31 - 0.13 - link quality counters and decode latency histogram
+ * 2022.11.02 - 0.14 - battery monitor fields, other labels are passed through
  * 
  */
 
 #pragma once
 
 #include <Arduino.h>
-#include <map>
+#include <atomic>
+#include <functional>
 
-#ifndef VICTRON_PIN_TX
-#define VICTRON_PIN_TX 21      // HardwareSerial TX Pin
-#endif
+#define VE_RX_BUFFER_SIZE 512       // HardwareSerial rx ring buffer, holds more than two text frames
+#define VE_TASK_STACK_SIZE 3072
+#define VE_TASK_PRIORITY 2
+#define VE_TASK_CORE 1
+#define VE_TASK_WAKEUP_PERIOD 100    // ms, upper bound for the task to check the rx buffer
+#define VE_RX_CHUNK_SIZE 64          // bytes read from the serial rx buffer at once
+#define VE_LATENCY_BUCKETS 12        // bucket n counts latencies < 2^(n + VE_LATENCY_MIN_BITS) us, the last one all others
+#define VE_LATENCY_MIN_BITS 6        // 64 us
 
-#ifndef VICTRON_PIN_RX
-#define VICTRON_PIN_RX 22      // HardwareSerial RX Pin
-#endif
+#define VE_MAX_NAME_LEN 10    // VE.Direct Protocol: max. 9 characters per label + '\0'
+#define VE_MAX_VALUE_LEN 34   // VE.Direct Protocol: max. 33 characters per value + '\0'
+#define VE_MAX_DEVICE_NAME_LEN 32
+#define VE_MAX_EXTRA_FIELDS 24        // labels without a typed field which are passed through as text
+#define VE_MAX_EXTRA_VALUE_LEN 24     // values of these labels are numbers or short texts like the model name
 
+#define VE_MAX_HEX_LEN 64             // max. characters of a hex frame between ':' and '\n'
+#define VE_HEX_MAX_OUTSTANDING 4      // max. number of hex requests waiting for a response
+#define VE_HEX_TIMEOUT 500            // ms, a pending hex request is dropped after this time
 
+// fields of a text frame which are decoded into a VeDirectRecord
+enum VeDirectField {
+    VE_PID = 0,
+    VE_SER,
+    VE_FW,
+    VE_LOAD,
+    VE_CS,
+    VE_ERR,
+    VE_OR,
+    VE_MPPT,
+    VE_HSDS,
+    VE_V,
+    VE_I,
+    VE_VPV,
+    VE_PPV,
+    VE_IL,
+    VE_H19,
+    VE_H20,
+    VE_H21,
+    VE_H22,
+    VE_H23,
+    VE_VS,
+    VE_VM,
+    VE_DM,
+    VE_T,
+    VE_P,
+    VE_CE,
+    VE_SOC,
+    VE_TTG,
+    VE_ALARM,
+    VE_RELAY,
+    VE_AR,
+    VE_MON,
+    VE_FIELD_COUNT
+};
+
+// bit of the changed mask which is set if any of the VeDirectRecord::extra fields changed
+#define VE_CHANGED_EXTRA (1UL << VE_FIELD_COUNT)
+
+struct VeDirectExtraField {
+    char name[VE_MAX_NAME_LEN];
+    char value[VE_MAX_EXTRA_VALUE_LEN];
+};
+
+struct VeDirectRecord {
+    uint32_t present;                          // bit n is set if field n was part of the frame
+    uint16_t PID;                              // product id
+    char SER[VE_MAX_VALUE_LEN];                // serial number
+    char FW[VE_MAX_VALUE_LEN];                 // firmware release number
+    bool LOAD;                                 // virtual load output state (on = true)
+    uint8_t CS;                                // current state of operation
+    uint8_t ERR;                               // error code
+    uint32_t OR;                               // off reason
+    uint8_t MPPT;                              // state of MPP tracker
+    uint16_t HSDS;                             // day sequence number (1...365)
+    int32_t V;                                 // battery voltage in mV
+    int32_t I;                                 // battery current in mA
+    int32_t VPV;                               // panel voltage in mV
+    int32_t PPV;                               // panel power in W
+    int32_t IL;                                // load current in mA
+    uint32_t H19;                              // yield total in 0.01 kWh
+    uint32_t H20;                              // yield today in 0.01 kWh
+    uint32_t H21;                              // maximum power today in W
+    uint32_t H22;                              // yield yesterday in 0.01 kWh
+    uint32_t H23;                              // maximum power yesterday in W
+    int32_t VS;                                // auxiliary (starter) voltage in mV
+    int32_t VM;                                // mid-point voltage of the battery bank in mV
+    int32_t DM;                                // mid-point deviation of the battery bank in 0.1 %
+    int32_t T;                                 // battery temperature in degrees celsius
+    int32_t P;                                 // instantaneous power in W
+    int32_t CE;                                // consumed amp hours in mAh
+    uint16_t SOC;                              // state of charge in 0.1 %
+    int32_t TTG;                               // time to go in minutes, -1 if infinite
+    bool ALARM;                                // alarm condition active
+    bool RELAY;                                // relay state
+    uint16_t AR;                               // alarm reason
+    int32_t MON;                               // DC monitor mode
+    uint8_t extraCount;                        // number of valid entries in extra
+    VeDirectExtraField extra[VE_MAX_EXTRA_FIELDS]; // all other labels (e.g. H1...H18) or values which are not numeric
+};
+
+// VE.Direct HEX protocol: commands sent to the device
+enum VeDirectHexCommand {
+    VE_HEX_CMD_PING = 0x1,
+    VE_HEX_CMD_APP_VERSION = 0x3,
+    VE_HEX_CMD_PRODUCT_ID = 0x4,
+    VE_HEX_CMD_RESTART = 0x6,
+    VE_HEX_CMD_GET = 0x7,
+    VE_HEX_CMD_SET = 0x8,
+    VE_HEX_CMD_ASYNC = 0xA
+};
+
+// VE.Direct HEX protocol: responses received from the device
+enum VeDirectHexResponse {
+    VE_HEX_RSP_DONE = 0x1,
+    VE_HEX_RSP_UNKNOWN = 0x3,
+    VE_HEX_RSP_ERROR = 0x4,
+    VE_HEX_RSP_PING = 0x5,
+    VE_HEX_RSP_GET = 0x7,
+    VE_HEX_RSP_SET = 0x8,
+    VE_HEX_RSP_ASYNC = 0xA,
+    VE_HEX_RSP_TIMEOUT = 0xFF                  // no response from the device, generated locally
+};
+
+// VE.Direct HEX protocol: flags of get/set/async responses
+enum VeDirectHexFlags {
+    VE_HEX_FLAG_UNKNOWN_ID = 0x01,
+    VE_HEX_FLAG_NOT_SUPPORTED = 0x02,
+    VE_HEX_FLAG_PARAMETER_ERROR = 0x04
+};
+
+struct VeDirectHexData {
+    uint8_t response;                          // VeDirectHexResponse
+    uint16_t id;                               // register id (get/set/async only)
+    uint8_t flags;                             // VeDirectHexFlags (get/set/async only)
+    uint32_t value;                            // value, little endian decoded
+    uint8_t size;                              // number of bytes of value
+};
+
+typedef std::function<void(const VeDirectHexData&)> VeDirectHexCallback;
+
+struct VeDirectParserStats {
+    uint32_t bytes;                            // bytes passed to the parser
+    uint32_t frames;                           // text frames with valid checksum
+    uint32_t checksumErrors;                   // text frames with invalid checksum
+    uint32_t hexFrames;                        // valid hex frames
+    uint32_t hexErrors;                        // hex frames with invalid length, character or checksum
+    uint32_t uartOverruns;                     // data lost because the uart fifo or rx buffer was full
+    uint32_t uartFrameErrors;                  // uart framing, parity or break errors
+    uint32_t maxFrameGap;                      // ms, longest time between two valid text frames
+    uint32_t latency[VE_LATENCY_BUCKETS];      // time from the uart reporting data until a frame is published
+    uint64_t latencySum;                       // us, sum of all latencies
+};
+
+// readable texts of the coded fields of a VeDirectRecord, nullptr if the code is unknown
+struct VeDirectRecordText {
+    const char* PID;
+    const char* CS;
+    const char* ERR;
+    const char* OR;
+    const char* MPPT;
+};
 
 class VeDirectFrameHandler {
 
 public:
 
-    VeDirectFrameHandler();
-    void init();                                  // initialize HardewareSerial
-    void setPollInterval(unsigned long interval); // set poll intervall in seconds
-    void loop();                                 // main loop to read ve.direct data
+    explicit VeDirectFrameHandler(uint8_t uartNum);
+    void init(int8_t rxPin, int8_t txPin);       // initialize HardewareSerial and start rx task
+    void setName(const char* name);
+    const char* name();
     unsigned long getLastUpdate();               // timestamp of last successful frame read
-    String getPidAsString(const char* pid);      // product id as string  
-    String getCsAsString(const char* cs);        // current state as string
-    String getErrAsString(const char* err);      // errer state as string
-    String getOrAsString(const char* offReason); // off reason as string
-    String getMpptAsString(const char* mppt);    // state of mppt as string
+    void getFrame(VeDirectRecord& frame);        // copy of the last valid frame
+    void getFrame(VeDirectRecord& frame, VeDirectRecordText& text); // same including readable texts
+    uint32_t getChangedFrame(VeDirectRecord& frame); // copy of the last valid frame, returns fields changed since the last call
+    void setDeadband(uint8_t field, uint32_t deadband); // min. change of a numeric field to be marked as changed
+    void feed(const uint8_t* data, size_t len);  // decode received data, called by the rx task
+    void getParserStats(VeDirectParserStats& stats); // counters of the parser
+    static uint32_t getLatencyBucketLimit(uint8_t bucket); // upper bound of a latency bucket in us, 0 for the last one
+    static const char* getPidAsString(uint16_t pid);      // product id as string  
+    static const char* getCsAsString(uint8_t cs);         // current state as string
+    static const char* getErrAsString(uint8_t err);       // errer state as string
+    static const char* getOrAsString(uint32_t offReason); // off reason as string
+    static const char* getMpptAsString(uint8_t mppt);     // state of mppt as string
+
+    static const char* getFieldName(uint8_t field);  // label of a field as sent by the device
+    static bool getFieldAsString(const VeDirectRecord& frame, uint8_t field, char* buffer, size_t len); // raw field value as text
 
-    std::map<String, String> veMap;              // public map for received name and value pairs
+    bool sendHexCommand(uint8_t command, VeDirectHexCallback callback = nullptr); // ping, version, product id, restart
+    bool sendHexGet(uint16_t id, VeDirectHexCallback callback);                   // read a register
+    bool sendHexSet(uint16_t id, uint32_t value, uint8_t size, VeDirectHexCallback callback = nullptr); // write a register
+    void setHexAsyncCallback(VeDirectHexCallback callback); // called for async register notifications
 
 private:
+    static void rxTask(void* parameter);      // drains the serial rx buffer
+    void onReceive();                         // called by HardwareSerial if data was received
+    void onReceiveError(hardwareSerial_error_t error); // called by HardwareSerial on uart errors
     void setLastUpdate();                     // set timestampt after successful frame read
     void rxData(uint8_t inbyte);              // byte of serial data
-    void frameEndEvent(bool);                 // copy temp map to public map
+    void textRxEvent(const char* name, const char* value); // decode name/value pair into temp record
+    void frameEndEvent(bool);                 // publish the back buffer if the frame is valid
+    void updateLinkStats();                   // frame gap and latency of a published frame
+    struct Snapshot {
+        VeDirectRecord frame;
+        VeDirectRecordText text;
+    };
+
+    Snapshot& backBuffer();                   // snapshot the parser decodes into
+    void readSnapshot(VeDirectRecord* frame, VeDirectRecordText* text); // consistent copy of the published snapshot, text may be nullptr
+    void updateFrameText(Snapshot& next, const Snapshot& prev, bool force); // lookup texts of changed codes
+    uint32_t getChangedFields(const VeDirectRecord& frame); // compare with _reported and update it, fields not reported before are always changed
     void logE(const char *, const char *);    
-    bool hexRxEvent(uint8_t);
+    bool hexRxEvent(uint8_t inbyte);           // byte of a hex frame, true if the frame is complete
+    void hexFrameEvent();                      // decode a complete hex frame
+    bool hexTx(uint8_t command, const uint8_t* data, uint8_t len, uint16_t id, VeDirectHexCallback callback);
+    void hexComplete(const VeDirectHexData& data); // pass a response to the matching pending request
+    void checkHexTimeouts();                   // drop pending hex requests without response
 
     //bool mStop;                               // not sure what Victron uses this for, not using
 
@@ -59,14 +253,38 @@ private:
         RECORD_HEX
     };
 
+    struct HexRequest {
+        bool active;
+        uint8_t command;                       // VeDirectHexCommand
+        uint16_t id;                           // register id of get/set
+        uint32_t sentAt;                       // millis() of transmission
+        VeDirectHexCallback callback;
+    };
+
     int _state;                                // current state
+    int _prevState;                            // state before a hex frame interrupted the text frame
     uint8_t	_checksum;                         // checksum value
-    String _name;                              // buffer for the field name
-    String _value;                             // buffer for the field value
-    std::map<String, String> _tmpMap;          // private map for received name and value pairs
-    unsigned long _pollInterval;
+    char * _textPointer;                       // pointer to the private buffer we're writing in
+    char _name[VE_MAX_NAME_LEN];               // buffer for the field name
+    char _value[VE_MAX_VALUE_LEN];             // buffer for the field value
+    char _hexBuffer[VE_MAX_HEX_LEN];           // characters of the hex frame being received
+    uint8_t _hexSize;                          // number of characters in _hexBuffer
+    Snapshot _snapshot[2];                     // _snapshot[_seq & 1] holds the last valid frame, the other one is being received
+    std::atomic<uint32_t> _seq;                // incremented for every valid frame
+    VeDirectRecord _reported;                  // values of the fields when they were last marked as changed
+    std::atomic<uint32_t> _changed;            // bit n is set if field n changed since getChangedFrame(), VE_CHANGED_EXTRA for the extra fields
+    uint32_t _deadband[VE_FIELD_COUNT];
+    VeDirectParserStats _stats;                // only written by the parser
     unsigned long _lastPoll;
+    uint32_t _rxEventTime;                     // us, last time onReceive() was called
+
+    TaskHandle_t _rxTaskHandle;
+    SemaphoreHandle_t _xSemaphore;             // protects _hexRequests and _hexAsyncCallback
+    HexRequest _hexRequests[VE_HEX_MAX_OUTSTANDING]; // hex requests waiting for a response
+    VeDirectHexCallback _hexAsyncCallback;
+
+    HardwareSerial _serial;
+    char _deviceName[VE_MAX_DEVICE_NAME_LEN];  // name given by the user
 };
 
-extern VeDirectFrameHandler VeDirect;
 
@@ -0,0 +1,167 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include "VeDirectHistory.h"
+
+#define VE_SEMAPHORE_TAKE() xSemaphoreTake(_xSemaphore, portMAX_DELAY)
+#define VE_SEMAPHORE_GIVE() xSemaphoreGive(_xSemaphore)
+
+static int32_t clampValue(int32_t value, int32_t low, int32_t high)
+{
+    return value < low ? low : (value > high ? high : value);
+}
+
+VeDirectHistory::VeDirectHistory()
+{
+    const uint32_t intervals[VE_HISTORY_TIER_COUNT] = { VE_HISTORY_TIER0_INTERVAL, VE_HISTORY_TIER1_INTERVAL, VE_HISTORY_TIER2_INTERVAL };
+    const uint16_t sizes[VE_HISTORY_TIER_COUNT] = { VE_HISTORY_TIER0_SIZE, VE_HISTORY_TIER1_SIZE, VE_HISTORY_TIER2_SIZE };
+
+    for (uint8_t i = 0; i < VE_HISTORY_TIER_COUNT; i++) {
+        Tier& t = _tiers[i];
+        t.samples.reset(new VeDirectSample[sizes[i]]);
+        t.size = sizes[i];
+        t.interval = intervals[i];
+        t.count = 0;
+        t.lastTimestamp = 0;
+        t.started = false;
+        t.slot = 0;
+        t.sumV = t.sumI = t.sumVPV = t.sumPPV = 0;
+        t.sumCount = 0;
+        t.lastCS = VE_HISTORY_NO_DATA;
+    }
+
+    _xSemaphore = xSemaphoreCreateMutex();
+    VE_SEMAPHORE_GIVE(); // release before first use
+}
+
+// Is called once per second. If calls are missing, the gap is filled with samples without data.
+void VeDirectHistory::addSample(const VeDirectRecord* frame, uint32_t timestamp)
+{
+    VeDirectSample sample = {};
+    if (frame != nullptr) {
+        sample.V = clampValue(frame->V / 10, 0, UINT16_MAX);
+        sample.I = clampValue(frame->I / 10, INT16_MIN, INT16_MAX);
+        sample.VPV = clampValue(frame->VPV / 10, 0, UINT16_MAX);
+        sample.PPV = clampValue(frame->PPV, 0, UINT16_MAX);
+        sample.CS = frame->CS;
+    } else {
+        sample.CS = VE_HISTORY_NO_DATA;
+    }
+
+    VE_SEMAPHORE_TAKE();
+    push(0, sample, timestamp - timestamp % _tiers[0].interval);
+    VE_SEMAPHORE_GIVE();
+}
+
+void VeDirectHistory::push(uint8_t tier, const VeDirectSample& sample, uint32_t timestamp)
+{
+    Tier& t = _tiers[tier];
+
+    if (t.count > 0) {
+        if (timestamp <= t.lastTimestamp) {
+            return;
+        }
+
+        // keep the timestamps implicit, more than size samples would only overwrite each other
+        uint32_t missing = (timestamp - t.lastTimestamp) / t.interval - 1;
+        if (missing > t.size) {
+            missing = t.size;
+        }
+        VeDirectSample noData = {};
+        noData.CS = VE_HISTORY_NO_DATA;
+        for (uint32_t i = 0; i < missing; i++) {
+            t.samples[t.count++ % t.size] = noData;
+        }
+    }
+
+    t.samples[t.count++ % t.size] = sample;
+    t.lastTimestamp = timestamp;
+
+    if (tier + 1 < VE_HISTORY_TIER_COUNT) {
+        accumulate(tier + 1, sample, timestamp);
+    }
+}
+
+// Averages the samples of the lower tier. The sample of the upper tier is added as soon as the first
+// sample of the next interval arrives. Samples without data are not part of the average.
+void VeDirectHistory::accumulate(uint8_t tier, const VeDirectSample& sample, uint32_t timestamp)
+{
+    Tier& t = _tiers[tier];
+    uint32_t slot = timestamp / t.interval;
+
+    if (t.started && slot != t.slot) {
+        VeDirectSample avg = {};
+        if (t.sumCount > 0) {
+            avg.V = t.sumV / t.sumCount;
+            avg.I = t.sumI / t.sumCount;
+            avg.VPV = t.sumVPV / t.sumCount;
+            avg.PPV = t.sumPPV / t.sumCount;
+            avg.CS = t.lastCS;
+        } else {
+            avg.CS = VE_HISTORY_NO_DATA;
+        }
+
+        t.sumV = t.sumI = t.sumVPV = t.sumPPV = 0;
+        t.sumCount = 0;
+        push(tier, avg, t.slot * t.interval);
+    }
+    t.started = true;
+    t.slot = slot;
+
+    if (sample.CS != VE_HISTORY_NO_DATA) {
+        t.sumV += sample.V;
+        t.sumI += sample.I;
+        t.sumVPV += sample.VPV;
+        t.sumPPV += sample.PPV;
+        t.sumCount++;
+        t.lastCS = sample.CS;
+    }
+}
+
+uint32_t VeDirectHistory::getInterval(uint8_t tier)
+{
+    if (tier >= VE_HISTORY_TIER_COUNT) {
+        return 0;
+    }
+    return _tiers[tier].interval;
+}
+
+uint32_t VeDirectHistory::findPos(uint8_t tier, uint32_t since)
+{
+    if (tier >= VE_HISTORY_TIER_COUNT) {
+        return 0;
+    }
+
+    VE_SEMAPHORE_TAKE();
+    const Tier& t = _tiers[tier];
+    uint32_t pos = t.count;
+    if (since < t.lastTimestamp) {
+        uint32_t newer = (t.lastTimestamp - since + t.interval - 1) / t.interval;
+        pos = newer < t.count ? t.count - newer : 0;
+    }
+    VE_SEMAPHORE_GIVE();
+
+    return pos;
+}
+
+// Samples which were overwritten since pos was determined are skipped.
+size_t VeDirectHistory::read(uint8_t tier, uint32_t& pos, VeDirectHistoryEntry* entries, size_t maxCount)
+{
+    if (tier >= VE_HISTORY_TIER_COUNT) {
+        return 0;
+    }
+
+    size_t n = 0;
+
+    VE_SEMAPHORE_TAKE();
+    const Tier& t = _tiers[tier];
+    uint32_t oldest = t.count > t.size ? t.count - t.size : 0;
+    if (pos < oldest) {
+        pos = oldest;
+    }
+    for (; pos < t.count && n < maxCount; pos++, n++) {
+        entries[n].timestamp = t.lastTimestamp - (t.count - 1 - pos) * t.interval;
+        entries[n].sample = t.samples[pos % t.size];
+    }
+    VE_SEMAPHORE_GIVE();
+
+    return n;
+}
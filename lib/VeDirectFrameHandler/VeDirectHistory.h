@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "VeDirectFrameHandler.h"
+#include <memory>
+
+#define VE_HISTORY_TIER_COUNT 3
+#define VE_HISTORY_NO_DATA 0xFF         // CS of a sample without a valid frame
+
+// interval in seconds and number of samples of every tier, the defaults hold
+// 10 minutes at 1 s, 24 hours at 1 min and 7 days at 15 min (~27 kB per device)
+#define VE_HISTORY_TIER0_INTERVAL 1
+#define VE_HISTORY_TIER0_SIZE 600
+#define VE_HISTORY_TIER1_INTERVAL 60
+#define VE_HISTORY_TIER1_SIZE 1440
+#define VE_HISTORY_TIER2_INTERVAL (15 * 60)
+#define VE_HISTORY_TIER2_SIZE 672
+
+// timestamps are implicit, sample n of a tier is interval seconds older than sample n + 1
+struct VeDirectSample {
+    uint16_t V;                     // battery voltage in 10 mV
+    int16_t I;                      // battery current in 10 mA
+    uint16_t VPV;                   // panel voltage in 10 mV
+    uint16_t PPV;                   // panel power in W
+    uint8_t CS;                     // state of operation, VE_HISTORY_NO_DATA if there was no frame
+};
+
+struct VeDirectHistoryEntry {
+    uint32_t timestamp;             // seconds, same time base as used for addSample()
+    VeDirectSample sample;
+};
+
+class VeDirectHistory {
+public:
+    VeDirectHistory();
+
+    void addSample(const VeDirectRecord* frame, uint32_t timestamp); // frame may be nullptr if there is no data
+    uint32_t getInterval(uint8_t tier);
+    uint32_t findPos(uint8_t tier, uint32_t since);        // position of the first sample newer than since
+    size_t read(uint8_t tier, uint32_t& pos, VeDirectHistoryEntry* entries, size_t maxCount); // samples from pos on, oldest first
+
+private:
+    struct Tier {
+        std::unique_ptr<VeDirectSample[]> samples;
+        uint16_t size;
+        uint32_t interval;
+        uint32_t count;             // number of samples ever added, the newest one is at (count - 1) % size
+        uint32_t lastTimestamp;     // timestamp of the newest sample
+
+        // average of the samples of the lower tier within the current interval
+        bool started;
+        uint32_t slot;              // timestamp / interval of the average
+        int32_t sumV;
+        int32_t sumI;
+        int32_t sumVPV;
+        int32_t sumPPV;
+        uint16_t sumCount;
+        uint8_t lastCS;
+    };
+
+    void push(uint8_t tier, const VeDirectSample& sample, uint32_t timestamp);
+    void accumulate(uint8_t tier, const VeDirectSample& sample, uint32_t timestamp);
+
+    Tier _tiers[VE_HISTORY_TIER_COUNT];
+
+    SemaphoreHandle_t _xSemaphore;
+};
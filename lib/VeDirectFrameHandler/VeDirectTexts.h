@@ -0,0 +1,133 @@
+/* VeDirectTexts.h
+ *
+ * Readable texts of the coded values of the VE.Direct text protocol.
+ * Every list is expanded into a lookup table, entries must be sorted by their code.
+ */
+
+#pragma once
+
+// product id (PID)
+#define VE_PRODUCT_LIST(X) \
+    X(0x0300, "BlueSolar MPPT 70|15") \
+    X(0xA040, "BlueSolar MPPT 75|50") \
+    X(0xA041, "BlueSolar MPPT 150|35") \
+    X(0xA042, "BlueSolar MPPT 75|15") \
+    X(0xA043, "BlueSolar MPPT 100|15") \
+    X(0xA044, "BlueSolar MPPT 100|30") \
+    X(0xA045, "BlueSolar MPPT 100|50") \
+    X(0xA046, "BlueSolar MPPT 100|70") \
+    X(0xA047, "BlueSolar MPPT 150|100") \
+    X(0xA049, "BlueSolar MPPT 100|50 rev2") \
+    X(0xA04A, "BlueSolar MPPT 100|30 rev2") \
+    X(0xA04B, "BlueSolar MPPT 150|35 rev2") \
+    X(0xA04C, "BlueSolar MPPT 75|10") \
+    X(0xA04D, "BlueSolar MPPT 150|45") \
+    X(0xA04E, "BlueSolar MPPT 150|60") \
+    X(0xA04F, "BlueSolar MPPT 150|85") \
+    X(0xA050, "SmartSolar MPPT 250|100") \
+    X(0xA051, "SmartSolar MPPT 150|100") \
+    X(0xA052, "SmartSolar MPPT 150|85") \
+    X(0xA053, "SmartSolar MPPT 75|15") \
+    X(0xA054, "SmartSolar MPPT 75|10") \
+    X(0xA055, "SmartSolar MPPT 100|15") \
+    X(0xA056, "SmartSolar MPPT 100|30") \
+    X(0xA057, "SmartSolar MPPT 100|50") \
+    X(0xA058, "SmartSolar MPPT 100|35") \
+    X(0xA059, "SmartSolar MPPT 150|10 rev2") \
+    X(0xA05A, "SmartSolar MPPT 150|85 rev2") \
+    X(0xA05B, "SmartSolar MPPT 250|70") \
+    X(0xA05C, "SmartSolar MPPT 250|85") \
+    X(0xA05D, "SmartSolar MPPT 250|60") \
+    X(0xA05E, "SmartSolar MPPT 250|45") \
+    X(0xA05F, "SmartSolar MPPT 100|20") \
+    X(0xA060, "SmartSolar MPPT 100|20 48V") \
+    X(0xA061, "SmartSolar MPPT 150|45") \
+    X(0xA062, "SmartSolar MPPT 150|60") \
+    X(0xA063, "SmartSolar MPPT 150|70") \
+    X(0xA064, "SmartSolar MPPT 250|85 rev2") \
+    X(0xA065, "SmartSolar MPPT 250|100 rev2") \
+    X(0xA066, "BlueSolar MPPT 100|20") \
+    X(0xA067, "BlueSolar MPPT 100|20 48V") \
+    X(0xA068, "SmartSolar MPPT 250|60 rev2") \
+    X(0xA069, "SmartSolar MPPT 250|70 rev2") \
+    X(0xA06A, "SmartSolar MPPT 150|45 rev2") \
+    X(0xA06B, "SmartSolar MPPT 150|60 rev2") \
+    X(0xA06C, "SmartSolar MPPT 150|70 rev2") \
+    X(0xA06D, "SmartSolar MPPT 150|85 rev3") \
+    X(0xA06E, "SmartSolar MPPT 150|100 rev3") \
+    X(0xA06F, "BlueSolar MPPT 150|45 rev2") \
+    X(0xA070, "BlueSolar MPPT 150|60 rev2") \
+    X(0xA071, "BlueSolar MPPT 150|70 rev2") \
+    X(0xA102, "SmartSolar MPPT VE.Can 150|70") \
+    X(0xA103, "SmartSolar MPPT VE.Can 150|45") \
+    X(0xA104, "SmartSolar MPPT VE.Can 150|60") \
+    X(0xA105, "SmartSolar MPPT VE.Can 150|85") \
+    X(0xA106, "SmartSolar MPPT VE.Can 150|100") \
+    X(0xA107, "SmartSolar MPPT VE.Can 250|45") \
+    X(0xA108, "SmartSolar MPPT VE.Can 250|60") \
+    X(0xA109, "SmartSolar MPPT VE.Can 250|80") \
+    X(0xA10A, "SmartSolar MPPT VE.Can 250|85") \
+    X(0xA10B, "SmartSolar MPPT VE.Can 250|100") \
+    X(0xA10C, "SmartSolar MPPT VE.Can 150|70 rev2") \
+    X(0xA10D, "SmartSolar MPPT VE.Can 150|85 rev2") \
+    X(0xA10E, "SmartSolar MPPT VE.Can 150|100 rev2") \
+    X(0xA10F, "BlueSolar MPPT VE.Can 150|100") \
+    X(0xA112, "BlueSolar MPPT VE.Can 250|70") \
+    X(0xA113, "BlueSolar MPPT VE.Can 250|100") \
+    X(0xA114, "SmartSolar MPPT VE.Can 250|70 rev2") \
+    X(0xA115, "SmartSolar MPPT VE.Can 250|100 rev2") \
+    X(0xA116, "SmartSolar MPPT VE.Can 250|85 rev2")
+
+// state of operation (CS)
+#define VE_STATE_LIST(X) \
+    X(0, "OFF") \
+    X(2, "Fault") \
+    X(3, "Bulk") \
+    X(4, "Absorbtion") \
+    X(5, "Float") \
+    X(7, "Equalize (manual)") \
+    X(245, "Starting-up") \
+    X(247, "Auto equalize / Recondition") \
+    X(252, "External Control")
+
+// error code (ERR)
+#define VE_ERROR_LIST(X) \
+    X(0, "No error") \
+    X(2, "Battery voltage too high") \
+    X(17, "Charger temperature too high") \
+    X(18, "Charger over current") \
+    X(19, "Charger current reversed") \
+    X(20, "Bulk time limit exceeded") \
+    X(21, "Current sensor issue(sensor bias/sensor broken)") \
+    X(26, "Terminals overheated") \
+    X(28, "Converter issue (dual converter models only)") \
+    X(33, "Input voltage too high (solar panel)") \
+    X(34, "Input current too high (solar panel)") \
+    X(38, "Input shutdown (due to excessive battery voltage)") \
+    X(39, "Input shutdown (due to current flow during off mode)") \
+    X(40, "Input") \
+    X(65, "Lost communication with one of devices") \
+    X(67, "Synchronisedcharging device configuration issue") \
+    X(68, "BMS connection lost") \
+    X(116, "Factory calibration data lost") \
+    X(117, "Invalid/incompatible firmware") \
+    X(118, "User settings invalid")
+
+// off reason (OR)
+#define VE_OFF_REASON_LIST(X) \
+    X(0x00000000, "Not off") \
+    X(0x00000001, "No input power") \
+    X(0x00000002, "Switched off (power switch)") \
+    X(0x00000004, "Switched off (device moderegister)") \
+    X(0x00000008, "Remote input") \
+    X(0x00000010, "Protection active") \
+    X(0x00000020, "Paygo") \
+    X(0x00000040, "BMS") \
+    X(0x00000080, "Engine shutdown detection") \
+    X(0x00000100, "Analysing input voltage")
+
+// tracker operation mode (MPPT)
+#define VE_MPPT_LIST(X) \
+    X(0, "Off") \
+    X(1, "Voltage or current limited") \
+    X(2, "MPP Tracker active")
@@ -4,12 +4,21 @@
  */
 #include "Configuration.h"
 #include "MessageOutput.h"
+#include "VeDirectFrameHandler.h"
 #include "defaults.h"
 #include <ArduinoJson.h>
 #include <LittleFS.h>
 
+static_assert(VE_FIELD_COUNT <= VEDIRECT_MAX_FIELD_COUNT, "Vedirect_Deadband too small");
+
 CONFIG_T config;
 
+// the document holds copies of all strings of the file, keys included
+static size_t getReadBufferSize(File& f)
+{
+    return max(static_cast<size_t>(JSON_BUFFER_SIZE), f.size() * JSON_BUFFER_FILE_FACTOR);
+}
+
 void ConfigurationClass::init()
 {
     memset(&config, 0x0, sizeof(config));
@@ -23,7 +32,7 @@ bool ConfigurationClass::write()
     }
     config.Cfg_SaveCount++;
 
-    DynamicJsonDocument doc(JSON_BUFFER_SIZE);
+    DynamicJsonDocument doc(JSON_BUFFER_SIZE + getInverterCount() * INV_JSON_BUFFER_SIZE);
 
     JsonObject cfg = doc.createNestedObject("cfg");
     cfg["version"] = config.Cfg_Version;
@@ -80,11 +89,18 @@ bool ConfigurationClass::write()
     security["password"] = config.Security_Password;
     security["allow_readonly"] = config.Security_AllowReadonly;
 
+    // empty slots are not stored, the inverters move to the front on the next read
     JsonArray inverters = doc.createNestedArray("inverters");
     for (uint8_t i = 0; i < INV_MAX_COUNT; i++) {
+        if (config.Inverter[i].Serial == 0) {
+            continue;
+        }
+
         JsonObject inv = inverters.createNestedObject();
         inv["serial"] = config.Inverter[i].Serial;
         inv["name"] = config.Inverter[i].Name;
+        inv["poll_interval"] = config.Inverter[i].PollInterval;
+        inv["alarm_log_interval"] = config.Inverter[i].AlarmLogInterval;
 
         JsonArray channel = inv.createNestedArray("channel");
         for (uint8_t c = 0; c < INV_MAX_CHAN_COUNT; c++) {
@@ -99,6 +115,23 @@ bool ConfigurationClass::write()
     vedirect["updates_only"] = config.Vedirect_UpdatesOnly;
     vedirect["poll_interval"] = config.Vedirect_PollInterval;
 
+    JsonArray vedirect_devices = vedirect.createNestedArray("devices");
+    for (uint8_t i = 0; i < VEDIRECT_MAX_COUNT; i++) {
+        JsonObject dev = vedirect_devices.createNestedObject();
+        dev["enabled"] = config.Vedirect_Device[i].Enabled;
+        dev["name"] = config.Vedirect_Device[i].Name;
+        dev["rx_pin"] = config.Vedirect_Device[i].RxPin;
+        dev["tx_pin"] = config.Vedirect_Device[i].TxPin;
+    }
+
+    // only fields with a deadband are stored, keyed by their label
+    JsonObject vedirect_deadband = vedirect.createNestedObject("deadband");
+    for (uint8_t field = 0; field < VE_FIELD_COUNT; field++) {
+        if (config.Vedirect_Deadband[field] > 0) {
+            vedirect_deadband[VeDirectFrameHandler::getFieldName(field)] = config.Vedirect_Deadband[field];
+        }
+    }
+
     // Serialize JSON to file
     if (serializeJson(doc, f) == 0) {
         MessageOutput.println("Failed to write file");
@@ -113,7 +146,7 @@ bool ConfigurationClass::read()
 {
     File f = LittleFS.open(CONFIG_FILENAME, "r", false);
 
-    DynamicJsonDocument doc(JSON_BUFFER_SIZE);
+    DynamicJsonDocument doc(getReadBufferSize(f));
     // Deserialize the JSON document
     DeserializationError error = deserializeJson(doc, f);
     if (error) {
@@ -211,6 +244,8 @@ bool ConfigurationClass::read()
         JsonObject inv = inverters[i].as<JsonObject>();
         config.Inverter[i].Serial = inv["serial"] | 0ULL;
         strlcpy(config.Inverter[i].Name, inv["name"] | "", sizeof(config.Inverter[i].Name));
+        config.Inverter[i].PollInterval = inv["poll_interval"] | 0;
+        config.Inverter[i].AlarmLogInterval = inv["alarm_log_interval"] | 0;
 
         JsonArray channel = inv["channel"];
         for (uint8_t c = 0; c < INV_MAX_CHAN_COUNT; c++) {
@@ -224,6 +259,23 @@ bool ConfigurationClass::read()
     config.Vedirect_UpdatesOnly = vedirect["updates_only"] | VEDIRECT_UPDATESONLY;
     config.Vedirect_PollInterval = vedirect["poll_interval"] | VEDIRECT_POLL_INTERVAL;
 
+    // the first device defaults to the pins used before multiple devices were supported
+    const int8_t vedirectRxPin[VEDIRECT_MAX_COUNT] = { VICTRON_PIN_RX, VICTRON2_PIN_RX };
+    const int8_t vedirectTxPin[VEDIRECT_MAX_COUNT] = { VICTRON_PIN_TX, VICTRON2_PIN_TX };
+    JsonArray vedirect_devices = vedirect["devices"];
+    for (uint8_t i = 0; i < VEDIRECT_MAX_COUNT; i++) {
+        JsonObject dev = vedirect_devices[i].as<JsonObject>();
+        config.Vedirect_Device[i].Enabled = dev["enabled"] | (i == 0);
+        strlcpy(config.Vedirect_Device[i].Name, dev["name"] | "", sizeof(config.Vedirect_Device[i].Name));
+        config.Vedirect_Device[i].RxPin = dev["rx_pin"] | vedirectRxPin[i];
+        config.Vedirect_Device[i].TxPin = dev["tx_pin"] | vedirectTxPin[i];
+    }
+
+    JsonObject vedirect_deadband = vedirect["deadband"];
+    for (uint8_t field = 0; field < VE_FIELD_COUNT; field++) {
+        config.Vedirect_Deadband[field] = vedirect_deadband[VeDirectFrameHandler::getFieldName(field)] | 0;
+    }
+
     f.close();
     return true;
 }
@@ -237,7 +289,7 @@ void ConfigurationClass::migrate()
             return;
         }
 
-        DynamicJsonDocument doc(JSON_BUFFER_SIZE);
+        DynamicJsonDocument doc(getReadBufferSize(f));
         // Deserialize the JSON document
         DeserializationError error = deserializeJson(doc, f);
         if (error) {
@@ -266,6 +318,18 @@ CONFIG_T& ConfigurationClass::get()
     return config;
 }
 
+uint8_t ConfigurationClass::getInverterCount()
+{
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < INV_MAX_COUNT; i++) {
+        if (config.Inverter[i].Serial > 0) {
+            count++;
+        }
+    }
+
+    return count;
+}
+
 INVERTER_CONFIG_T* ConfigurationClass::getFreeInverterSlot()
 {
     for (uint8_t i = 0; i < INV_MAX_COUNT; i++) {
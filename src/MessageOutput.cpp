@@ -36,6 +36,22 @@ size_t MessageOutputClass::write(uint8_t c)
     return Serial.write(c);
 }
 
+// printf() and print() of strings end up here, so a whole line takes the lock only once
+size_t MessageOutputClass::write(const uint8_t* buffer, size_t size)
+{
+    MSG_LOCK();
+    size_t len = size;
+    if (_buff_pos + len > BUFFER_SIZE) {
+        len = BUFFER_SIZE - _buff_pos;
+        _forceSend = true;
+    }
+    memcpy(&_buffer[_buff_pos], buffer, len);
+    _buff_pos += len;
+    MSG_UNLOCK();
+
+    return Serial.write(buffer, size);
+}
+
 void MessageOutputClass::loop()
 {
     // Send data via websocket if either time is over or buffer is full
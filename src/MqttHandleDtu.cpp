@@ -29,6 +29,9 @@ void MqttHandleDtuClass::loop()
         if (NetworkSettings.NetworkMode() == network_mode::WiFi) {
             MqttSettings.publish("dtu/rssi", String(WiFi.RSSI()));
         }
+        MqttSettings.publish("dtu/radio/crc_errors", String(Hoymiles.getRadio()->getCrcErrorCount()));
+        MqttSettings.publish("dtu/radio/unknown_inverter", String(Hoymiles.getRadio()->getUnknownInverterCount()));
+        MqttSettings.publish("dtu/radio/rx_flushes", String(Hoymiles.getRadio()->getRxBufferFlushCount()));
 
         _lastPublish = millis();
     }
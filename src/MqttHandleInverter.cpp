@@ -16,6 +16,19 @@
 
 MqttHandleInverterClass MqttHandleInverter;
 
+static const struct {
+    const char* topic;
+    uint32_t LinkStatistics::*value;
+} radioStatsTopics[] = {
+    { "radio/requests", &LinkStatistics::requests },
+    { "radio/responses", &LinkStatistics::responses },
+    { "radio/resends", &LinkStatistics::resends },
+    { "radio/retransmits", &LinkStatistics::retransmits },
+    { "radio/crc_errors", &LinkStatistics::crcErrors },
+    { "radio/handle_errors", &LinkStatistics::handleErrors },
+    { "radio/timeouts", &LinkStatistics::timeouts },
+};
+
 void MqttHandleInverterClass::init()
 {
     using std::placeholders::_1;
@@ -91,6 +104,8 @@ void MqttHandleInverterClass::loop()
                 MqttSettings.publish(subtopic + "/status/last_update", String(0));
             }
 
+            publishRadioStats(inv, subtopic);
+
             uint32_t lastUpdate = inv->Statistics()->getLastUpdate();
             if (lastUpdate > 0 && lastUpdate != _lastPublishStats[i]) {
                 _lastPublishStats[i] = lastUpdate;
@@ -116,6 +131,24 @@ void MqttHandleInverterClass::loop()
     }
 }
 
+void MqttHandleInverterClass::publishRadioStats(std::shared_ptr<InverterAbstract> inv, const String& subtopic)
+{
+    const LinkStatistics& link = inv->RadioStats()->getLinkStatistics();
+
+    for (auto& t : radioStatsTopics) {
+        MqttSettings.publish(subtopic + "/" + t.topic, String(link.*t.value));
+    }
+
+    if (link.responses > 0) {
+        MqttSettings.publish(subtopic + "/radio/latency", String(link.latencySum / link.responses));
+    }
+
+    uint32_t interval = inv->Poll()->getAchievedInterval();
+    if (interval > 0) {
+        MqttSettings.publish(subtopic + "/radio/poll_interval", String(interval));
+    }
+}
+
 void MqttHandleInverterClass::publishField(std::shared_ptr<InverterAbstract> inv, uint8_t channel, uint8_t fieldId)
 {
     String topic = getTopic(inv, channel, fieldId);
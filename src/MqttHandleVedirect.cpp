@@ -2,17 +2,46 @@
 /*
  * Copyright (C) 2022 Helge Erbe and others
  */
-#include "VeDirectFrameHandler.h"
+#include "VeDirect.h"
 #include "MqttHandleVedirect.h"
+#include "MessageOutput.h"
 #include "MqttSettings.h"
 
+#define TOPIC_SUB_HEX_GET "hex_get"
+#define TOPIC_SUB_HEX_SET "hex_set"
+
 
 
 
 MqttHandleVedirectClass MqttHandleVedirect;
 
+static const struct {
+    const char* topic;
+    uint32_t VeDirectParserStats::*value;
+} vedirectStatsTopics[] = {
+    { "stats/bytes", &VeDirectParserStats::bytes },
+    { "stats/frames", &VeDirectParserStats::frames },
+    { "stats/checksum_errors", &VeDirectParserStats::checksumErrors },
+    { "stats/hex_frames", &VeDirectParserStats::hexFrames },
+    { "stats/hex_errors", &VeDirectParserStats::hexErrors },
+    { "stats/uart_overruns", &VeDirectParserStats::uartOverruns },
+    { "stats/uart_frame_errors", &VeDirectParserStats::uartFrameErrors },
+    { "stats/max_frame_gap", &VeDirectParserStats::maxFrameGap },
+};
+
 void MqttHandleVedirectClass::init()
 {
+    using std::placeholders::_1;
+    using std::placeholders::_2;
+    using std::placeholders::_3;
+    using std::placeholders::_4;
+    using std::placeholders::_5;
+    using std::placeholders::_6;
+
+    // victron/cmd/... for the first device, victron/[pos]/cmd/... for the others
+    String topic = MqttSettings.getPrefix() + "victron/";
+    MqttSettings.subscribe(String(topic + "cmd/+").c_str(), 0, std::bind(&MqttHandleVedirectClass::onMqttMessage, this, _1, _2, _3, _4, _5, _6));
+    MqttSettings.subscribe(String(topic + "+/cmd/+").c_str(), 0, std::bind(&MqttHandleVedirectClass::onMqttMessage, this, _1, _2, _3, _4, _5, _6));
 }
 
 void MqttHandleVedirectClass::loop()
@@ -23,33 +52,189 @@ void MqttHandleVedirectClass::loop()
         return;
     }    
 
-    if (millis() - _lastPublish > (config.Mqtt_PublishInterval * 1000)) {
-        String key;
-        String value;
-        bool bChanged;
+    // register responses are published as soon as they arrive
+    for (uint8_t pos = 0; pos < VeDirect.getNumDevices() && pos < VEDIRECT_MAX_COUNT; pos++) {
+        if (VeDirect.getRegisterSeq(pos) != _lastRegisterSeq[pos]) {
+            publishRegisters(pos);
+        }
+    }
+
+    // Data is decoded continuously, the VE.Direct poll interval only throttles publishing
+    if (millis() - _lastPublish > (config.Vedirect_PollInterval * 1000)) {
+        char value[VE_MAX_VALUE_LEN];
 
         String topic = "";
-        for (auto it = VeDirect.veMap.begin(); it != VeDirect.veMap.end(); ++it) {
-            key = it->first;
-            value = it->second;
-            
-            // Mark changed values
-            auto a = _kv_map.find(key);
-            bChanged = true;
-            if (a !=  _kv_map.end()) {
-                if (_kv_map[key] == value) {
-                    bChanged = false;
-                }   
+        for (uint8_t pos = 0; pos < VeDirect.getNumDevices(); pos++) {
+            auto dev = VeDirect.getDeviceByPos(pos);
+            VeDirectRecord frame;
+            uint32_t changed = dev->getChangedFrame(frame);
+
+            // first device keeps the topics used before multiple devices were supported
+            String prefix = "victron/";
+            if (pos > 0) {
+                prefix += String(pos) + "/";
             }
-        
-            // publish only changed key, values pairs
-            if (!config.Vedirect_UpdatesOnly || (bChanged && config.Vedirect_UpdatesOnly)) {
-                topic = "victron/";
-                topic.concat(key);  
-                MqttSettings.publish(topic.c_str(), value.c_str()); 
+
+            for (uint8_t field = 0; field < VE_FIELD_COUNT; field++) {
+                // publish only changed key, values pairs
+                if (config.Vedirect_UpdatesOnly && !(changed & (1UL << field))) {
+                    continue;
+                }
+                if (!VeDirectFrameHandler::getFieldAsString(frame, field, value, sizeof(value))) {
+                    continue;
+                }
+
+                topic = prefix;
+                topic.concat(VeDirectFrameHandler::getFieldName(field));
+                MqttSettings.publish(topic.c_str(), value);
+            }
+
+            // labels without a typed field are published as they were received
+            if (!config.Vedirect_UpdatesOnly || (changed & VE_CHANGED_EXTRA)) {
+                for (uint8_t i = 0; i < frame.extraCount; i++) {
+                    topic = prefix;
+                    topic.concat(frame.extra[i].name);
+                    MqttSettings.publish(topic.c_str(), frame.extra[i].value);
+                }
             }
+
+            publishStats(pos, dev.get(), prefix, config.Vedirect_UpdatesOnly);
         }
-        _kv_map = VeDirect.veMap;
         _lastPublish = millis();
     }
+}
+
+void MqttHandleVedirectClass::publishStats(uint8_t pos, VeDirectFrameHandler* dev, const String& prefix, bool updatesOnly)
+{
+    VeDirectParserStats stats;
+    dev->getParserStats(stats);
+
+    for (auto& t : vedirectStatsTopics) {
+        if (updatesOnly && stats.*t.value == _lastStats[pos].*t.value) {
+            continue;
+        }
+        MqttSettings.publish(prefix + t.topic, String(stats.*t.value));
+    }
+
+    // latency histogram, a topic per bucket named by its upper bound in us
+    uint32_t count = 0;
+    uint32_t lastCount = 0;
+    for (uint8_t b = 0; b < VE_LATENCY_BUCKETS; b++) {
+        count += stats.latency[b];
+        lastCount += _lastStats[pos].latency[b];
+        if (updatesOnly && stats.latency[b] == _lastStats[pos].latency[b]) {
+            continue;
+        }
+        uint32_t limit = VeDirectFrameHandler::getLatencyBucketLimit(b);
+        String topic = prefix + "stats/latency/" + (limit > 0 ? String(limit) : String("inf"));
+        MqttSettings.publish(topic, String(stats.latency[b]));
+    }
+    if (!updatesOnly || count != lastCount) {
+        MqttSettings.publish(prefix + "stats/latency_count", String(count));
+        char sum[24];
+        snprintf(sum, sizeof(sum), "%llu", stats.latencySum);
+        MqttSettings.publish(prefix + "stats/latency_sum", sum);
+    }
+    _lastStats[pos] = stats;
+}
+
+void MqttHandleVedirectClass::publishRegisters(uint8_t pos)
+{
+    VeDirectRegister registers[VE_REGISTER_CACHE_SIZE];
+    uint8_t count = VeDirect.getRegisters(pos, registers, VE_REGISTER_CACHE_SIZE);
+
+    String prefix = "victron/";
+    if (pos > 0) {
+        prefix += String(pos) + "/";
+    }
+
+    uint32_t lastSeq = _lastRegisterSeq[pos];
+    for (uint8_t i = 0; i < count; i++) {
+        const VeDirectRegister& reg = registers[i];
+        if (static_cast<int32_t>(reg.seq - lastSeq) <= 0) {
+            continue;
+        }
+        if (static_cast<int32_t>(reg.seq - _lastRegisterSeq[pos]) > 0) {
+            _lastRegisterSeq[pos] = reg.seq;
+        }
+
+        char topic[16];
+        snprintf(topic, sizeof(topic), "hex/%04X", reg.data.id);
+
+        String value;
+        if (reg.data.response == VE_HEX_RSP_TIMEOUT) {
+            value = "timeout";
+        } else if (reg.data.flags & VE_HEX_FLAG_UNKNOWN_ID) {
+            value = "unknown id";
+        } else if (reg.data.flags & VE_HEX_FLAG_NOT_SUPPORTED) {
+            value = "not supported";
+        } else if (reg.data.flags & VE_HEX_FLAG_PARAMETER_ERROR) {
+            value = "parameter error";
+        } else {
+            value = String(reg.data.value);
+        }
+        MqttSettings.publish(prefix + topic, value);
+    }
+}
+
+void MqttHandleVedirectClass::onMqttMessage(const espMqttClientTypes::MessageProperties& properties, const char* topic, const uint8_t* payload, size_t len, size_t index, size_t total)
+{
+    char token_topic[MQTT_MAX_TOPIC_STRLEN + 40]; // respect all subtopics
+    strlcpy(token_topic, topic, sizeof(token_topic));
+
+    char* rest = &token_topic[strlen(Configuration.get().Mqtt_Topic) + strlen("victron/")];
+    char* first = strtok_r(rest, "/", &rest);
+    char* second = strtok_r(rest, "/", &rest);
+    char* third = strtok_r(rest, "/", &rest);
+
+    // victron/cmd/[setting] or victron/[pos]/cmd/[setting]
+    uint8_t pos = 0;
+    char* setting = second;
+    if (third != NULL) {
+        pos = strtoul(first, NULL, 10);
+        first = second;
+        setting = third;
+    }
+    if (first == NULL || setting == NULL || strcmp(first, "cmd")) {
+        return;
+    }
+
+    if (pos >= VeDirect.getNumDevices()) {
+        MessageOutput.println(F("VE.Direct device not found"));
+        return;
+    }
+
+    // [id] or [id],[value],[size], numbers may be given as hex with 0x prefix
+    char buffer[48];
+    size_t n = min(len, sizeof(buffer) - 1);
+    memcpy(buffer, payload, n);
+    buffer[n] = '\0';
+
+    char* next;
+    uint16_t id = strtoul(buffer, &next, 0);
+
+    bool sent = false;
+    if (!strcmp(setting, TOPIC_SUB_HEX_GET)) {
+        MessageOutput.printf("VE.Direct: get register 0x%04X\r\n", id);
+        sent = VeDirect.readRegister(pos, id);
+
+    } else if (!strcmp(setting, TOPIC_SUB_HEX_SET)) {
+        if (*next++ != ',') {
+            return;
+        }
+        uint32_t value = strtoul(next, &next, 0);
+        if (*next++ != ',') {
+            return;
+        }
+        uint8_t size = strtoul(next, NULL, 10);
+        MessageOutput.printf("VE.Direct: set register 0x%04X to %u\r\n", id, value);
+        sent = VeDirect.writeRegister(pos, id, value, size);
+
+    } else {
+        return;
+    }
+
+    if (!sent) {
+        MessageOutput.println(F("VE.Direct: too many pending requests or invalid size"));
+    }
 }
\ No newline at end of file
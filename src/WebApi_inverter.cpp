@@ -33,7 +33,7 @@ void WebApiInverterClass::onInverterList(AsyncWebServerRequest* request)
         return;
     }
 
-    AsyncJsonResponse* response = new AsyncJsonResponse(false, 4096U);
+    AsyncJsonResponse* response = new AsyncJsonResponse(false, 1024U + Configuration.getInverterCount() * INV_JSON_BUFFER_SIZE);
     JsonObject root = response->getRoot();
     JsonArray data = root.createNestedArray(F("inverter"));
 
@@ -51,6 +51,8 @@ void WebApiInverterClass::onInverterList(AsyncWebServerRequest* request)
                 ((uint32_t)((config.Inverter[i].Serial >> 32) & 0xFFFFFFFF)),
                 ((uint32_t)(config.Inverter[i].Serial & 0xFFFFFFFF)));
             obj[F("serial")] = buffer;
+            obj[F("poll_interval")] = config.Inverter[i].PollInterval;
+            obj[F("alarm_log_interval")] = config.Inverter[i].AlarmLogInterval;
 
             auto inv = Hoymiles.getInverterBySerial(config.Inverter[i].Serial);
             uint8_t max_channels;
@@ -60,6 +62,7 @@ void WebApiInverterClass::onInverterList(AsyncWebServerRequest* request)
             } else {
                 obj[F("type")] = inv->typeName();
                 max_channels = inv->Statistics()->getChannelCount();
+                obj[F("poll_interval_achieved")] = inv->Poll()->getAchievedInterval();
             }
 
             JsonArray channel = obj.createNestedArray("channel");
@@ -154,6 +157,8 @@ void WebApiInverterClass::onInverterAdd(AsyncWebServerRequest* request)
     inverter->Serial = strtoll(root[F("serial")].as<String>().c_str(), NULL, 16);
 
     strncpy(inverter->Name, root[F("name")].as<String>().c_str(), INV_MAX_NAME_STRLEN);
+    inverter->PollInterval = root[F("poll_interval")] | 0;
+    inverter->AlarmLogInterval = root[F("alarm_log_interval")] | 0;
     Configuration.write();
 
     retMsg[F("type")] = F("success");
@@ -169,6 +174,8 @@ void WebApiInverterClass::onInverterAdd(AsyncWebServerRequest* request)
         for (uint8_t c = 0; c < INV_MAX_CHAN_COUNT; c++) {
             inv->Statistics()->setChannelMaxPower(c, inverter->channel[c].MaxChannelPower);
         }
+        inv->Poll()->setStatsInterval(inverter->PollInterval * 1000);
+        inv->Poll()->setAlarmLogInterval(inverter->AlarmLogInterval * 1000);
     }
 
     MqttHandleHass.forceUpdate();
@@ -264,6 +271,10 @@ void WebApiInverterClass::onInverterEdit(AsyncWebServerRequest* request)
     inverter.Serial = new_serial;
     strncpy(inverter.Name, root[F("name")].as<String>().c_str(), INV_MAX_NAME_STRLEN);
 
+    // Optional, missing values keep the current setting
+    inverter.PollInterval = root[F("poll_interval")] | inverter.PollInterval;
+    inverter.AlarmLogInterval = root[F("alarm_log_interval")] | inverter.AlarmLogInterval;
+
     uint8_t arrayCount = 0;
     for (JsonVariant channel : channelArray) {
         inverter.channel[arrayCount].MaxChannelPower = channel[F("max_power")].as<uint16_t>();
@@ -298,6 +309,8 @@ void WebApiInverterClass::onInverterEdit(AsyncWebServerRequest* request)
         for (uint8_t c = 0; c < INV_MAX_CHAN_COUNT; c++) {
             inv->Statistics()->setChannelMaxPower(c, inverter.channel[c].MaxChannelPower);
         }
+        inv->Poll()->setStatsInterval(inverter.PollInterval * 1000);
+        inv->Poll()->setAlarmLogInterval(inverter.AlarmLogInterval * 1000);
     }
 
     MqttHandleHass.forceUpdate();
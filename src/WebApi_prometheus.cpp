@@ -6,7 +6,11 @@
 #include "WebApi_prometheus.h"
 #include "Configuration.h"
 #include "NetworkSettings.h"
+#include "VeDirect.h"
 #include <Hoymiles.h>
+#include <StreamString.h>
+
+static const char* const commandTypeNames[CMD_TYPE_COUNT] = { "control", "stats", "alarm_log", "dev_info", "system_config", "other" };
 
 void WebApiPrometheusClass::init(AsyncWebServer* server)
 {
@@ -23,8 +27,63 @@ void WebApiPrometheusClass::loop()
 
 void WebApiPrometheusClass::onPrometheusMetricsGet(AsyncWebServerRequest* request)
 {
-    auto stream = request->beginResponseStream("text/plain; charset=utf-8", 40960);
+    uint8_t part = 0;
+    String pending;
+    size_t sent = 0;
+
+    // Every part (the system, one inverter, one VE.Direct device) is printed into a small
+    // buffer when the previous one is sent, so the whole body is never held in memory
+    AsyncWebServerResponse* response = request->beginChunkedResponse("text/plain; charset=utf-8",
+        [this, part, pending, sent](uint8_t* buffer, size_t maxLen, size_t) mutable -> size_t {
+            size_t len = 0;
+            while (len < maxLen) {
+                if (sent == pending.length()) {
+                    StreamString stream;
+                    if (!generatePart(&stream, part)) {
+                        break;
+                    }
+                    part++;
+                    pending = stream;
+                    sent = 0;
+                    continue;
+                }
+
+                size_t chunk = std::min(maxLen - len, pending.length() - sent);
+                memcpy(buffer + len, pending.c_str() + sent, chunk);
+                len += chunk;
+                sent += chunk;
+            }
+            return len;
+        });
+
+    response->addHeader(F("Cache-Control"), F("no-cache"));
+    request->send(response);
+}
+
+// Part 0 is the system, followed by one part per inverter and one per VE.Direct device
+bool WebApiPrometheusClass::generatePart(Print* stream, uint8_t part)
+{
+    if (part == 0) {
+        addSystemMetrics(stream);
+        return true;
+    }
+    part--;
+
+    if (part < Hoymiles.getNumInverters()) {
+        addInverterMetrics(stream, part);
+        return true;
+    }
+    part -= Hoymiles.getNumInverters();
 
+    if (part < VeDirect.getNumDevices()) {
+        addVedirectMetrics(stream, part);
+        return true;
+    }
+    return false;
+}
+
+void WebApiPrometheusClass::addSystemMetrics(Print* stream)
+{
     stream->print(F("# HELP opendtu_build Build info\n"));
     stream->print(F("# TYPE opendtu_build gauge\n"));
     stream->printf("opendtu_build{name=\"%s\",id=\"%s\",version=\"%d.%d.%d\"} 1\n",
@@ -50,45 +109,213 @@ void WebApiPrometheusClass::onPrometheusMetricsGet(AsyncWebServerRequest* reques
     stream->print(F("# TYPE wifi_rssi gauge\n"));
     stream->printf("wifi_rssi %d\n", WiFi.RSSI());
 
-    for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
-        auto inv = Hoymiles.getInverterByPos(i);
+    static const char* const priorityNames[CMD_PRIORITY_COUNT] = { "control", "stats", "background" };
+    for (uint8_t p = 0; p < CMD_PRIORITY_COUNT; p++) {
+        CommandSchedulerStatistics stats;
+        Hoymiles.getRadio()->getSchedulerStatistics(static_cast<CommandPriority>(p), stats);
 
-        String serial = inv->serialString();
-        const char* name = inv->name();
-        if (i == 0) {
-            stream->print(F("# HELP opendtu_last_update last update from inverter in s\n"));
-            stream->print(F("# TYPE opendtu_last_update gauge\n"));
+        if (p == 0) {
+            stream->print(F("# HELP opendtu_radio_queue_wait_ms time radio commands waited in the queue\n"));
+            stream->print(F("# TYPE opendtu_radio_queue_wait_ms summary\n"));
         }
-        stream->printf("opendtu_last_update{serial=\"%s\",unit=\"%d\",name=\"%s\"} %d\n",
-            serial.c_str(), i, name, inv->Statistics()->getLastUpdate() / 1000);
-
-        // Loop all channels
-        for (uint8_t c = 0; c <= inv->Statistics()->getChannelCount(); c++) {
-            addField(stream, serial, i, inv, c, FLD_PAC);
-            addField(stream, serial, i, inv, c, FLD_UAC);
-            addField(stream, serial, i, inv, c, FLD_IAC);
-            if (c == 0) {
-                addField(stream, serial, i, inv, c, FLD_PDC, "PowerDC");
-            } else {
-                addField(stream, serial, i, inv, c, FLD_PDC);
-            }
-            addField(stream, serial, i, inv, c, FLD_UDC);
-            addField(stream, serial, i, inv, c, FLD_IDC);
-            addField(stream, serial, i, inv, c, FLD_YD);
-            addField(stream, serial, i, inv, c, FLD_YT);
-            addField(stream, serial, i, inv, c, FLD_F);
-            addField(stream, serial, i, inv, c, FLD_T);
-            addField(stream, serial, i, inv, c, FLD_PF);
-            addField(stream, serial, i, inv, c, FLD_PRA);
-            addField(stream, serial, i, inv, c, FLD_EFF);
-            addField(stream, serial, i, inv, c, FLD_IRR);
+        stream->printf("opendtu_radio_queue_wait_ms_sum{class=\"%s\"} %u\n", priorityNames[p], stats.waitSum);
+        stream->printf("opendtu_radio_queue_wait_ms_count{class=\"%s\"} %u\n", priorityNames[p], stats.scheduled);
+
+        if (p == 0) {
+            stream->print(F("# HELP opendtu_radio_queue_wait_max_ms longest time a radio command waited in the queue\n"));
+            stream->print(F("# TYPE opendtu_radio_queue_wait_max_ms gauge\n"));
+        }
+        stream->printf("opendtu_radio_queue_wait_max_ms{class=\"%s\"} %u\n", priorityNames[p], stats.waitMax);
+
+        if (p == 0) {
+            stream->print(F("# HELP opendtu_radio_commands_pending radio commands waiting in the queue\n"));
+            stream->print(F("# TYPE opendtu_radio_commands_pending gauge\n"));
+        }
+        stream->printf("opendtu_radio_commands_pending{class=\"%s\"} %u\n", priorityNames[p], stats.pending);
+
+        if (p == 0) {
+            stream->print(F("# HELP opendtu_radio_commands_coalesced_total radio commands merged into a pending duplicate\n"));
+            stream->print(F("# TYPE opendtu_radio_commands_coalesced_total counter\n"));
+        }
+        stream->printf("opendtu_radio_commands_coalesced_total{class=\"%s\"} %u\n", priorityNames[p], stats.coalesced);
+
+        if (p == 0) {
+            stream->print(F("# HELP opendtu_radio_commands_expired_total radio commands dropped after their deadline\n"));
+            stream->print(F("# TYPE opendtu_radio_commands_expired_total counter\n"));
+        }
+        stream->printf("opendtu_radio_commands_expired_total{class=\"%s\"} %u\n", priorityNames[p], stats.expired);
+    }
+
+    stream->print(F("# HELP opendtu_radio_crc_errors_total received fragments with a wrong checksum\n"));
+    stream->print(F("# TYPE opendtu_radio_crc_errors_total counter\n"));
+    stream->printf("opendtu_radio_crc_errors_total %u\n", Hoymiles.getRadio()->getCrcErrorCount());
+
+    stream->print(F("# HELP opendtu_radio_unknown_inverter_total received fragments of inverters which are not configured\n"));
+    stream->print(F("# TYPE opendtu_radio_unknown_inverter_total counter\n"));
+    stream->printf("opendtu_radio_unknown_inverter_total %u\n", Hoymiles.getRadio()->getUnknownInverterCount());
+
+    stream->print(F("# HELP opendtu_radio_rx_flushes_total rx FIFO of the radio dropped as the receive buffer was full\n"));
+    stream->print(F("# TYPE opendtu_radio_rx_flushes_total counter\n"));
+    stream->printf("opendtu_radio_rx_flushes_total %u\n", Hoymiles.getRadio()->getRxBufferFlushCount());
+
+    // Measured airtime per command type which the poll planning is based on
+    for (uint8_t t = 0; t < CMD_TYPE_COUNT; t++) {
+        CommandAirtimeStatistics airtime;
+        Hoymiles.getRadio()->getAirtimeStatistics(static_cast<CommandType>(t), airtime);
+
+        if (t == 0) {
+            stream->print(F("# HELP opendtu_radio_airtime_ms smoothed time the radio is occupied by one command\n"));
+            stream->print(F("# TYPE opendtu_radio_airtime_ms gauge\n"));
+        }
+        stream->printf("opendtu_radio_airtime_ms{type=\"%s\"} %u\n", commandTypeNames[t], airtime.average >> HOY_AIRTIME_SHIFT);
+
+        if (t == 0) {
+            stream->print(F("# HELP opendtu_radio_airtime_max_ms longest time the radio was occupied by one command\n"));
+            stream->print(F("# TYPE opendtu_radio_airtime_max_ms gauge\n"));
+        }
+        stream->printf("opendtu_radio_airtime_max_ms{type=\"%s\"} %u\n", commandTypeNames[t], airtime.max);
+
+        if (t == 0) {
+            stream->print(F("# HELP opendtu_radio_commands_total commands which occupied the radio\n"));
+            stream->print(F("# TYPE opendtu_radio_commands_total counter\n"));
         }
+        stream->printf("opendtu_radio_commands_total{type=\"%s\"} %u\n", commandTypeNames[t], airtime.commands);
     }
-    stream->addHeader(F("Cache-Control"), F("no-cache"));
-    request->send(stream);
 }
 
-void WebApiPrometheusClass::addField(AsyncResponseStream* stream, String& serial, uint8_t idx, std::shared_ptr<InverterAbstract> inv, uint8_t channel, uint8_t fieldId, const char* channelName)
+void WebApiPrometheusClass::addInverterMetrics(Print* stream, uint8_t i)
+{
+    auto inv = Hoymiles.getInverterByPos(i);
+    if (inv == nullptr) {
+        return;
+    }
+
+    String serial = inv->serialString();
+    const char* name = inv->name();
+    if (i == 0) {
+        stream->print(F("# HELP opendtu_last_update last update from inverter in s\n"));
+        stream->print(F("# TYPE opendtu_last_update gauge\n"));
+    }
+    stream->printf("opendtu_last_update{serial=\"%s\",unit=\"%d\",name=\"%s\"} %d\n",
+        serial.c_str(), i, name, inv->Statistics()->getLastUpdate() / 1000);
+
+    // Loop all channels
+    for (uint8_t c = 0; c <= inv->Statistics()->getChannelCount(); c++) {
+        addField(stream, serial, i, inv, c, FLD_PAC);
+        addField(stream, serial, i, inv, c, FLD_UAC);
+        addField(stream, serial, i, inv, c, FLD_IAC);
+        if (c == 0) {
+            addField(stream, serial, i, inv, c, FLD_PDC, "PowerDC");
+        } else {
+            addField(stream, serial, i, inv, c, FLD_PDC);
+        }
+        addField(stream, serial, i, inv, c, FLD_UDC);
+        addField(stream, serial, i, inv, c, FLD_IDC);
+        addField(stream, serial, i, inv, c, FLD_YD);
+        addField(stream, serial, i, inv, c, FLD_YT);
+        addField(stream, serial, i, inv, c, FLD_F);
+        addField(stream, serial, i, inv, c, FLD_T);
+        addField(stream, serial, i, inv, c, FLD_PF);
+        addField(stream, serial, i, inv, c, FLD_PRA);
+        addField(stream, serial, i, inv, c, FLD_EFF);
+        addField(stream, serial, i, inv, c, FLD_IRR);
+    }
+
+    // Link quality per radio channel
+    for (uint8_t c = 0; c < HOY_CHANNEL_COUNT; c++) {
+        const ChannelStatistics& ch = inv->RadioStats()->getChannelStatistics(c);
+        addRadioChannelCounter(stream, serial, i, inv, c, "tx", "requests sent", ch.txCount);
+        addRadioChannelCounter(stream, serial, i, inv, c, "tx_acked", "requests acknowledged by the inverter", ch.txAcked);
+        addRadioChannelCounter(stream, serial, i, inv, c, "rx_dwells", "rx windows while waiting for a response", ch.rxDwells);
+        addRadioChannelCounter(stream, serial, i, inv, c, "rx_hits", "rx windows with a received fragment", ch.rxHits);
+    }
+
+    // Request / response exchange
+    const LinkStatistics& link = inv->RadioStats()->getLinkStatistics();
+    addRadioLinkCounter(stream, serial, i, inv, "requests", "requests sent, not counting resends", link.requests);
+    addRadioLinkCounter(stream, serial, i, inv, "responses", "complete responses handled", link.responses);
+    addRadioLinkCounter(stream, serial, i, inv, "resends", "requests sent again as nothing was received", link.resends);
+    addRadioLinkCounter(stream, serial, i, inv, "retransmits", "single fragments requested again", link.retransmits);
+    addRadioLinkCounter(stream, serial, i, inv, "inverter_crc_errors", "fragments with a wrong checksum", link.crcErrors);
+    addRadioLinkCounter(stream, serial, i, inv, "handle_errors", "complete responses which could not be handled", link.handleErrors);
+    addRadioLinkCounter(stream, serial, i, inv, "timeouts", "requests given up after all resends or retransmits", link.timeouts);
+    addRadioLatencyHistogram(stream, serial, i, inv, link);
+
+    // Poll plan, a configured interval of 0 shares the DTU poll interval
+    const PollStatistics& poll = inv->Poll()->getStatistics();
+    addRadioLinkCounter(stream, serial, i, inv, "stats_polls", "stats requests enqueued by the poll plan", poll.statsPolls);
+    addRadioLinkCounter(stream, serial, i, inv, "deferred_requests", "background requests postponed to keep the stats interval of another inverter", poll.deferred);
+    if (i == 0) {
+        stream->print(F("# HELP opendtu_poll_interval_ms configured time between two stats requests\n"));
+        stream->print(F("# TYPE opendtu_poll_interval_ms gauge\n"));
+    }
+    stream->printf("opendtu_poll_interval_ms{serial=\"%s\",unit=\"%d\",name=\"%s\"} %u\n",
+        serial.c_str(), i, inv->name(), inv->Poll()->getStatsInterval());
+    if (i == 0) {
+        stream->print(F("# HELP opendtu_poll_interval_achieved_ms smoothed time between two stats updates\n"));
+        stream->print(F("# TYPE opendtu_poll_interval_achieved_ms gauge\n"));
+    }
+    stream->printf("opendtu_poll_interval_achieved_ms{serial=\"%s\",unit=\"%d\",name=\"%s\"} %u\n",
+        serial.c_str(), i, inv->name(), inv->Poll()->getAchievedInterval());
+
+    // Retransmits per fragment position of the responses
+    for (uint8_t f = 1; f <= MAX_RF_FRAGMENT_COUNT; f++) {
+        const FragmentStatistics& frag = inv->RadioStats()->getFragmentStatistics(f);
+        addRadioFragmentCounter(stream, serial, i, inv, f, "fragment_retransmits", "retransmit requests", frag.retransmits);
+        addRadioFragmentCounter(stream, serial, i, inv, f, "fragment_recovered", "fragments received after a retransmit request", frag.recovered);
+        addRadioFragmentCounter(stream, serial, i, inv, f, "fragment_recovery_ms", "time from the retransmit request until the fragment was received", frag.latencySum);
+    }
+
+    // Smoothed round trip time which the adaptive rx timeout is based on
+    for (uint8_t t = 0; t < CMD_TYPE_COUNT; t++) {
+        if (i == 0 && t == 0) {
+            stream->print(F("# HELP opendtu_radio_round_trip_ms smoothed time from sending a request until the complete response\n"));
+            stream->print(F("# TYPE opendtu_radio_round_trip_ms gauge\n"));
+        }
+        stream->printf("opendtu_radio_round_trip_ms{serial=\"%s\",unit=\"%d\",name=\"%s\",type=\"%s\"} %u\n",
+            serial.c_str(), i, inv->name(), commandTypeNames[t], inv->RadioStats()->getSmoothedRoundTrip(static_cast<CommandType>(t)));
+    }
+}
+
+void WebApiPrometheusClass::addVedirectMetrics(Print* stream, uint8_t i)
+{
+    auto dev = VeDirect.getDeviceByPos(i);
+    VeDirectParserStats stats;
+    dev->getParserStats(stats);
+
+    addVedirectCounter(stream, i, dev->name(), "bytes", "bytes received", stats.bytes);
+    addVedirectCounter(stream, i, dev->name(), "frames", "valid text frames", stats.frames);
+    addVedirectCounter(stream, i, dev->name(), "checksum_errors", "text frames with invalid checksum", stats.checksumErrors);
+    addVedirectCounter(stream, i, dev->name(), "hex_frames", "valid hex frames", stats.hexFrames);
+    addVedirectCounter(stream, i, dev->name(), "hex_errors", "invalid hex frames", stats.hexErrors);
+    addVedirectCounter(stream, i, dev->name(), "uart_overruns", "uart fifo or buffer overruns", stats.uartOverruns);
+    addVedirectCounter(stream, i, dev->name(), "uart_frame_errors", "uart framing, parity or break errors", stats.uartFrameErrors);
+
+    if (i == 0) {
+        stream->print(F("# HELP opendtu_vedirect_max_frame_gap longest time between two valid frames in ms\n"));
+        stream->print(F("# TYPE opendtu_vedirect_max_frame_gap gauge\n"));
+    }
+    stream->printf("opendtu_vedirect_max_frame_gap{unit=\"%d\",name=\"%s\"} %u\n", i, dev->name(), stats.maxFrameGap);
+
+    if (i == 0) {
+        stream->print(F("# HELP opendtu_vedirect_latency_us time from receiving data until a frame is published\n"));
+        stream->print(F("# TYPE opendtu_vedirect_latency_us histogram\n"));
+    }
+    uint32_t count = 0;
+    for (uint8_t b = 0; b < VE_LATENCY_BUCKETS; b++) {
+        count += stats.latency[b];
+        uint32_t limit = VeDirectFrameHandler::getLatencyBucketLimit(b);
+        if (limit > 0) {
+            stream->printf("opendtu_vedirect_latency_us_bucket{unit=\"%d\",name=\"%s\",le=\"%u\"} %u\n", i, dev->name(), limit, count);
+        } else {
+            stream->printf("opendtu_vedirect_latency_us_bucket{unit=\"%d\",name=\"%s\",le=\"+Inf\"} %u\n", i, dev->name(), count);
+        }
+    }
+    stream->printf("opendtu_vedirect_latency_us_sum{unit=\"%d\",name=\"%s\"} %llu\n", i, dev->name(), stats.latencySum);
+    stream->printf("opendtu_vedirect_latency_us_count{unit=\"%d\",name=\"%s\"} %u\n", i, dev->name(), count);
+}
+
+void WebApiPrometheusClass::addField(Print* stream, String& serial, uint8_t idx, std::shared_ptr<InverterAbstract> inv, uint8_t channel, uint8_t fieldId, const char* channelName)
 {
     if (inv->Statistics()->hasChannelFieldValue(channel, fieldId)) {
         const char* chanName = (channelName == NULL) ? inv->Statistics()->getChannelFieldName(channel, fieldId) : channelName;
@@ -98,4 +325,67 @@ void WebApiPrometheusClass::addField(AsyncResponseStream* stream, String& serial
         }
         stream->printf("opendtu_%s{serial=\"%s\",unit=\"%d\",name=\"%s\",channel=\"%d\"} %f\n", chanName, serial.c_str(), idx, inv->name(), channel, inv->Statistics()->getChannelFieldValue(channel, fieldId));
     }
+}
+
+void WebApiPrometheusClass::addRadioLinkCounter(Print* stream, String& serial, uint8_t idx, std::shared_ptr<InverterAbstract> inv, const char* metric, const char* help, uint32_t value)
+{
+    if (idx == 0) {
+        stream->printf("# HELP opendtu_radio_%s_total %s\n", metric, help);
+        stream->printf("# TYPE opendtu_radio_%s_total counter\n", metric);
+    }
+    stream->printf("opendtu_radio_%s_total{serial=\"%s\",unit=\"%d\",name=\"%s\"} %u\n",
+        metric, serial.c_str(), idx, inv->name(), value);
+}
+
+void WebApiPrometheusClass::addRadioLatencyHistogram(Print* stream, String& serial, uint8_t idx, std::shared_ptr<InverterAbstract> inv, const LinkStatistics& link)
+{
+    if (idx == 0) {
+        stream->print(F("# HELP opendtu_radio_response_latency_ms time from sending a request until its response was complete\n"));
+        stream->print(F("# TYPE opendtu_radio_response_latency_ms histogram\n"));
+    }
+
+    uint32_t count = 0;
+    for (uint8_t b = 0; b < HOY_LATENCY_BUCKET_COUNT; b++) {
+        count += link.latencyBuckets[b];
+        if (b < HOY_LATENCY_BUCKET_COUNT - 1) {
+            stream->printf("opendtu_radio_response_latency_ms_bucket{serial=\"%s\",unit=\"%d\",name=\"%s\",le=\"%u\"} %u\n",
+                serial.c_str(), idx, inv->name(), RadioStatistics::getLatencyBucketBound(b), count);
+        } else {
+            stream->printf("opendtu_radio_response_latency_ms_bucket{serial=\"%s\",unit=\"%d\",name=\"%s\",le=\"+Inf\"} %u\n",
+                serial.c_str(), idx, inv->name(), count);
+        }
+    }
+    stream->printf("opendtu_radio_response_latency_ms_sum{serial=\"%s\",unit=\"%d\",name=\"%s\"} %u\n",
+        serial.c_str(), idx, inv->name(), link.latencySum);
+    stream->printf("opendtu_radio_response_latency_ms_count{serial=\"%s\",unit=\"%d\",name=\"%s\"} %u\n",
+        serial.c_str(), idx, inv->name(), count);
+}
+
+void WebApiPrometheusClass::addRadioFragmentCounter(Print* stream, String& serial, uint8_t idx, std::shared_ptr<InverterAbstract> inv, uint8_t fragmentId, const char* metric, const char* help, uint32_t value)
+{
+    if (idx == 0 && fragmentId == 1) {
+        stream->printf("# HELP opendtu_radio_%s_total %s per fragment position\n", metric, help);
+        stream->printf("# TYPE opendtu_radio_%s_total counter\n", metric);
+    }
+    stream->printf("opendtu_radio_%s_total{serial=\"%s\",unit=\"%d\",name=\"%s\",fragment=\"%d\"} %u\n",
+        metric, serial.c_str(), idx, inv->name(), fragmentId, value);
+}
+
+void WebApiPrometheusClass::addRadioChannelCounter(Print* stream, String& serial, uint8_t idx, std::shared_ptr<InverterAbstract> inv, uint8_t chIdx, const char* metric, const char* help, uint32_t value)
+{
+    if (idx == 0 && chIdx == 0) {
+        stream->printf("# HELP opendtu_radio_%s_total %s per rf channel\n", metric, help);
+        stream->printf("# TYPE opendtu_radio_%s_total counter\n", metric);
+    }
+    stream->printf("opendtu_radio_%s_total{serial=\"%s\",unit=\"%d\",name=\"%s\",rf_channel=\"%d\"} %u\n",
+        metric, serial.c_str(), idx, inv->name(), RadioStatistics::getChannel(chIdx), value);
+}
+
+void WebApiPrometheusClass::addVedirectCounter(Print* stream, uint8_t idx, const char* name, const char* metric, const char* help, uint32_t value)
+{
+    if (idx == 0) {
+        stream->printf("# HELP opendtu_vedirect_%s_total %s\n", metric, help);
+        stream->printf("# TYPE opendtu_vedirect_%s_total counter\n", metric);
+    }
+    stream->printf("opendtu_vedirect_%s_total{unit=\"%d\",name=\"%s\"} %u\n", metric, idx, name, value);
 }
\ No newline at end of file
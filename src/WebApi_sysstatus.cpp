@@ -34,7 +34,7 @@ void WebApiSysstatusClass::onSystemStatus(AsyncWebServerRequest* request)
         return;
     }
 
-    AsyncJsonResponse* response = new AsyncJsonResponse();
+    AsyncJsonResponse* response = new AsyncJsonResponse(false, SYSSTATUS_JSON_BASE_SIZE + Hoymiles.getNumInverters() * SYSSTATUS_JSON_INVERTER_SIZE);
     JsonObject root = response->getRoot();
 
     root[F("hostname")] = NetworkSettings.getHostname();
@@ -72,6 +72,31 @@ void WebApiSysstatusClass::onSystemStatus(AsyncWebServerRequest* request)
     root[F("radio_connected")] = Hoymiles.getRadio()->isConnected();
     root[F("radio_pvariant")] = Hoymiles.getRadio()->isPVariant();
 
+    CommandPoolStatistics cmdStats;
+    CommandPoolBase::getStatistics(cmdStats);
+    root[F("cmd_pool_allocations")] = cmdStats.poolAllocations;
+    root[F("cmd_heap_allocations")] = cmdStats.heapAllocations;
+    root[F("cmd_in_use")] = cmdStats.inUse;
+    root[F("cmd_max_in_use")] = cmdStats.maxInUse;
+
+    // RAM per inverter, the config slots are reserved statically for all INV_MAX_COUNT inverters
+    root[F("inverter_max_count")] = INV_MAX_COUNT;
+    root[F("inverter_config_size")] = sizeof(INVERTER_CONFIG_T);
+    root[F("inverter_shared_size")] = InverterAbstract::getSharedMemoryUsage();
+
+    JsonArray inverters = root.createNestedArray(F("inverter_memory"));
+    for (uint8_t i = 0; i < Hoymiles.getNumInverters(); i++) {
+        auto inv = Hoymiles.getInverterByPos(i);
+        if (inv == nullptr) {
+            continue;
+        }
+
+        JsonObject invObject = inverters.createNestedObject();
+        invObject[F("serial")] = inv->serialString();
+        invObject[F("name")] = inv->name();
+        invObject[F("size")] = inv->getMemoryUsage();
+    }
+
     response->setLength();
     request->send(response);
 }
\ No newline at end of file
@@ -3,13 +3,18 @@
  * Copyright (C) 2022 Thomas Basler and others
  */
 #include "WebApi_vedirect.h"
-#include "VeDirectFrameHandler.h"
 #include "ArduinoJson.h"
 #include "AsyncJson.h"
 #include "Configuration.h"
+#include "VeDirect.h"
 #include "WebApi.h"
 #include "WebApi_errors.h"
 #include "helper.h"
+#include <ctime>
+
+#define VEDIRECT_HISTORY_CSV_ROW_LEN 48 // max. length of "timestamp,V,I,VPV,PPV,CS\n"
+#define VEDIRECT_HISTORY_BIN_ROW_LEN 13
+#define VEDIRECT_HISTORY_CHUNK_COUNT 16
 
 void WebApiVedirectClass::init(AsyncWebServer* server)
 {
@@ -20,6 +25,9 @@ void WebApiVedirectClass::init(AsyncWebServer* server)
     _server->on("/api/vedirect/status", HTTP_GET, std::bind(&WebApiVedirectClass::onVedirectStatus, this, _1));
     _server->on("/api/vedirect/config", HTTP_GET, std::bind(&WebApiVedirectClass::onVedirectAdminGet, this, _1));
     _server->on("/api/vedirect/config", HTTP_POST, std::bind(&WebApiVedirectClass::onVedirectAdminPost, this, _1));
+    _server->on("/api/vedirect/history", HTTP_GET, std::bind(&WebApiVedirectClass::onVedirectHistory, this, _1));
+    _server->on("/api/vedirect/register", HTTP_GET, std::bind(&WebApiVedirectClass::onVedirectRegisterGet, this, _1));
+    _server->on("/api/vedirect/register", HTTP_POST, std::bind(&WebApiVedirectClass::onVedirectRegisterPost, this, _1));
 }
 
 void WebApiVedirectClass::loop()
@@ -32,7 +40,7 @@ void WebApiVedirectClass::onVedirectStatus(AsyncWebServerRequest* request)
         return;
     }
     
-    AsyncJsonResponse* response = new AsyncJsonResponse();
+    AsyncJsonResponse* response = new AsyncJsonResponse(false, 1024U * (1 + VeDirect.getNumDevices()));
     JsonObject root = response->getRoot();
     const CONFIG_T& config = Configuration.get();
 
@@ -40,6 +48,39 @@ void WebApiVedirectClass::onVedirectStatus(AsyncWebServerRequest* request)
     root[F("vedirect_pollinterval")] = config.Vedirect_PollInterval;
     root[F("vedirect_updatesonly")] = config.Vedirect_UpdatesOnly;
 
+    JsonArray devices = root.createNestedArray(F("devices"));
+    for (uint8_t i = 0; i < VEDIRECT_MAX_COUNT; i++) {
+        JsonObject dev = devices.createNestedObject();
+        dev[F("enabled")] = config.Vedirect_Device[i].Enabled;
+        dev[F("name")] = config.Vedirect_Device[i].Name;
+        dev[F("rx_pin")] = config.Vedirect_Device[i].RxPin;
+        dev[F("tx_pin")] = config.Vedirect_Device[i].TxPin;
+    }
+
+    JsonArray statistics = root.createNestedArray(F("statistics"));
+    for (uint8_t pos = 0; pos < VeDirect.getNumDevices(); pos++) {
+        auto dev = VeDirect.getDeviceByPos(pos);
+        VeDirectParserStats stats;
+        dev->getParserStats(stats);
+
+        JsonObject obj = statistics.createNestedObject();
+        obj[F("name")] = dev->name();
+        obj[F("bytes")] = stats.bytes;
+        obj[F("frames")] = stats.frames;
+        obj[F("checksum_errors")] = stats.checksumErrors;
+        obj[F("hex_frames")] = stats.hexFrames;
+        obj[F("hex_errors")] = stats.hexErrors;
+        obj[F("uart_overruns")] = stats.uartOverruns;
+        obj[F("uart_frame_errors")] = stats.uartFrameErrors;
+        obj[F("max_frame_gap")] = stats.maxFrameGap;
+
+        // bucket n counts latencies below 2^(n + 6) us, the last one all others
+        JsonArray latency = obj.createNestedArray(F("latency"));
+        for (uint8_t b = 0; b < VE_LATENCY_BUCKETS; b++) {
+            latency.add(stats.latency[b]);
+        }
+    }
+
     response->setLength();
     request->send(response);
 }
@@ -58,6 +99,15 @@ void WebApiVedirectClass::onVedirectAdminGet(AsyncWebServerRequest* request)
     root[F("vedirect_pollinterval")] = config.Vedirect_PollInterval;
     root[F("vedirect_updatesonly")] = config.Vedirect_UpdatesOnly;
 
+    JsonArray devices = root.createNestedArray(F("devices"));
+    for (uint8_t i = 0; i < VEDIRECT_MAX_COUNT; i++) {
+        JsonObject dev = devices.createNestedObject();
+        dev[F("enabled")] = config.Vedirect_Device[i].Enabled;
+        dev[F("name")] = config.Vedirect_Device[i].Name;
+        dev[F("rx_pin")] = config.Vedirect_Device[i].RxPin;
+        dev[F("tx_pin")] = config.Vedirect_Device[i].TxPin;
+    }
+
     response->setLength();
     request->send(response);
 }
@@ -120,7 +170,38 @@ void WebApiVedirectClass::onVedirectAdminPost(AsyncWebServerRequest* request)
         return;
     }
 
+    // devices are optional to stay compatible with clients which only know the common settings
+    JsonArray devices = root[F("devices")];
+    for (uint8_t i = 0; i < devices.size() && i < VEDIRECT_MAX_COUNT; i++) {
+        if (devices[i][F("name")].as<String>().length() > VEDIRECT_MAX_NAME_STRLEN) {
+            retMsg[F("message")] = F("Name must not be longer than " STR(VEDIRECT_MAX_NAME_STRLEN) " characters!");
+            retMsg[F("code")] = WebApiError::VedirectNameLength;
+            retMsg[F("param")][F("max")] = VEDIRECT_MAX_NAME_STRLEN;
+            response->setLength();
+            request->send(response);
+            return;
+        }
+
+        int rxPin = devices[i][F("rx_pin")] | -1;
+        int txPin = devices[i][F("tx_pin")] | -1;
+        if (rxPin < -1 || rxPin > 39 || txPin < -1 || txPin > 39) {
+            retMsg[F("message")] = F("Pins must be a number between -1 and 39!");
+            retMsg[F("code")] = WebApiError::VedirectInvalidPin;
+            retMsg[F("param")][F("min")] = -1;
+            retMsg[F("param")][F("max")] = 39;
+            response->setLength();
+            request->send(response);
+            return;
+        }
+    }
+
     CONFIG_T& config = Configuration.get();
+    for (uint8_t i = 0; i < devices.size() && i < VEDIRECT_MAX_COUNT; i++) {
+        config.Vedirect_Device[i].Enabled = devices[i][F("enabled")] | false;
+        strlcpy(config.Vedirect_Device[i].Name, devices[i][F("name")] | "", sizeof(config.Vedirect_Device[i].Name));
+        config.Vedirect_Device[i].RxPin = devices[i][F("rx_pin")] | -1;
+        config.Vedirect_Device[i].TxPin = devices[i][F("tx_pin")] | -1;
+    }
     config.Vedirect_Enabled = root[F("vedirect_enabled")].as<bool>();
     config.Vedirect_UpdatesOnly = root[F("vedirect_updatesonly")].as<bool>();
     config.Vedirect_PollInterval = root[F("vedirect_pollinterval")].as<uint32_t>();
@@ -132,6 +213,244 @@ void WebApiVedirectClass::onVedirectAdminPost(AsyncWebServerRequest* request)
 
     response->setLength();
     request->send(response);
+}
+/*
+ * Parameters:
+ *   device  position of the device (default 0)
+ *   tier    0 = 1 s, 1 = 1 min, 2 = 15 min resolution (default 0)
+ *   since   only samples newer than this timestamp
+ *   format  csv (default) or bin
+ * Timestamps are unix time if the time is synchronized, otherwise uptime in seconds.
+ * A binary row is little endian: uint32 timestamp, uint16 V (10 mV), int16 I (10 mA),
+ * uint16 VPV (10 mV), uint16 PPV (W), uint8 CS (255 = no data).
+ */
+void WebApiVedirectClass::onVedirectHistory(AsyncWebServerRequest* request)
+{
+    if (!WebApi.checkCredentialsReadonly(request)) {
+        return;
+    }
+
+    uint8_t pos = request->hasParam("device") ? request->getParam("device")->value().toInt() : 0;
+    uint8_t tier = request->hasParam("tier") ? request->getParam("tier")->value().toInt() : 0;
+    bool csv = !request->hasParam("format") || request->getParam("format")->value() != "bin";
+
+    std::shared_ptr<VeDirectHistory> history = VeDirect.getHistoryByPos(pos);
+    if (history == nullptr || tier >= VE_HISTORY_TIER_COUNT) {
+        request->send(404);
+        return;
+    }
+
+    int64_t offset = 0;
+    struct tm timeinfo;
+    if (getLocalTime(&timeinfo, 5)) {
+        offset = std::time(0) - esp_timer_get_time() / 1000000;
+    }
+
+    uint32_t since = 0;
+    if (request->hasParam("since")) {
+        int64_t s = strtoll(request->getParam("since")->value().c_str(), nullptr, 10) - offset;
+        since = s > 0 ? s : 0;
+    }
+    uint32_t cursor = history->findPos(tier, since);
+    bool headerSent = !csv;
+
+    // the history is read in small chunks, so it is never copied completely
+    AsyncWebServerResponse* response = request->beginChunkedResponse(csv ? "text/csv" : "application/octet-stream",
+        [history, tier, csv, offset, cursor, headerSent](uint8_t* buffer, size_t maxLen, size_t) mutable -> size_t {
+            size_t len = 0;
+            if (!headerSent) {
+                len = snprintf(reinterpret_cast<char*>(buffer), maxLen, "timestamp,V,I,VPV,PPV,CS\n");
+                headerSent = true;
+            }
+
+            size_t maxCount = (maxLen - len) / (csv ? VEDIRECT_HISTORY_CSV_ROW_LEN : VEDIRECT_HISTORY_BIN_ROW_LEN);
+            if (maxCount > VEDIRECT_HISTORY_CHUNK_COUNT) {
+                maxCount = VEDIRECT_HISTORY_CHUNK_COUNT;
+            }
+            if (maxCount == 0) {
+                return len > 0 ? len : RESPONSE_TRY_AGAIN;
+            }
+
+            VeDirectHistoryEntry entries[VEDIRECT_HISTORY_CHUNK_COUNT];
+            size_t count = history->read(tier, cursor, entries, maxCount);
+
+            for (size_t i = 0; i < count; i++) {
+                const VeDirectSample& s = entries[i].sample;
+                int64_t timestamp = entries[i].timestamp + offset;
+
+                if (csv) {
+                    char* row = reinterpret_cast<char*>(buffer + len);
+                    if (s.CS == VE_HISTORY_NO_DATA) {
+                        len += snprintf(row, maxLen - len, "%lld,,,,,\n", timestamp);
+                    } else {
+                        len += snprintf(row, maxLen - len, "%lld,%.2f,%.2f,%.2f,%u,%u\n",
+                            timestamp, s.V / 100.0, s.I / 100.0, s.VPV / 100.0, s.PPV, s.CS);
+                    }
+                } else {
+                    uint32_t ts = timestamp;
+                    memcpy(buffer + len, &ts, sizeof(ts));
+                    memcpy(buffer + len + 4, &s.V, sizeof(s.V));
+                    memcpy(buffer + len + 6, &s.I, sizeof(s.I));
+                    memcpy(buffer + len + 8, &s.VPV, sizeof(s.VPV));
+                    memcpy(buffer + len + 10, &s.PPV, sizeof(s.PPV));
+                    buffer[len + 12] = s.CS;
+                    len += VEDIRECT_HISTORY_BIN_ROW_LEN;
+                }
+            }
+            return len;
+        });
+    request->send(response);
+}
+
+/*
+ * Last known values of the hex registers which were read, written or reported by the device.
+ * Parameters:
+ *   device  position of the device (default 0)
+ * response is "get", "set", "async" or "timeout", flags are the VE.Direct hex flags
+ * (1 = unknown id, 2 = not supported, 4 = parameter error), age is in seconds.
+ */
+void WebApiVedirectClass::onVedirectRegisterGet(AsyncWebServerRequest* request)
+{
+    if (!WebApi.checkCredentialsReadonly(request)) {
+        return;
+    }
+
+    uint8_t pos = request->hasParam("device") ? request->getParam("device")->value().toInt() : 0;
+    if (pos >= VeDirect.getNumDevices()) {
+        request->send(404);
+        return;
+    }
+
+    VeDirectRegister registers[VE_REGISTER_CACHE_SIZE];
+    uint8_t count = VeDirect.getRegisters(pos, registers, VE_REGISTER_CACHE_SIZE);
+
+    AsyncJsonResponse* response = new AsyncJsonResponse(false, 256U + count * 128U);
+    JsonObject root = response->getRoot();
+    JsonArray data = root.createNestedArray(F("registers"));
+
+    for (uint8_t i = 0; i < count; i++) {
+        const VeDirectHexData& d = registers[i].data;
+        JsonObject obj = data.createNestedObject();
+
+        char id[7];
+        snprintf(id, sizeof(id), "0x%04X", d.id);
+        obj[F("id")] = id;
+
+        switch (d.response) {
+        case VE_HEX_RSP_GET:
+            obj[F("response")] = F("get");
+            break;
+        case VE_HEX_RSP_SET:
+            obj[F("response")] = F("set");
+            break;
+        case VE_HEX_RSP_ASYNC:
+            obj[F("response")] = F("async");
+            break;
+        default:
+            obj[F("response")] = F("timeout");
+            break;
+        }
+        obj[F("flags")] = d.flags;
+        obj[F("value")] = d.value;
+        obj[F("size")] = d.size;
+        obj[F("age")] = (millis() - registers[i].timestamp) / 1000;
+    }
+
+    response->setLength();
+    request->send(response);
+}
+
+/*
+ * Reads or writes a hex register, the result is reported by /api/vedirect/register and MQTT.
+ * Data: {"device": 0, "id": "0xEDF0"} to read, additionally "value" and "size" (1, 2 or 4 bytes) to write.
+ */
+void WebApiVedirectClass::onVedirectRegisterPost(AsyncWebServerRequest* request)
+{
+    if (!WebApi.checkCredentials(request)) {
+        return;
+    }
+
+    AsyncJsonResponse* response = new AsyncJsonResponse();
+    JsonObject retMsg = response->getRoot();
+    retMsg[F("type")] = F("warning");
+
+    if (!request->hasParam("data", true)) {
+        retMsg[F("message")] = F("No values found!");
+        retMsg[F("code")] = WebApiError::GenericNoValueFound;
+        response->setLength();
+        request->send(response);
+        return;
+    }
 
-    VeDirect.setPollInterval(config.Vedirect_PollInterval);
-}
\ No newline at end of file
+    String json = request->getParam("data", true)->value();
+
+    if (json.length() > 1024) {
+        retMsg[F("message")] = F("Data too large!");
+        retMsg[F("code")] = WebApiError::GenericDataTooLarge;
+        response->setLength();
+        request->send(response);
+        return;
+    }
+
+    DynamicJsonDocument root(1024);
+    DeserializationError error = deserializeJson(root, json);
+
+    if (error) {
+        retMsg[F("message")] = F("Failed to parse data!");
+        retMsg[F("code")] = WebApiError::GenericParseError;
+        response->setLength();
+        request->send(response);
+        return;
+    }
+
+    if (!root.containsKey("id")) {
+        retMsg[F("message")] = F("Values are missing!");
+        retMsg[F("code")] = WebApiError::GenericValueMissing;
+        response->setLength();
+        request->send(response);
+        return;
+    }
+
+    uint8_t pos = root[F("device")] | 0;
+    if (pos >= VeDirect.getNumDevices()) {
+        retMsg[F("message")] = F("Invalid device specified!");
+        retMsg[F("code")] = WebApiError::VedirectInvalidDevice;
+        response->setLength();
+        request->send(response);
+        return;
+    }
+
+    // numbers may also be given as string, e.g. "0xEDF0"
+    uint16_t id = strtoul(root[F("id")].as<String>().c_str(), nullptr, 0);
+
+    bool sent;
+    if (root.containsKey("value")) {
+        uint8_t size = root[F("size")] | 0;
+        if (size != 1 && size != 2 && size != 4) {
+            retMsg[F("message")] = F("Size must be 1, 2 or 4 bytes!");
+            retMsg[F("code")] = WebApiError::VedirectRegisterSize;
+            response->setLength();
+            request->send(response);
+            return;
+        }
+        uint32_t value = strtoul(root[F("value")].as<String>().c_str(), nullptr, 0);
+        sent = VeDirect.writeRegister(pos, id, value, size);
+    } else {
+        sent = VeDirect.readRegister(pos, id);
+    }
+
+    if (!sent) {
+        retMsg[F("message")] = F("Too many pending requests, try again later!");
+        retMsg[F("code")] = WebApiError::VedirectRegisterBusy;
+        response->setLength();
+        request->send(response);
+        return;
+    }
+
+    retMsg[F("type")] = F("success");
+    retMsg[F("message")] = F("Request sent!");
+    retMsg[F("code")] = WebApiError::VedirectRegisterSent;
+
+    response->setLength();
+    request->send(response);
+}
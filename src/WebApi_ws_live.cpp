@@ -43,6 +43,10 @@ void WebApiWsLiveClass::loop()
         return;
     }
 
+    if (_wsRoundPending) {
+        sendNextInverter();
+    }
+
     if (millis() - _lastInvUpdateCheck < 1000) {
         return;
     }
@@ -57,34 +61,107 @@ void WebApiWsLiveClass::loop()
         }
     }
 
-    // Update on every inverter change or at least after 10 seconds
-    if (millis() - _lastWsPublish > (10 * 1000) || (maxTimeStamp != _newestInverterTimestamp)) {
+    // Update on every inverter change or at least after 10 seconds,
+    // changes during a running round start the next one when it is finished
+    if (!_wsRoundPending && (millis() - _lastWsPublish > (10 * 1000) || (maxTimeStamp != _newestInverterTimestamp))) {
+        if (Configuration.get().Security_AllowReadonly) {
+            _ws.setAuthentication("", "");
+        } else {
+            _ws.setAuthentication(AUTH_USERNAME, Configuration.get().Security_Password);
+        }
 
-        DynamicJsonDocument root(40960);
-        JsonVariant var = root;
-        generateJsonResponse(var);
+        _wsNextInverter = 0;
+        _wsRoundPending = true;
+        _newestInverterTimestamp = maxTimeStamp;
+        _lastWsPublish = millis();
+    }
+}
 
-        String buffer;
-        if (buffer) {
-            serializeJson(root, buffer);
+// One message per inverter keeps the document small for any number of inverters.
+// The next one is only sent when every client has room for it in its queue.
+void WebApiWsLiveClass::sendNextInverter()
+{
+    if (!_ws.availableForWriteAll()) {
+        return;
+    }
 
-            if (Configuration.get().Security_AllowReadonly) {
-                _ws.setAuthentication("", "");
-            } else {
-                _ws.setAuthentication(AUTH_USERNAME, Configuration.get().Security_Password);
-            }
+    uint8_t count = Hoymiles.getNumInverters();
+    DynamicJsonDocument root(LIVEDATA_JSON_BASE_SIZE + LIVEDATA_JSON_INVERTER_SIZE);
+    JsonVariant var = root;
 
-            _ws.textAll(buffer);
+    JsonArray invArray = root.createNestedArray("inverters");
+    auto inv = Hoymiles.getInverterByPos(_wsNextInverter);
+    if (inv != nullptr) {
+        JsonObject invObject = invArray.createNestedObject();
+        generateInverterJson(invObject, _wsNextInverter, inv);
+    }
+    root[F("index")] = _wsNextInverter;
+    root[F("count")] = count;
+    generateTotalJson(var);
+
+    String buffer;
+    if (buffer) {
+        serializeJson(root, buffer);
+        _ws.textAll(buffer);
+    }
+
+    _wsNextInverter++;
+    _wsRoundPending = _wsNextInverter < count;
+}
+
+void WebApiWsLiveClass::generateInverterJson(JsonObject& invObject, uint8_t i, std::shared_ptr<InverterAbstract> inv)
+{
+    invObject[F("serial")] = inv->serialString();
+    invObject[F("name")] = inv->name();
+    invObject[F("data_age")] = (millis() - inv->Statistics()->getLastUpdate()) / 1000;
+    invObject[F("reachable")] = inv->isReachable();
+    invObject[F("producing")] = inv->isProducing();
+    invObject[F("limit_relative")] = inv->SystemConfigPara()->getLimitPercent();
+    if (inv->DevInfo()->getMaxPower() > 0) {
+        invObject[F("limit_absolute")] = inv->SystemConfigPara()->getLimitPercent() * inv->DevInfo()->getMaxPower() / 100.0;
+    } else {
+        invObject[F("limit_absolute")] = -1;
+    }
+
+    // Loop all channels
+    for (uint8_t c = 0; c <= inv->Statistics()->getChannelCount(); c++) {
+        if (c > 0) {
+            INVERTER_CONFIG_T* inv_cfg = Configuration.getInverterConfig(inv->serial());
+            if (inv_cfg != nullptr) {
+                invObject[String(c)][F("name")]["u"] = inv_cfg->channel[c - 1].Name;
+            }
+        }
+        addField(invObject, i, inv, c, FLD_PAC);
+        addField(invObject, i, inv, c, FLD_UAC);
+        addField(invObject, i, inv, c, FLD_IAC);
+        if (c == 0) {
+            addField(invObject, i, inv, c, FLD_PDC, F("Power DC"));
+        } else {
+            addField(invObject, i, inv, c, FLD_PDC);
         }
+        addField(invObject, i, inv, c, FLD_UDC);
+        addField(invObject, i, inv, c, FLD_IDC);
+        addField(invObject, i, inv, c, FLD_YD);
+        addField(invObject, i, inv, c, FLD_YT);
+        addField(invObject, i, inv, c, FLD_F);
+        addField(invObject, i, inv, c, FLD_T);
+        addField(invObject, i, inv, c, FLD_PF);
+        addField(invObject, i, inv, c, FLD_PRA);
+        addField(invObject, i, inv, c, FLD_EFF);
+        if (c > 0 && inv->Statistics()->getChannelMaxPower(c - 1) > 0) {
+            addField(invObject, i, inv, c, FLD_IRR);
+        }
+    }
 
-        _lastWsPublish = millis();
+    if (inv->Statistics()->hasChannelFieldValue(CH0, FLD_EVT_LOG)) {
+        invObject[F("events")] = inv->EventLog()->getEntryCount();
+    } else {
+        invObject[F("events")] = -1;
     }
 }
 
-void WebApiWsLiveClass::generateJsonResponse(JsonVariant& root)
+void WebApiWsLiveClass::generateTotalJson(JsonVariant& root)
 {
-    JsonArray invArray = root.createNestedArray("inverters");
-
     float totalPower = 0;
     float totalYieldDay = 0;
     float totalYieldTotal = 0;
@@ -96,60 +173,6 @@ void WebApiWsLiveClass::generateJsonResponse(JsonVariant& root)
             continue;
         }
 
-        JsonObject invObject = invArray.createNestedObject();
-
-        invObject[F("serial")] = inv->serialString();
-        invObject[F("name")] = inv->name();
-        invObject[F("data_age")] = (millis() - inv->Statistics()->getLastUpdate()) / 1000;
-        invObject[F("reachable")] = inv->isReachable();
-        invObject[F("producing")] = inv->isProducing();
-        invObject[F("limit_relative")] = inv->SystemConfigPara()->getLimitPercent();
-        if (inv->DevInfo()->getMaxPower() > 0) {
-            invObject[F("limit_absolute")] = inv->SystemConfigPara()->getLimitPercent() * inv->DevInfo()->getMaxPower() / 100.0;
-        } else {
-            invObject[F("limit_absolute")] = -1;
-        }
-
-        // Loop all channels
-        for (uint8_t c = 0; c <= inv->Statistics()->getChannelCount(); c++) {
-            if (c > 0) {
-                INVERTER_CONFIG_T* inv_cfg = Configuration.getInverterConfig(inv->serial());
-                if (inv_cfg != nullptr) {
-                    invObject[String(c)][F("name")]["u"] = inv_cfg->channel[c - 1].Name;
-                }
-            }
-            addField(invObject, i, inv, c, FLD_PAC);
-            addField(invObject, i, inv, c, FLD_UAC);
-            addField(invObject, i, inv, c, FLD_IAC);
-            if (c == 0) {
-                addField(invObject, i, inv, c, FLD_PDC, F("Power DC"));
-            } else {
-                addField(invObject, i, inv, c, FLD_PDC);
-            }
-            addField(invObject, i, inv, c, FLD_UDC);
-            addField(invObject, i, inv, c, FLD_IDC);
-            addField(invObject, i, inv, c, FLD_YD);
-            addField(invObject, i, inv, c, FLD_YT);
-            addField(invObject, i, inv, c, FLD_F);
-            addField(invObject, i, inv, c, FLD_T);
-            addField(invObject, i, inv, c, FLD_PF);
-            addField(invObject, i, inv, c, FLD_PRA);
-            addField(invObject, i, inv, c, FLD_EFF);
-            if (c > 0 && inv->Statistics()->getChannelMaxPower(c - 1) > 0) {
-                addField(invObject, i, inv, c, FLD_IRR);
-            }
-        }
-
-        if (inv->Statistics()->hasChannelFieldValue(CH0, FLD_EVT_LOG)) {
-            invObject[F("events")] = inv->EventLog()->getEntryCount();
-        } else {
-            invObject[F("events")] = -1;
-        }
-
-        if (inv->Statistics()->getLastUpdate() > _newestInverterTimestamp) {
-            _newestInverterTimestamp = inv->Statistics()->getLastUpdate();
-        }
-
         totalPower += inv->Statistics()->getChannelFieldValue(CH0, FLD_PAC);
         totalYieldDay += inv->Statistics()->getChannelFieldValue(CH0, FLD_YD);
         totalYieldTotal += inv->Statistics()->getChannelFieldValue(CH0, FLD_YT);
@@ -213,11 +236,58 @@ void WebApiWsLiveClass::onLivedataStatus(AsyncWebServerRequest* request)
         return;
     }
 
-    AsyncJsonResponse* response = new AsyncJsonResponse(false, 40960U);
-    JsonVariant root = response->getRoot();
-
-    generateJsonResponse(root);
+    uint8_t pos = 0;
+    String pending = "{\"inverters\":[";
+    size_t sent = 0;
+    bool first = true;
+    bool done = false;
+
+    // the inverters are serialized one by one, so the document never holds all of them
+    AsyncWebServerResponse* response = request->beginChunkedResponse("application/json",
+        [this, pos, pending, sent, first, done](uint8_t* buffer, size_t maxLen, size_t) mutable -> size_t {
+            size_t len = 0;
+            while (len < maxLen) {
+                if (sent == pending.length()) {
+                    if (done) {
+                        break;
+                    }
+                    pending = "";
+                    sent = 0;
+                    if (pos < Hoymiles.getNumInverters()) {
+                        auto inv = Hoymiles.getInverterByPos(pos);
+                        if (inv != nullptr) {
+                            DynamicJsonDocument root(LIVEDATA_JSON_INVERTER_SIZE);
+                            JsonObject invObject = root.to<JsonObject>();
+                            generateInverterJson(invObject, pos, inv);
+                            if (!first) {
+                                pending = ",";
+                            }
+                            String invJson;
+                            serializeJson(root, invJson);
+                            pending += invJson;
+                            first = false;
+                        }
+                        pos++;
+                    } else {
+                        DynamicJsonDocument root(LIVEDATA_JSON_BASE_SIZE);
+                        JsonVariant var = root;
+                        generateTotalJson(var);
+                        String total;
+                        serializeJson(root, total);
+                        // appended to the object started by the inverters array
+                        pending = "],";
+                        pending += total.substring(1);
+                        done = true;
+                    }
+                    continue;
+                }
 
-    response->setLength();
+                size_t chunk = std::min(maxLen - len, pending.length() - sent);
+                memcpy(buffer + len, pending.c_str() + sent, chunk);
+                len += chunk;
+                sent += chunk;
+            }
+            return len;
+        });
     request->send(response);
 }
\ No newline at end of file
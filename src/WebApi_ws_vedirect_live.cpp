@@ -6,6 +6,7 @@
 #include "AsyncJson.h"
 #include "Configuration.h"
 #include "MessageOutput.h"
+#include "VeDirect.h"
 #include "WebApi.h"
 #include "defaults.h"
 
@@ -49,14 +50,17 @@ void WebApiWsVedirectLiveClass::loop()
     _lastVedirectUpdateCheck = millis();
 
     uint32_t maxTimeStamp = 0;
-    if (VeDirect.getLastUpdate() > maxTimeStamp) {
-        maxTimeStamp = VeDirect.getLastUpdate();
+    for (uint8_t pos = 0; pos < VeDirect.getNumDevices(); pos++) {
+        auto dev = VeDirect.getDeviceByPos(pos);
+        if (dev->getLastUpdate() > maxTimeStamp) {
+            maxTimeStamp = dev->getLastUpdate();
+        }
     }
 
     // Update on ve.direct change or at least after 10 seconds
     if (millis() - _lastWsPublish > (10 * 1000) || (maxTimeStamp != _newestVedirectTimestamp)) {
 
-        DynamicJsonDocument root(1024);
+        DynamicJsonDocument root(getJsonSize());
         JsonVariant var = root;
         generateJsonResponse(var);
 
@@ -77,46 +81,137 @@ void WebApiWsVedirectLiveClass::loop()
     }
 }
 
+size_t WebApiWsVedirectLiveClass::getJsonSize()
+{
+    // the first device is duplicated at the top level
+    return VEDIRECT_JSON_DEVICE_SIZE * (VeDirect.getNumDevices() + 1);
+}
+
 void WebApiWsVedirectLiveClass::generateJsonResponse(JsonVariant& root)
 {
+    JsonArray devices = root.createNestedArray(F("devices"));
+    for (uint8_t pos = 0; pos < VeDirect.getNumDevices(); pos++) {
+        auto dev = VeDirect.getDeviceByPos(pos);
+
+        // the first device is also sent at the top level as it was before multiple devices were supported
+        if (pos == 0) {
+            generateDeviceJson(root.as<JsonObject>(), dev.get());
+        }
+        generateDeviceJson(devices.createNestedObject(), dev.get());
+
+        if (dev->getLastUpdate() > _newestVedirectTimestamp) {
+            _newestVedirectTimestamp = dev->getLastUpdate();
+        }
+    }
+}
+
+// texts point into flash and are not copied by ArduinoJson, unknown codes are sent as number
+static void addCodeText(JsonObject& root, const __FlashStringHelper* key, const char* text, const char* format, uint32_t code)
+{
+    if (text != nullptr) {
+        root[key] = text;
+    } else {
+        char buffer[12];
+        snprintf(buffer, sizeof(buffer), format, code);
+        root[key] = buffer;
+    }
+}
+
+void WebApiWsVedirectLiveClass::generateDeviceJson(JsonObject root, VeDirectFrameHandler* dev)
+{
+    VeDirectRecord frame;
+    VeDirectRecordText text;
+    dev->getFrame(frame, text);
+
     // device info
-    root[F("data_age")] = (millis() - VeDirect.getLastUpdate() ) / 1000;
-    root[F("age_critical")] = ((millis() - VeDirect.getLastUpdate()) / 1000) > Configuration.get().Vedirect_PollInterval * 5;
-    root[F("PID")] = VeDirect.getPidAsString(VeDirect.veMap["PID"].c_str());
-    root[F("SER")] = VeDirect.veMap["SER"];
-    root[F("FW")] = VeDirect.veMap["FW"];
-    root[F("LOAD")] = VeDirect.veMap["LOAD"];
-    root[F("CS")] = VeDirect.getCsAsString(VeDirect.veMap["CS"].c_str());
-    root[F("ERR")] = VeDirect.getErrAsString(VeDirect.veMap["ERR"].c_str());
-    root[F("OR")] = VeDirect.getOrAsString(VeDirect.veMap["OR"].c_str());
-    root[F("MPPT")] = VeDirect.getMpptAsString(VeDirect.veMap["MPPT"].c_str());
-    root[F("HSDS")]["v"] = VeDirect.veMap["HSDS"].toInt();
+    root[F("name")] = dev->name();
+    root[F("data_age")] = (millis() - dev->getLastUpdate() ) / 1000;
+    root[F("age_critical")] = ((millis() - dev->getLastUpdate()) / 1000) > Configuration.get().Vedirect_PollInterval * 5;
+    addCodeText(root, F("PID"), text.PID, "0x%04X", frame.PID);
+    root[F("SER")] = frame.SER;
+    root[F("FW")] = frame.FW;
+    root[F("LOAD")] = frame.LOAD ? F("ON") : F("OFF");
+    addCodeText(root, F("CS"), text.CS, "%u", frame.CS);
+    addCodeText(root, F("ERR"), text.ERR, "%u", frame.ERR);
+    addCodeText(root, F("OR"), text.OR, "0x%08X", frame.OR);
+    addCodeText(root, F("MPPT"), text.MPPT, "%u", frame.MPPT);
+    root[F("HSDS")]["v"] = frame.HSDS;
     root[F("HSDS")]["u"] = "Days";
 
     // battery info    
-    root[F("V")]["v"] = round(VeDirect.veMap["V"].toDouble() / 10.0) / 100.0;
+    root[F("V")]["v"] = round(frame.V / 10.0) / 100.0;
     root[F("V")]["u"] = "V";
-    root[F("I")]["v"] = round(VeDirect.veMap["I"].toDouble() / 10.0) / 100.0;
+    root[F("I")]["v"] = round(frame.I / 10.0) / 100.0;
     root[F("I")]["u"] = "A";
 
     // panel info
-    root[F("VPV")]["v"] = round(VeDirect.veMap["VPV"].toDouble() / 10.0) / 100.0;
+    root[F("VPV")]["v"] = round(frame.VPV / 10.0) / 100.0;
     root[F("VPV")]["u"] = "V";
-    root[F("PPV")]["v"] = VeDirect.veMap["PPV"].toInt();
+    root[F("PPV")]["v"] = frame.PPV;
     root[F("PPV")]["u"] = "W";
-    root[F("H19")]["v"] = VeDirect.veMap["H19"].toDouble() / 100.0;
+    root[F("H19")]["v"] = frame.H19 / 100.0;
     root[F("H19")]["u"] = "kWh";
-    root[F("H20")]["v"] = VeDirect.veMap["H20"].toDouble() / 100.0;
+    root[F("H20")]["v"] = frame.H20 / 100.0;
     root[F("H20")]["u"] = "kWh";
-    root[F("H21")]["v"] = VeDirect.veMap["H21"].toInt();
+    root[F("H21")]["v"] = frame.H21;
     root[F("H21")]["u"] = "W";
-    root[F("H22")]["v"] = VeDirect.veMap["H22"].toDouble() / 100.0;
+    root[F("H22")]["v"] = frame.H22 / 100.0;
     root[F("H22")]["u"] = "kWh";
-    root[F("H23")]["v"] = VeDirect.veMap["H23"].toInt();
+    root[F("H23")]["v"] = frame.H23;
     root[F("H23")]["u"] = "W";
 
-    if (VeDirect.getLastUpdate() > _newestVedirectTimestamp) {
-        _newestVedirectTimestamp = VeDirect.getLastUpdate();
+    // battery monitor info, only sent by BMV and SmartShunt
+    if (frame.present & (1UL << VE_VS)) {
+        root[F("VS")]["v"] = round(frame.VS / 10.0) / 100.0;
+        root[F("VS")]["u"] = "V";
+    }
+    if (frame.present & (1UL << VE_VM)) {
+        root[F("VM")]["v"] = round(frame.VM / 10.0) / 100.0;
+        root[F("VM")]["u"] = "V";
+    }
+    if (frame.present & (1UL << VE_DM)) {
+        root[F("DM")]["v"] = frame.DM / 10.0;
+        root[F("DM")]["u"] = "%";
+    }
+    if (frame.present & (1UL << VE_T)) {
+        root[F("T")]["v"] = frame.T;
+        root[F("T")]["u"] = "°C";
+    }
+    if (frame.present & (1UL << VE_P)) {
+        root[F("P")]["v"] = frame.P;
+        root[F("P")]["u"] = "W";
+    }
+    if (frame.present & (1UL << VE_CE)) {
+        root[F("CE")]["v"] = round(frame.CE / 10.0) / 100.0;
+        root[F("CE")]["u"] = "Ah";
+    }
+    if (frame.present & (1UL << VE_SOC)) {
+        root[F("SOC")]["v"] = frame.SOC / 10.0;
+        root[F("SOC")]["u"] = "%";
+    }
+    if (frame.present & (1UL << VE_TTG)) {
+        root[F("TTG")]["v"] = frame.TTG;
+        root[F("TTG")]["u"] = "min";
+    }
+    if (frame.present & (1UL << VE_ALARM)) {
+        root[F("ALARM")] = frame.ALARM ? F("ON") : F("OFF");
+    }
+    if (frame.present & (1UL << VE_RELAY)) {
+        root[F("RELAY")] = frame.RELAY ? F("ON") : F("OFF");
+    }
+    if (frame.present & (1UL << VE_AR)) {
+        root[F("AR")] = frame.AR;
+    }
+    if (frame.present & (1UL << VE_MON)) {
+        root[F("MON")] = frame.MON;
+    }
+
+    // labels without a typed field (e.g. H1...H18) are sent as received
+    if (frame.extraCount > 0) {
+        JsonObject extra = root.createNestedObject(F("extra"));
+        for (uint8_t i = 0; i < frame.extraCount; i++) {
+            extra[frame.extra[i].name] = frame.extra[i].value;
+        }
     }
 }
 
@@ -140,7 +235,7 @@ void WebApiWsVedirectLiveClass::onLivedataStatus(AsyncWebServerRequest* request)
     if (!WebApi.checkCredentialsReadonly(request)) {
         return;
     }
-    AsyncJsonResponse* response = new AsyncJsonResponse(false, 1024U);
+    AsyncJsonResponse* response = new AsyncJsonResponse(false, getJsonSize());
     JsonVariant root = response->getRoot().as<JsonVariant>();
     generateJsonResponse(root);
 
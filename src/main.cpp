@@ -4,7 +4,6 @@
  */
 #include "Configuration.h"
 #include "MessageOutput.h"
-#include "VeDirectFrameHandler.h"
 #include "MqttHandleDtu.h"
 #include "MqttHandleHass.h"
 #include "MqttHandleInverter.h"
@@ -13,6 +12,7 @@
 #include "NetworkSettings.h"
 #include "NtpSettings.h"
 #include "Utils.h"
+#include "VeDirect.h"
 #include "WebApi.h"
 #include "defaults.h"
 #include <Arduino.h>
@@ -127,6 +127,8 @@ void setup()
                 for (uint8_t c = 0; c < INV_MAX_CHAN_COUNT; c++) {
                     inv->Statistics()->setChannelMaxPower(c, config.Inverter[i].channel[c].MaxChannelPower);
                 }
+                inv->Poll()->setStatsInterval(config.Inverter[i].PollInterval * 1000);
+                inv->Poll()->setAlarmLogInterval(config.Inverter[i].AlarmLogInterval * 1000);
             }
             MessageOutput.println(F(" done"));
         }
@@ -135,8 +137,23 @@ void setup()
 
     // Initialize ve.direct communication
     MessageOutput.println(F("Initialize ve.direct interface... "));
-    VeDirect.init();
-    VeDirect.setPollInterval(config.Vedirect_PollInterval);
+    if (config.Vedirect_Enabled) {
+        for (uint8_t i = 0; i < VEDIRECT_MAX_COUNT; i++) {
+            const VEDIRECT_CONFIG_T& dev = config.Vedirect_Device[i];
+            if (dev.Enabled && dev.RxPin >= 0) {
+                MessageOutput.print(F("  Adding device: "));
+                MessageOutput.print(dev.Name);
+                // UART0 is used for the console
+                auto device = VeDirect.addDevice(dev.Name, i + 1, dev.RxPin, dev.TxPin);
+                if (device != nullptr) {
+                    for (uint8_t field = 0; field < VE_FIELD_COUNT; field++) {
+                        device->setDeadband(field, config.Vedirect_Deadband[field]);
+                    }
+                }
+                MessageOutput.println(F(" done"));
+            }
+        }
+    }
     MessageOutput.println(F("done"));
 }
 
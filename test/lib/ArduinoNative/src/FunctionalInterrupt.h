@@ -0,0 +1,8 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+// The handler is called by NativeSim::triggerInterrupt()
+void attachInterrupt(uint8_t pin, std::function<void(void)> handler, int mode);
@@ -0,0 +1,152 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2022 Thomas Basler and others
+ */
+#include "HardwareSerial.h"
+#include <cstdio>
+
+#define HARDWARE_SERIAL_PORT_COUNT 3
+
+static HardwareSerial* ports[HARDWARE_SERIAL_PORT_COUNT];
+
+HardwareSerial Serial(0);
+
+HardwareSerial::HardwareSerial(int uartNum)
+    : _uartNum(uartNum)
+{
+    if (uartNum >= 0 && uartNum < HARDWARE_SERIAL_PORT_COUNT) {
+        ports[uartNum] = this;
+    }
+}
+
+HardwareSerial::~HardwareSerial()
+{
+    if (_uartNum >= 0 && _uartNum < HARDWARE_SERIAL_PORT_COUNT && ports[_uartNum] == this) {
+        ports[_uartNum] = nullptr;
+    }
+}
+
+HardwareSerial* HardwareSerial::getPort(int uartNum)
+{
+    if (uartNum < 0 || uartNum >= HARDWARE_SERIAL_PORT_COUNT) {
+        return nullptr;
+    }
+    return ports[uartNum];
+}
+
+void HardwareSerial::begin(unsigned long baud, uint32_t config, int8_t rxPin, int8_t txPin)
+{
+    _rxBuffer.assign(_rxBufferSize, 0);
+    _rxHead = 0;
+    _rxCount = 0;
+}
+
+void HardwareSerial::end()
+{
+    _rxBuffer.clear();
+    _rxHead = 0;
+    _rxCount = 0;
+}
+
+size_t HardwareSerial::setRxBufferSize(size_t size)
+{
+    _rxBufferSize = size;
+    return size;
+}
+
+void HardwareSerial::onReceive(OnReceiveCb function, bool onlyOnTimeout)
+{
+    _onReceive = function;
+}
+
+void HardwareSerial::onReceiveError(OnReceiveErrorCb function)
+{
+    _onReceiveError = function;
+}
+
+int HardwareSerial::available()
+{
+    return _rxCount;
+}
+
+int HardwareSerial::read()
+{
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+int HardwareSerial::peek()
+{
+    return _rxCount > 0 ? _rxBuffer[_rxHead] : -1;
+}
+
+size_t HardwareSerial::read(uint8_t* buffer, size_t size)
+{
+    size_t n = 0;
+    while (n < size && _rxCount > 0) {
+        buffer[n++] = _rxBuffer[_rxHead];
+        _rxHead = (_rxHead + 1) % _rxBuffer.size();
+        _rxCount--;
+    }
+    return n;
+}
+
+void HardwareSerial::flush()
+{
+    if (_uartNum == 0) {
+        fflush(stdout);
+    }
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+    return write(&c, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size)
+{
+    if (_uartNum == 0) {
+        return _consoleOutput ? fwrite(buffer, 1, size, stdout) : size;
+    }
+    _txData.append(reinterpret_cast<const char*>(buffer), size);
+    return size;
+}
+
+size_t HardwareSerial::receive(const uint8_t* data, size_t len)
+{
+    size_t n = 0;
+    while (n < len && _rxCount < _rxBuffer.size()) {
+        _rxBuffer[(_rxHead + _rxCount) % _rxBuffer.size()] = data[n++];
+        _rxCount++;
+    }
+
+    if (n > 0 && _onReceive) {
+        _onReceive();
+    }
+    if (n < len) {
+        receiveError(UART_BUFFER_FULL_ERROR);
+    }
+    return n;
+}
+
+void HardwareSerial::receiveError(hardwareSerial_error_t error)
+{
+    if (_onReceiveError) {
+        _onReceiveError(error);
+    }
+}
+
+const std::string& HardwareSerial::getTxData()
+{
+    return _txData;
+}
+
+void HardwareSerial::clearTxData()
+{
+    _txData.clear();
+}
+
+void HardwareSerial::setConsoleOutput(bool enable)
+{
+    _consoleOutput = enable;
+}
@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "Stream.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+#define SERIAL_8N1 0x800001c
+
+typedef enum {
+    UART_NO_ERROR,
+    UART_BREAK_ERROR,
+    UART_BUFFER_FULL_ERROR,
+    UART_FIFO_OVF_ERROR,
+    UART_FRAME_ERROR,
+    UART_PARITY_ERROR
+} hardwareSerial_error_t;
+
+typedef std::function<void(void)> OnReceiveCb;
+typedef std::function<void(hardwareSerial_error_t)> OnReceiveErrorCb;
+
+// UART without hardware. Uart 0 is the console and prints to stdout, the data
+// of the others is injected by the test with receive() and collected in getTxData().
+class HardwareSerial : public Stream {
+public:
+    explicit HardwareSerial(int uartNum);
+    ~HardwareSerial();
+
+    void begin(unsigned long baud, uint32_t config = SERIAL_8N1, int8_t rxPin = -1, int8_t txPin = -1);
+    void end();
+    size_t setRxBufferSize(size_t size);
+    void onReceive(OnReceiveCb function, bool onlyOnTimeout = false);
+    void onReceiveError(OnReceiveErrorCb function);
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t read(uint8_t* buffer, size_t size);
+    void flush();
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+
+    // Simulation: the port created for the uart, nullptr if there is none
+    static HardwareSerial* getPort(int uartNum);
+
+    // Simulation: data arrived on the rx pin, returns the number of bytes which fit
+    // into the rx buffer. The rest is lost and reported as UART_BUFFER_FULL_ERROR.
+    size_t receive(const uint8_t* data, size_t len);
+    void receiveError(hardwareSerial_error_t error);
+
+    const std::string& getTxData();
+    void clearTxData();
+
+    // Simulation: uart 0 discards the data instead of printing it, e.g. for expected errors
+    void setConsoleOutput(bool enable);
+
+private:
+    int _uartNum;
+    size_t _rxBufferSize = 256;
+    std::vector<uint8_t> _rxBuffer; // ring buffer, allocated by begin() only
+    size_t _rxHead = 0;
+    size_t _rxCount = 0;
+    std::string _txData;
+    bool _consoleOutput = true;
+    OnReceiveCb _onReceive;
+    OnReceiveErrorCb _onReceiveError;
+};
+
+extern HardwareSerial Serial;
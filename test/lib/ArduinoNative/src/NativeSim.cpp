@@ -0,0 +1,415 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2022 Thomas Basler and others
+ */
+#include "NativeSim.h"
+#include "Arduino.h"
+#include "FunctionalInterrupt.h"
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// rounds of runTasks() after which a task is considered to never wait
+#define NATIVE_SIM_MAX_ROUNDS 10000
+
+struct NativeTask {
+    TaskFunction_t function;
+    void* parameter;
+    std::string name;
+
+    bool started = false;
+    bool waiting = false; // blocked in a notification wait or a delay
+    bool timed = false; // the wait ends at wakeTime even without a notification
+    uint64_t wakeTime = 0; // us
+
+    bool notified = false;
+    uint32_t value = 0;
+};
+
+struct NativeSemaphore {
+    bool recursive;
+    bool available;
+    NativeTask* owner; // nullptr is the main thread
+    uint32_t count;
+};
+
+namespace {
+
+// Only the thread which is "running" executes, all others wait on the condition
+// variable. The handover through the mutex orders all other state between them.
+struct Scheduler {
+    std::mutex mutex;
+    std::condition_variable cv;
+    NativeTask* running = nullptr; // nullptr is the main thread
+    std::vector<NativeTask*> tasks;
+
+    uint64_t clock = 0; // us
+    bool localTimeValid = true;
+    std::map<uint8_t, std::function<void(void)>> interrupts;
+};
+
+// Tasks never end, so the scheduler has to outlive the static destructors
+Scheduler& sched()
+{
+    static Scheduler* s = new Scheduler();
+    return *s;
+}
+
+thread_local NativeTask* currentTask = nullptr;
+
+[[noreturn]] void fail(const char* message)
+{
+    fprintf(stderr, "NativeSim: %s\n", message);
+    fflush(stderr);
+    abort();
+}
+
+NativeTask* requireTask(const char* function)
+{
+    if (currentTask == nullptr) {
+        fprintf(stderr, "NativeSim: %s called outside of a task\n", function);
+        abort();
+    }
+    return currentTask;
+}
+
+void taskEntry(NativeTask* task)
+{
+    currentTask = task;
+    {
+        std::unique_lock<std::mutex> lock(sched().mutex);
+        sched().cv.wait(lock, [task] { return sched().running == task; });
+    }
+
+    task->function(task->parameter);
+    fail("task function returned");
+}
+
+// Hands over from the calling task to the main thread until runTasks() selects it again
+void blockTask(NativeTask* task, TickType_t ticks)
+{
+    Scheduler& s = sched();
+    std::unique_lock<std::mutex> lock(s.mutex);
+    task->waiting = true;
+    task->timed = ticks != portMAX_DELAY;
+    task->wakeTime = s.clock + static_cast<uint64_t>(ticks) * 1000;
+    s.running = nullptr;
+    s.cv.notify_all();
+    s.cv.wait(lock, [task, &s] { return s.running == task; });
+    task->waiting = false;
+}
+
+bool isRunnable(NativeTask* task)
+{
+    return !task->started
+        || (task->waiting && (task->notified || (task->timed && sched().clock >= task->wakeTime)));
+}
+
+void notify(NativeTask* task, uint32_t value, eNotifyAction action)
+{
+    switch (action) {
+    case eSetBits:
+        task->value |= value;
+        break;
+    case eIncrement:
+        task->value++;
+        break;
+    case eSetValueWithOverwrite:
+        task->value = value;
+        break;
+    case eSetValueWithoutOverwrite:
+        if (!task->notified) {
+            task->value = value;
+        }
+        break;
+    default:
+        break;
+    }
+    task->notified = true;
+}
+
+}
+
+namespace NativeSim {
+
+uint32_t now()
+{
+    return millis();
+}
+
+void advance(uint32_t ms)
+{
+    sched().clock += static_cast<uint64_t>(ms) * 1000;
+}
+
+void runTasks()
+{
+    if (currentTask != nullptr) {
+        fail("runTasks() called by a task");
+    }
+
+    Scheduler& s = sched();
+    for (uint32_t round = 0;; round++) {
+        NativeTask* next = nullptr;
+        for (auto task : s.tasks) {
+            if (isRunnable(task)) {
+                next = task;
+                break;
+            }
+        }
+        if (next == nullptr) {
+            break;
+        }
+        if (round >= NATIVE_SIM_MAX_ROUNDS) {
+            fprintf(stderr, "NativeSim: task %s does not wait\n", next->name.c_str());
+            abort();
+        }
+
+        std::unique_lock<std::mutex> lock(s.mutex);
+        s.running = next;
+        if (!next->started) {
+            next->started = true;
+            std::thread(taskEntry, next).detach();
+        }
+        s.cv.notify_all();
+        s.cv.wait(lock, [&s] { return s.running == nullptr; });
+    }
+}
+
+void triggerInterrupt(uint8_t pin)
+{
+    auto it = sched().interrupts.find(pin);
+    if (it != sched().interrupts.end()) {
+        it->second();
+    }
+}
+
+void setLocalTimeValid(bool valid)
+{
+    sched().localTimeValid = valid;
+}
+
+}
+
+unsigned long millis()
+{
+    return sched().clock / 1000;
+}
+
+unsigned long micros()
+{
+    return sched().clock;
+}
+
+int64_t esp_timer_get_time()
+{
+    return sched().clock;
+}
+
+void delay(uint32_t ms)
+{
+    if (currentTask != nullptr) {
+        vTaskDelay(pdMS_TO_TICKS(ms));
+    } else {
+        NativeSim::advance(ms);
+    }
+}
+
+void yield()
+{
+}
+
+bool getLocalTime(struct tm* info, uint32_t ms)
+{
+    if (!sched().localTimeValid) {
+        return false;
+    }
+
+    time_t now = time(nullptr);
+    localtime_r(&now, info);
+    return true;
+}
+
+void attachInterrupt(uint8_t pin, std::function<void(void)> handler, int mode)
+{
+    sched().interrupts[pin] = handler;
+}
+
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode)
+{
+    sched().interrupts[pin] = handler;
+}
+
+void detachInterrupt(uint8_t pin)
+{
+    sched().interrupts.erase(pin);
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name, uint32_t stackDepth,
+    void* parameter, UBaseType_t priority, TaskHandle_t* createdTask, BaseType_t coreId)
+{
+    NativeTask* task = new NativeTask();
+    task->function = function;
+    task->parameter = parameter;
+    task->name = name;
+    sched().tasks.push_back(task);
+
+    if (createdTask != nullptr) {
+        *createdTask = task;
+    }
+    return pdPASS;
+}
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action)
+{
+    notify(task, value, action);
+    return pdPASS;
+}
+
+BaseType_t xTaskNotifyFromISR(TaskHandle_t task, uint32_t value, eNotifyAction action, BaseType_t* higherPriorityTaskWoken)
+{
+    notify(task, value, action);
+    if (higherPriorityTaskWoken != nullptr) {
+        *higherPriorityTaskWoken = pdTRUE;
+    }
+    return pdPASS;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    notify(task, 0, eIncrement);
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higherPriorityTaskWoken)
+{
+    notify(task, 0, eIncrement);
+    if (higherPriorityTaskWoken != nullptr) {
+        *higherPriorityTaskWoken = pdTRUE;
+    }
+}
+
+BaseType_t xTaskNotifyWait(uint32_t bitsToClearOnEntry, uint32_t bitsToClearOnExit, uint32_t* notificationValue, TickType_t ticksToWait)
+{
+    NativeTask* task = requireTask("xTaskNotifyWait()");
+
+    if (!task->notified) {
+        task->value &= ~bitsToClearOnEntry;
+        if (ticksToWait > 0) {
+            blockTask(task, ticksToWait);
+        }
+    }
+
+    if (notificationValue != nullptr) {
+        *notificationValue = task->value;
+    }
+
+    if (!task->notified) {
+        return pdFALSE;
+    }
+
+    task->value &= ~bitsToClearOnExit;
+    task->notified = false;
+    return pdTRUE;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearCountOnExit, TickType_t ticksToWait)
+{
+    NativeTask* task = requireTask("ulTaskNotifyTake()");
+
+    if (task->value == 0 && ticksToWait > 0) {
+        blockTask(task, ticksToWait);
+    }
+
+    uint32_t value = task->value;
+    if (value > 0) {
+        task->value = clearCountOnExit ? 0 : value - 1;
+    }
+    task->notified = false;
+    return value;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    blockTask(requireTask("vTaskDelay()"), ticks);
+}
+
+TickType_t xTaskGetTickCount()
+{
+    return millis();
+}
+
+static SemaphoreHandle_t createMutex(bool recursive)
+{
+    NativeSemaphore* semaphore = new NativeSemaphore();
+    semaphore->recursive = recursive;
+    semaphore->available = true;
+    semaphore->owner = nullptr;
+    semaphore->count = 0;
+    return semaphore;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex()
+{
+    return createMutex(false);
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex()
+{
+    return createMutex(true);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticksToWait)
+{
+    if (!semaphore->available) {
+        // The holder can not run before the caller waits, so it would never be given
+        if (ticksToWait == portMAX_DELAY) {
+            fail("semaphore taken twice, this would block forever");
+        }
+        return pdFALSE;
+    }
+
+    semaphore->available = false;
+    semaphore->owner = currentTask;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+    // Like FreeRTOS, giving a mutex which is not taken fails without harm
+    if (semaphore->available) {
+        return pdFALSE;
+    }
+
+    semaphore->available = true;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t semaphore, TickType_t ticksToWait)
+{
+    if (!semaphore->available && semaphore->owner == currentTask) {
+        semaphore->count++;
+        return pdTRUE;
+    }
+
+    if (xSemaphoreTake(semaphore, ticksToWait) != pdTRUE) {
+        return pdFALSE;
+    }
+    semaphore->count = 1;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t semaphore)
+{
+    if (semaphore->available || semaphore->owner != currentTask) {
+        return pdFALSE;
+    }
+
+    if (--semaphore->count == 0) {
+        semaphore->available = true;
+    }
+    return pdTRUE;
+}
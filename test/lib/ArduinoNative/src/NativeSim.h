@@ -0,0 +1,24 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <cstdint>
+
+// Control of the simulated environment. The clock only advances if the test calls
+// advance() and the tasks only run from runTasks(), so every run is reproducible.
+namespace NativeSim {
+
+uint32_t now(); // ms since the start, same as millis()
+void advance(uint32_t ms);
+
+// Runs the tasks created with xTaskCreatePinnedToCore() until all of them wait for a
+// notification or for a timeout which is not due yet. The tasks are real threads but
+// only one of them or the main thread runs at a time.
+void runTasks();
+
+// Calls the handler attached to the pin like an edge on the pin would do
+void triggerInterrupt(uint8_t pin);
+
+// getLocalTime() fails while the time is not valid, like before NTP synchronized
+void setLocalTimeValid(bool valid);
+
+}
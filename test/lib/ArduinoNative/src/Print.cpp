@@ -0,0 +1,126 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2022 Thomas Basler and others
+ */
+#include "Print.h"
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+size_t Print::write(const uint8_t* buffer, size_t size)
+{
+    size_t n = 0;
+    while (size--) {
+        n += write(*buffer++);
+    }
+    return n;
+}
+
+size_t Print::write(const char* str)
+{
+    if (str == nullptr) {
+        return 0;
+    }
+    return write(reinterpret_cast<const uint8_t*>(str), strlen(str));
+}
+
+size_t Print::printf(const char* format, ...)
+{
+    char buffer[128];
+    va_list args;
+
+    va_start(args, format);
+    int len = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (len < 0) {
+        return 0;
+    }
+    if (static_cast<size_t>(len) < sizeof(buffer)) {
+        return write(reinterpret_cast<const uint8_t*>(buffer), len);
+    }
+
+    std::vector<char> large(len + 1);
+    va_start(args, format);
+    vsnprintf(large.data(), large.size(), format, args);
+    va_end(args);
+    return write(reinterpret_cast<const uint8_t*>(large.data()), len);
+}
+
+size_t Print::print(const String& str)
+{
+    return write(str.c_str());
+}
+
+size_t Print::print(const char* str)
+{
+    return write(str);
+}
+
+size_t Print::print(char c)
+{
+    return write(static_cast<uint8_t>(c));
+}
+
+size_t Print::print(unsigned char value, int base)
+{
+    return print(static_cast<unsigned long long>(value), base);
+}
+
+size_t Print::print(int value, int base)
+{
+    return print(static_cast<long long>(value), base);
+}
+
+size_t Print::print(unsigned int value, int base)
+{
+    return print(static_cast<unsigned long long>(value), base);
+}
+
+size_t Print::print(long value, int base)
+{
+    return print(static_cast<long long>(value), base);
+}
+
+size_t Print::print(unsigned long value, int base)
+{
+    return print(static_cast<unsigned long long>(value), base);
+}
+
+size_t Print::print(long long value, int base)
+{
+    if (base == DEC && value < 0) {
+        return print('-') + print(-static_cast<unsigned long long>(value), base);
+    }
+    return print(static_cast<unsigned long long>(value), base);
+}
+
+size_t Print::print(unsigned long long value, int base)
+{
+    char buffer[8 * sizeof(value) + 1];
+    char* p = &buffer[sizeof(buffer) - 1];
+    *p = '\0';
+
+    if (base < 2) {
+        base = DEC;
+    }
+    do {
+        uint8_t digit = value % base;
+        *--p = digit < 10 ? '0' + digit : 'A' + digit - 10;
+        value /= base;
+    } while (value > 0);
+
+    return write(p);
+}
+
+size_t Print::print(double value, int digits)
+{
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.*f", digits, value);
+    return write(buffer);
+}
+
+size_t Print::println()
+{
+    return write("\r\n");
+}
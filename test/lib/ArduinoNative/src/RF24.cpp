@@ -0,0 +1,181 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2022 Thomas Basler and others
+ */
+#include "RF24.h"
+#include <cstring>
+
+RF24Air* RF24::_air = nullptr;
+
+RF24::RF24(uint16_t cePin, uint16_t csnPin, uint32_t spiSpeed)
+{
+}
+
+bool RF24::begin()
+{
+    return true;
+}
+
+bool RF24::begin(SPIClass* spiBus)
+{
+    return true;
+}
+
+bool RF24::isChipConnected()
+{
+    return true;
+}
+
+bool RF24::isPVariant()
+{
+    return true;
+}
+
+bool RF24::setDataRate(rf24_datarate_e speed)
+{
+    return true;
+}
+
+void RF24::enableDynamicPayloads()
+{
+}
+
+void RF24::setCRCLength(rf24_crclength_e length)
+{
+}
+
+void RF24::setAddressWidth(uint8_t width)
+{
+}
+
+void RF24::setRetries(uint8_t delay, uint8_t count)
+{
+}
+
+void RF24::maskIRQ(bool txOk, bool txFail, bool rxReady)
+{
+}
+
+void RF24::setPALevel(uint8_t level, bool lnaEnable)
+{
+    _paLevel = level;
+}
+
+uint8_t RF24::getPALevel()
+{
+    return _paLevel;
+}
+
+void RF24::setChannel(uint8_t channel)
+{
+    _channel = channel;
+}
+
+uint8_t RF24::getChannel()
+{
+    return _channel;
+}
+
+void RF24::openReadingPipe(uint8_t number, uint64_t address)
+{
+    if (number < NRF24_PIPE_COUNT) {
+        _readingPipes[number] = address;
+        _readingPipeOpen[number] = true;
+    }
+}
+
+void RF24::openWritingPipe(uint64_t address)
+{
+    _writingPipe = address;
+}
+
+void RF24::startListening()
+{
+    _listening = true;
+}
+
+void RF24::stopListening()
+{
+    _listening = false;
+}
+
+bool RF24::available()
+{
+    return _fifoCount > 0;
+}
+
+uint8_t RF24::getDynamicPayloadSize()
+{
+    return _fifoCount > 0 ? _fifo[_fifoHead].len : 0;
+}
+
+void RF24::read(void* buf, uint8_t len)
+{
+    if (_fifoCount == 0) {
+        return;
+    }
+
+    const Packet& p = _fifo[_fifoHead];
+    memcpy(buf, p.data, len < p.len ? len : p.len);
+    _fifoHead = (_fifoHead + 1) % NRF24_FIFO_SIZE;
+    _fifoCount--;
+}
+
+bool RF24::write(const void* buf, uint8_t len)
+{
+    if (_air == nullptr || _listening) {
+        return false;
+    }
+    if (len > NRF24_MAX_PAYLOAD_SIZE) {
+        len = NRF24_MAX_PAYLOAD_SIZE;
+    }
+    return _air->transmit(this, _writingPipe, _channel, static_cast<const uint8_t*>(buf), len);
+}
+
+uint8_t RF24::flush_rx()
+{
+    _fifoHead = 0;
+    _fifoCount = 0;
+    return 0;
+}
+
+void RF24::setAir(RF24Air* air)
+{
+    _air = air;
+}
+
+bool RF24::receive(uint64_t address, uint8_t channel, const uint8_t* data, uint8_t len)
+{
+    if (!_listening || channel != _channel || len > NRF24_MAX_PAYLOAD_SIZE) {
+        return false;
+    }
+
+    bool match = false;
+    for (uint8_t i = 0; i < NRF24_PIPE_COUNT; i++) {
+        match |= _readingPipeOpen[i] && _readingPipes[i] == address;
+    }
+    if (!match) {
+        return false;
+    }
+
+    if (_fifoCount == NRF24_FIFO_SIZE) {
+        _rxDroppedCount++;
+        return false;
+    }
+
+    Packet& p = _fifo[(_fifoHead + _fifoCount) % NRF24_FIFO_SIZE];
+    memcpy(p.data, data, len);
+    p.len = len;
+    _fifoCount++;
+    return true;
+}
+
+bool RF24::isListening()
+{
+    return _listening;
+}
+
+uint32_t RF24::getRxDroppedCount()
+{
+    return _rxDroppedCount;
+}
@@ -0,0 +1,102 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "SPI.h"
+#include "nRF24L01.h"
+#include <cstdint>
+
+typedef enum {
+    RF24_PA_MIN = 0,
+    RF24_PA_LOW,
+    RF24_PA_HIGH,
+    RF24_PA_MAX,
+    RF24_PA_ERROR
+} rf24_pa_dbm_e;
+
+typedef enum {
+    RF24_1MBPS = 0,
+    RF24_2MBPS,
+    RF24_250KBPS
+} rf24_datarate_e;
+
+typedef enum {
+    RF24_CRC_DISABLED = 0,
+    RF24_CRC_8,
+    RF24_CRC_16
+} rf24_crclength_e;
+
+class RF24;
+
+// Everything a simulated module sends goes to the air, which delivers it to the
+// simulated devices. They answer by calling RF24::receive() on the module.
+class RF24Air {
+public:
+    virtual ~RF24Air() { }
+
+    // Returns true if a receiver acknowledged the packet
+    virtual bool transmit(RF24* radio, uint64_t address, uint8_t channel, const uint8_t* data, uint8_t len) = 0;
+};
+
+// nRF24L01+ without hardware. Keeps the state the library would write into the
+// registers and a receive FIFO of the size of the real one.
+class RF24 {
+public:
+    RF24(uint16_t cePin, uint16_t csnPin, uint32_t spiSpeed = 10000000);
+
+    bool begin();
+    bool begin(SPIClass* spiBus);
+    bool isChipConnected();
+    bool isPVariant();
+
+    bool setDataRate(rf24_datarate_e speed);
+    void enableDynamicPayloads();
+    void setCRCLength(rf24_crclength_e length);
+    void setAddressWidth(uint8_t width);
+    void setRetries(uint8_t delay, uint8_t count);
+    void maskIRQ(bool txOk, bool txFail, bool rxReady);
+    void setPALevel(uint8_t level, bool lnaEnable = true);
+    uint8_t getPALevel();
+    void setChannel(uint8_t channel);
+    uint8_t getChannel();
+
+    void openReadingPipe(uint8_t number, uint64_t address);
+    void openWritingPipe(uint64_t address);
+    void startListening();
+    void stopListening();
+
+    bool available();
+    uint8_t getDynamicPayloadSize();
+    void read(void* buf, uint8_t len);
+    bool write(const void* buf, uint8_t len);
+    uint8_t flush_rx();
+
+    // Simulation: medium for all modules, nothing is acknowledged without one
+    static void setAir(RF24Air* air);
+
+    // Simulation: a packet arrived on the channel. It is only stored if the module
+    // listens on the channel and the address of an open reading pipe and the
+    // FIFO is not full. Returns true if it was stored.
+    bool receive(uint64_t address, uint8_t channel, const uint8_t* data, uint8_t len);
+    bool isListening();
+    uint32_t getRxDroppedCount(); // packets lost as the FIFO was full
+
+private:
+    struct Packet {
+        uint8_t data[NRF24_MAX_PAYLOAD_SIZE];
+        uint8_t len;
+    };
+
+    static RF24Air* _air;
+
+    uint8_t _channel = 76;
+    uint8_t _paLevel = RF24_PA_MAX;
+    bool _listening = false;
+    uint64_t _readingPipes[NRF24_PIPE_COUNT] = {};
+    bool _readingPipeOpen[NRF24_PIPE_COUNT] = {};
+    uint64_t _writingPipe = 0;
+
+    Packet _fifo[NRF24_FIFO_SIZE];
+    uint8_t _fifoHead = 0;
+    uint8_t _fifoCount = 0;
+    uint32_t _rxDroppedCount = 0;
+};
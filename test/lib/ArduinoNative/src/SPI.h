@@ -0,0 +1,30 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include "Arduino.h"
+
+#define FSPI 0
+#define HSPI 1
+#define VSPI 2
+
+// Bus without hardware, the modules on it are simulated on a higher level
+class SPIClass {
+public:
+    explicit SPIClass(uint8_t spiBus = HSPI)
+        : _spiBus(spiBus)
+    {
+    }
+
+    void begin(int8_t sck = -1, int8_t miso = -1, int8_t mosi = -1, int8_t ss = -1)
+    {
+        _ss = ss;
+    }
+
+    void end() { }
+
+    int8_t pinSS() { return _ss; }
+
+private:
+    uint8_t _spiBus;
+    int8_t _ss = -1;
+};
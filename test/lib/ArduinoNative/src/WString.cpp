@@ -0,0 +1,71 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2022 Thomas Basler and others
+ */
+#include "WString.h"
+#include <cstdio>
+
+static std::string formatUnsigned(unsigned long long value, unsigned char base)
+{
+    if (base < 2) {
+        base = 10;
+    }
+
+    std::string str;
+    do {
+        uint8_t digit = value % base;
+        str.insert(str.begin(), digit < 10 ? '0' + digit : 'a' + digit - 10);
+        value /= base;
+    } while (value > 0);
+    return str;
+}
+
+static std::string formatSigned(long long value, unsigned char base)
+{
+    if (base == 10 && value < 0) {
+        return "-" + formatUnsigned(-static_cast<unsigned long long>(value), base);
+    }
+    return formatUnsigned(static_cast<unsigned long long>(value), base);
+}
+
+static std::string formatFloat(double value, unsigned char decimalPlaces)
+{
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.*f", decimalPlaces, value);
+    return buffer;
+}
+
+String::String(unsigned char value, unsigned char base)
+    : _str(formatUnsigned(value, base))
+{
+}
+
+String::String(int value, unsigned char base)
+    : _str(base == 10 ? formatSigned(value, base) : formatUnsigned(static_cast<unsigned int>(value), base))
+{
+}
+
+String::String(unsigned int value, unsigned char base)
+    : _str(formatUnsigned(value, base))
+{
+}
+
+String::String(long value, unsigned char base)
+    : _str(base == 10 ? formatSigned(value, base) : formatUnsigned(static_cast<unsigned long>(value), base))
+{
+}
+
+String::String(unsigned long value, unsigned char base)
+    : _str(formatUnsigned(value, base))
+{
+}
+
+String::String(float value, unsigned char decimalPlaces)
+    : _str(formatFloat(value, decimalPlaces))
+{
+}
+
+String::String(double value, unsigned char decimalPlaces)
+    : _str(formatFloat(value, decimalPlaces))
+{
+}
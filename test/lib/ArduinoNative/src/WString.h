@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+// Strings are not placed in flash, F() is a plain const char*
+class __FlashStringHelper;
+#define F(string_literal) (string_literal)
+#define PSTR(string_literal) (string_literal)
+
+// Subset of the Arduino String used by the libraries
+class String {
+public:
+    String(const char* str = "")
+        : _str(str != nullptr ? str : "")
+    {
+    }
+    String(const std::string& str)
+        : _str(str)
+    {
+    }
+    explicit String(char c)
+        : _str(1, c)
+    {
+    }
+    explicit String(unsigned char value, unsigned char base = 10);
+    explicit String(int value, unsigned char base = 10);
+    explicit String(unsigned int value, unsigned char base = 10);
+    explicit String(long value, unsigned char base = 10);
+    explicit String(unsigned long value, unsigned char base = 10);
+    explicit String(float value, unsigned char decimalPlaces = 2);
+    explicit String(double value, unsigned char decimalPlaces = 2);
+
+    const char* c_str() const { return _str.c_str(); }
+    unsigned int length() const { return _str.length(); }
+    char operator[](unsigned int index) const { return index < _str.length() ? _str[index] : '\0'; }
+
+    bool concat(const String& str)
+    {
+        _str += str._str;
+        return true;
+    }
+    String& operator+=(const String& str)
+    {
+        _str += str._str;
+        return *this;
+    }
+    String& operator+=(const char* str)
+    {
+        _str += str;
+        return *this;
+    }
+    String& operator+=(char c)
+    {
+        _str += c;
+        return *this;
+    }
+
+    bool equals(const String& str) const { return _str == str._str; }
+    bool operator==(const String& str) const { return _str == str._str; }
+    bool operator==(const char* str) const { return _str == str; }
+    bool operator!=(const String& str) const { return _str != str._str; }
+    bool operator<(const String& str) const { return _str < str._str; }
+
+    long toInt() const { return atol(_str.c_str()); }
+    float toFloat() const { return atof(_str.c_str()); }
+
+    // always valid, there is no allocation failure on the host
+    explicit operator bool() const { return true; }
+
+    friend String operator+(const String& lhs, const String& rhs) { return String(lhs._str + rhs._str); }
+    friend String operator+(const String& lhs, const char* rhs) { return String(lhs._str + rhs); }
+    friend String operator+(const char* lhs, const String& rhs) { return String(lhs + rhs._str); }
+
+private:
+    std::string _str;
+};
@@ -0,0 +1,7 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+// The simulated module has no registers, only the sizes used by the libraries are defined
+#define NRF24_PIPE_COUNT 6
+#define NRF24_FIFO_SIZE 3
+#define NRF24_MAX_PAYLOAD_SIZE 32
@@ -0,0 +1,200 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2022 Thomas Basler and others
+ */
+#include <chrono>
+#include <crc.h>
+#include <cstdio>
+#include <random>
+#include <unity.h>
+
+#define CRC_RANDOM_RUNS 100000
+#define CRC_BENCHMARK_RUNS 200000
+#define CRC_NRF24_MAX_BITS 512 // twice the longest packet of the radio
+
+// The bitwise implementations the lookup tables replaced, the reference for the tests
+static uint8_t crc8Bitwise(const uint8_t buf[], uint8_t len)
+{
+    uint8_t crc = CRC8_INIT;
+    for (uint8_t i = 0; i < len; i++) {
+        crc ^= buf[i];
+        for (uint8_t b = 0; b < 8; b++) {
+            crc = (crc << 1) ^ ((crc & 0x80) ? CRC8_POLY : 0x00);
+        }
+    }
+    return crc;
+}
+
+static uint16_t crc16Bitwise(const uint8_t buf[], uint8_t len, uint16_t start)
+{
+    uint16_t crc = start;
+    uint8_t shift = 0;
+
+    for (uint8_t i = 0; i < len; i++) {
+        crc = crc ^ buf[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            shift = (crc & 0x0001);
+            crc = crc >> 1;
+            if (shift != 0)
+                crc = crc ^ 0xA001;
+        }
+    }
+    return crc;
+}
+
+static uint16_t crc16nrf24Bitwise(const uint8_t buf[], uint16_t lenBits, uint16_t startBit, uint16_t crcIn)
+{
+    uint16_t crc = crcIn;
+    uint8_t idx, val = buf[(startBit >> 3)];
+
+    for (uint16_t bit = startBit; bit < lenBits; bit++) {
+        idx = bit & 0x07;
+        if (0 == idx)
+            val = buf[(bit >> 3)];
+        crc ^= 0x8000 & (val << (8 + idx));
+        crc = (crc & 0x8000) ? ((crc << 1) ^ CRC16_NRF24_POLYNOM) : (crc << 1);
+    }
+
+    return crc;
+}
+
+// Same seed in every run, a failure can be reproduced
+static std::mt19937 rng(0x4f44);
+static uint8_t buffer[256];
+
+static void randomize(uint8_t* buf, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        buf[i] = rng();
+    }
+}
+
+static void test_crc8_check_value()
+{
+    const uint8_t check[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+    TEST_ASSERT_EQUAL_HEX8(0x31, crc8(check, sizeof(check)));
+    TEST_ASSERT_EQUAL_HEX8(CRC8_INIT, crc8(check, 0));
+}
+
+static void test_crc16_check_value()
+{
+    const uint8_t check[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+    TEST_ASSERT_EQUAL_HEX16(0x4B37, crc16(check, sizeof(check)));
+    TEST_ASSERT_EQUAL_HEX16(0x1234, crc16(check, 0, 0x1234));
+}
+
+static void test_crc16nrf24_check_value()
+{
+    const uint8_t check[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+    TEST_ASSERT_EQUAL_HEX16(0x29B1, crc16nrf24(check, sizeof(check) * 8));
+}
+
+static void test_crc8_random()
+{
+    for (uint32_t run = 0; run < CRC_RANDOM_RUNS; run++) {
+        uint8_t len = rng();
+        randomize(buffer, len);
+        if (crc8(buffer, len) != crc8Bitwise(buffer, len)) {
+            char message[64];
+            snprintf(message, sizeof(message), "run %u, len %u", run, len);
+            TEST_FAIL_MESSAGE(message);
+        }
+    }
+}
+
+static void test_crc16_random()
+{
+    for (uint32_t run = 0; run < CRC_RANDOM_RUNS; run++) {
+        uint8_t len = rng();
+        uint16_t start = rng();
+        randomize(buffer, len);
+        if (crc16(buffer, len, start) != crc16Bitwise(buffer, len, start)) {
+            char message[64];
+            snprintf(message, sizeof(message), "run %u, len %u, start 0x%04X", run, len, start);
+            TEST_FAIL_MESSAGE(message);
+        }
+    }
+}
+
+// Unaligned start bits and lengths which are no multiple of 8, as the rx path uses them
+static void test_crc16nrf24_random()
+{
+    for (uint32_t run = 0; run < CRC_RANDOM_RUNS; run++) {
+        uint16_t lenBits = rng() % (CRC_NRF24_MAX_BITS + 1);
+        uint16_t startBit = rng() % (lenBits + 1);
+        uint16_t crcIn = rng();
+        randomize(buffer, CRC_NRF24_MAX_BITS / 8);
+        if (crc16nrf24(buffer, lenBits, startBit, crcIn) != crc16nrf24Bitwise(buffer, lenBits, startBit, crcIn)) {
+            char message[80];
+            snprintf(message, sizeof(message), "run %u, lenBits %u, startBit %u, crcIn 0x%04X", run, lenBits, startBit, crcIn);
+            TEST_FAIL_MESSAGE(message);
+        }
+    }
+}
+
+// A crc over the parts of a buffer continued with crcIn equals the crc over the whole buffer
+static void test_crc16nrf24_incremental()
+{
+    for (uint32_t run = 0; run < CRC_RANDOM_RUNS / 10; run++) {
+        uint16_t lenBits = rng() % (CRC_NRF24_MAX_BITS + 1);
+        uint16_t splitBit = rng() % (lenBits + 1);
+        randomize(buffer, CRC_NRF24_MAX_BITS / 8);
+        uint16_t crc = crc16nrf24(buffer, splitBit);
+        TEST_ASSERT_EQUAL_HEX16(crc16nrf24(buffer, lenBits), crc16nrf24(buffer, lenBits, splitBit, crc));
+    }
+}
+
+static volatile uint16_t sink;
+
+template <typename F>
+static double nsPerCall(F function)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t run = 0; run < CRC_BENCHMARK_RUNS; run++) {
+        sink = function();
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / CRC_BENCHMARK_RUNS;
+}
+
+// Timings of a fragment sized buffer, only reported as they depend on the host
+static void test_benchmark()
+{
+    randomize(buffer, sizeof(buffer));
+
+    printf("CRC ns per call, bitwise -> table\n");
+    printf("  crc8 27 bytes: %.1f -> %.1f\n",
+        nsPerCall([] { return crc8Bitwise(buffer, 27); }),
+        nsPerCall([] { return crc8(buffer, 27); }));
+    printf("  crc16 27 bytes: %.1f -> %.1f\n",
+        nsPerCall([] { return crc16Bitwise(buffer, 27, 0xffff); }),
+        nsPerCall([] { return crc16(buffer, 27); }));
+    printf("  crc16nrf24 256 bits: %.1f -> %.1f\n",
+        nsPerCall([] { return crc16nrf24Bitwise(buffer, 256, 0, 0xffff); }),
+        nsPerCall([] { return crc16nrf24(buffer, 256); }));
+    printf("  crc16nrf24 bits 9 to 260: %.1f -> %.1f\n",
+        nsPerCall([] { return crc16nrf24Bitwise(buffer, 260, 9, 0xffff); }),
+        nsPerCall([] { return crc16nrf24(buffer, 260, 9); }));
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_crc8_check_value);
+    RUN_TEST(test_crc16_check_value);
+    RUN_TEST(test_crc16nrf24_check_value);
+    RUN_TEST(test_crc8_random);
+    RUN_TEST(test_crc16_random);
+    RUN_TEST(test_crc16nrf24_random);
+    RUN_TEST(test_crc16nrf24_incremental);
+    RUN_TEST(test_benchmark);
+    return UNITY_END();
+}
@@ -0,0 +1,323 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2022 Thomas Basler and others
+ */
+#include "InverterSimulator.h"
+#include <Arduino.h>
+#include <NativeSim.h>
+#include <algorithm>
+
+#define SIM_FRAGMENT_DATA_SIZE 16
+
+static void putValue(std::vector<uint8_t>& data, size_t offset, float value, uint16_t divisor)
+{
+    uint16_t raw = static_cast<uint16_t>(value * divisor + 0.5f);
+    data[offset] = raw >> 8;
+    data[offset + 1] = raw & 0xff;
+}
+
+static void appendCrc16(std::vector<uint8_t>& data)
+{
+    uint16_t crc = InverterSimulator::crc16(data.data(), data.size());
+    data.push_back(crc >> 8);
+    data.push_back(crc & 0xff);
+}
+
+SimulatedInverter::SimulatedInverter(uint64_t serial, uint8_t inputs)
+    : _serial(serial)
+    , _inputs(inputs)
+{
+    switch (inputs) {
+    case 1:
+        values.hwPart = 0x10104000; // HM-400
+        break;
+    case 2:
+        values.hwPart = 0x10113000; // HM-800
+        break;
+    default:
+        values.hwPart = 0x10123000; // HM-1500
+        break;
+    }
+}
+
+uint64_t SimulatedInverter::serial() const
+{
+    return _serial;
+}
+
+uint64_t SimulatedInverter::radioAddress() const
+{
+    return 0x01
+        | ((_serial >> 24) & 0xff) << 8
+        | ((_serial >> 16) & 0xff) << 16
+        | ((_serial >> 8) & 0xff) << 24
+        | (_serial & 0xff) << 32;
+}
+
+std::vector<uint8_t> SimulatedInverter::handleRequest(const uint8_t* request, uint8_t len, uint8_t& mainCmd)
+{
+    std::vector<uint8_t> data;
+    requests++;
+
+    if (request[0] == 0x15 && len == 10 && (request[9] & 0x7f) != 0) {
+        // Retransmit request, the caller picks the fragment of the last response
+        retransmitRequests++;
+        mainCmd = lastMainCmd;
+        return lastResponse;
+    }
+
+    if (request[0] == 0x15 && len == 26) {
+        switch (request[10]) {
+        case 0x0b:
+            data = buildStats();
+            break;
+        case 0x11:
+            data = buildAlarmLog();
+            break;
+        case 0x01:
+            data = buildDevInfoAll();
+            break;
+        case 0x00:
+            data = buildDevInfoSimple();
+            break;
+        case 0x05:
+            data = buildSystemConfigPara();
+            break;
+        default:
+            return data;
+        }
+    } else if (request[0] == 0x51 && len >= 14) {
+        if (request[10] == 0x0b) {
+            lastLimit = ((request[12] << 8) | request[13]) / 10.0f;
+            lastLimitType = (request[14] << 8) | request[15];
+            if (lastLimitType == 0x0001 || lastLimitType == 0x0101) {
+                values.limitPercent = lastLimit;
+            }
+        } else if (request[10] <= 0x02) {
+            lastPowerCommand = request[10];
+        } else {
+            return data;
+        }
+        data.push_back(request[10]);
+        data.push_back(0x00);
+    } else {
+        return data;
+    }
+
+    appendCrc16(data);
+    mainCmd = request[0] | 0x80;
+    lastResponse = data;
+    lastMainCmd = mainCmd;
+    return data;
+}
+
+std::vector<uint8_t> SimulatedInverter::buildStats()
+{
+    size_t len;
+    size_t ac; // offset of the AC voltage, followed by frequency and power
+    size_t evt;
+    switch (_inputs) {
+    case 1:
+        len = 30;
+        ac = 14;
+        evt = 28;
+        break;
+    case 2:
+        len = 42;
+        ac = 26;
+        evt = 40;
+        break;
+    default:
+        len = 62;
+        ac = 46;
+        evt = 60;
+        break;
+    }
+
+    std::vector<uint8_t> data(len, 0);
+    putValue(data, 2, values.dcVoltage, 10);
+    if (_inputs == 2) {
+        putValue(data, 8, values.dcVoltage, 10);
+    } else if (_inputs == 4) {
+        putValue(data, 24, values.dcVoltage, 10);
+    }
+    putValue(data, ac, values.acVoltage, 10);
+    putValue(data, ac + 2, values.frequency, 100);
+    putValue(data, ac + 4, values.acPower, 10);
+    putValue(data, evt, values.alarmCount, 1);
+    return data;
+}
+
+std::vector<uint8_t> SimulatedInverter::buildAlarmLog()
+{
+    std::vector<uint8_t> data(2 + values.alarmCount * 12, 0);
+    for (uint16_t i = 0; i < values.alarmCount; i++) {
+        uint8_t* entry = &data[2 + i * 12];
+        entry[0] = 0x00;
+        entry[1] = 1 + i; // alarm code
+    }
+    return data;
+}
+
+std::vector<uint8_t> SimulatedInverter::buildDevInfoAll()
+{
+    std::vector<uint8_t> data(14, 0);
+    data[2] = 0x27; // firmware version 1.0.16
+    data[3] = 0x1c;
+    return data;
+}
+
+std::vector<uint8_t> SimulatedInverter::buildDevInfoSimple()
+{
+    std::vector<uint8_t> data(14, 0);
+    data[2] = values.hwPart >> 24;
+    data[3] = values.hwPart >> 16;
+    data[4] = values.hwPart >> 8;
+    data[5] = values.hwPart;
+    data[6] = 1; // hardware version 01.00
+    return data;
+}
+
+std::vector<uint8_t> SimulatedInverter::buildSystemConfigPara()
+{
+    std::vector<uint8_t> data(14, 0);
+    putValue(data, 2, values.limitPercent, 10);
+    return data;
+}
+
+InverterSimulator::InverterSimulator(uint8_t irqPin, uint32_t seed)
+    : _irqPin(irqPin)
+    , _random(seed)
+{
+}
+
+SimulatedInverter& InverterSimulator::addInverter(uint64_t serial, uint8_t inputs)
+{
+    _inverters.emplace_back(new SimulatedInverter(serial, inputs));
+    return *_inverters.back();
+}
+
+bool InverterSimulator::transmit(RF24* radio, uint64_t address, uint8_t channel, const uint8_t* data, uint8_t len)
+{
+    _radio = radio;
+
+    auto it = std::find_if(_inverters.begin(), _inverters.end(),
+        [address](const std::unique_ptr<SimulatedInverter>& inv) { return inv->radioAddress() == address; });
+    if (it == _inverters.end() || len < 11 || chance(config.loss)) {
+        return false;
+    }
+    if (crc8(data, len - 1) != data[len - 1]) {
+        return false;
+    }
+
+    uint8_t mainCmd = 0;
+    std::vector<uint8_t> response = (*it)->handleRequest(data, len - 1, mainCmd);
+    if (!response.empty()) {
+        bool retransmit = data[0] == 0x15 && len == 11;
+        sendResponse(data, response, mainCmd, retransmit ? data[9] & 0x7f : 0);
+    }
+
+    // Acknowledged by the module of the inverter, even if it has no answer
+    return true;
+}
+
+void InverterSimulator::sendResponse(const uint8_t* request, const std::vector<uint8_t>& data, uint8_t mainCmd, uint8_t onlyFragment)
+{
+    uint8_t count = (data.size() + SIM_FRAGMENT_DATA_SIZE - 1) / SIM_FRAGMENT_DATA_SIZE;
+    uint32_t time = millis() + config.latency;
+    if (config.jitter > 0) {
+        std::uniform_int_distribution<uint32_t> jitter(0, config.jitter);
+        time += jitter(_random);
+    }
+
+    for (uint8_t id = 1; id <= count; id++) {
+        if (onlyFragment != 0 && id != onlyFragment) {
+            continue;
+        }
+
+        size_t offset = (id - 1) * SIM_FRAGMENT_DATA_SIZE;
+        size_t dataLen = std::min<size_t>(SIM_FRAGMENT_DATA_SIZE, data.size() - offset);
+
+        Delivery d;
+        d.time = time;
+        d.address = 0x01
+            | static_cast<uint64_t>(request[5]) << 8
+            | static_cast<uint64_t>(request[6]) << 16
+            | static_cast<uint64_t>(request[7]) << 24
+            | static_cast<uint64_t>(request[8]) << 32;
+        d.data[0] = mainCmd;
+        memcpy(&d.data[1], &request[1], 8); // inverter and DTU id as in the request
+        d.data[9] = id | (id == count ? 0x80 : 0x00);
+        memcpy(&d.data[10], &data[offset], dataLen);
+        d.len = 11 + dataLen;
+        d.data[d.len - 1] = crc8(d.data, d.len - 1);
+        time += config.fragmentGap;
+
+        _sentFragmentCount++;
+        if (chance(config.loss)) {
+            continue;
+        }
+        if (chance(config.corruption)) {
+            std::uniform_int_distribution<uint32_t> bit(0, d.len * 8 - 1);
+            uint32_t b = bit(_random);
+            d.data[b / 8] ^= 1 << (b % 8);
+        }
+
+        // keep the deliveries ordered by time, retransmits may overtake a pending response
+        auto pos = std::upper_bound(_deliveries.begin(), _deliveries.end(), d.time,
+            [](uint32_t t, const Delivery& other) { return static_cast<int32_t>(t - other.time) < 0; });
+        _deliveries.insert(pos, d);
+    }
+}
+
+void InverterSimulator::loop()
+{
+    while (!_deliveries.empty() && static_cast<int32_t>(millis() - _deliveries.front().time) >= 0) {
+        const Delivery& d = _deliveries.front();
+        if (_radio != nullptr) {
+            uint8_t channel = config.channel != 0 ? config.channel : _radio->getChannel();
+            if (_radio->receive(d.address, channel, d.data, d.len)) {
+                NativeSim::triggerInterrupt(_irqPin);
+            }
+        }
+        _deliveries.pop_front();
+    }
+}
+
+uint32_t InverterSimulator::getSentFragmentCount()
+{
+    return _sentFragmentCount;
+}
+
+bool InverterSimulator::chance(float probability)
+{
+    if (probability <= 0) {
+        return false;
+    }
+    std::uniform_real_distribution<float> dist(0, 1);
+    return dist(_random) < probability;
+}
+
+uint8_t InverterSimulator::crc8(const uint8_t* buf, size_t len)
+{
+    uint8_t crc = 0x00;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= buf[i];
+        for (uint8_t b = 0; b < 8; b++) {
+            crc = (crc << 1) ^ ((crc & 0x80) ? 0x01 : 0x00);
+        }
+    }
+    return crc;
+}
+
+uint16_t InverterSimulator::crc16(const uint8_t* buf, size_t len)
+{
+    uint16_t crc = 0xffff;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= buf[i];
+        for (uint8_t b = 0; b < 8; b++) {
+            crc = (crc & 0x0001) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+        }
+    }
+    return crc;
+}
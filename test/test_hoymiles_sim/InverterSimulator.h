@@ -0,0 +1,103 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <RF24.h>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <random>
+#include <vector>
+
+// Link between the DTU and all simulated inverters. Loss and corruption apply to
+// every packet in both directions, the latency to every response.
+struct SimulatorConfig {
+    float loss = 0; // probability a packet is lost
+    float corruption = 0; // probability a received fragment has a flipped bit
+    uint32_t latency = 5; // ms from the request until the first fragment of the response
+    uint32_t jitter = 0; // ms, random extra latency of a response up to this value
+    uint32_t fragmentGap = 1; // ms between the fragments of a response, 0 sends them at once
+    uint8_t channel = 0; // channel of the responses, 0 reaches the DTU on any channel
+};
+
+// Values reported by a simulated inverter
+struct SimulatedValues {
+    float dcVoltage = 32.5; // V, all inputs
+    float acPower = 123.4; // W
+    float acVoltage = 230.1; // V
+    float frequency = 50.01; // Hz
+    uint16_t alarmCount = 0; // entries in the alarm log, also the counter in the stats
+    float limitPercent = 100;
+    uint32_t hwPart = 0; // depends on the model if not set
+};
+
+// HM-300 to HM-1500 answering the requests of the DTU like the real one
+class SimulatedInverter {
+public:
+    SimulatedInverter(uint64_t serial, uint8_t inputs);
+
+    uint64_t serial() const;
+    uint64_t radioAddress() const; // address of its reading pipe
+
+    SimulatedValues values;
+
+    // last commands received
+    uint32_t requests = 0; // all requests, including retransmit requests
+    uint32_t retransmitRequests = 0;
+    float lastLimit = -1; // W or %, -1 if never received
+    uint16_t lastLimitType = 0;
+    int8_t lastPowerCommand = -1; // 0 on, 1 off, 2 restart, -1 if never received
+
+    // Response data including its CRC16, empty if the request is unknown. mainCmd is
+    // the command byte of the response fragments.
+    std::vector<uint8_t> handleRequest(const uint8_t* request, uint8_t len, uint8_t& mainCmd);
+
+    std::vector<uint8_t> lastResponse;
+    uint8_t lastMainCmd = 0;
+
+private:
+    std::vector<uint8_t> buildStats();
+    std::vector<uint8_t> buildAlarmLog();
+    std::vector<uint8_t> buildDevInfoAll();
+    std::vector<uint8_t> buildDevInfoSimple();
+    std::vector<uint8_t> buildSystemConfigPara();
+
+    uint64_t _serial;
+    uint8_t _inputs;
+};
+
+class InverterSimulator : public RF24Air {
+public:
+    explicit InverterSimulator(uint8_t irqPin, uint32_t seed = 1);
+
+    SimulatorConfig config;
+
+    SimulatedInverter& addInverter(uint64_t serial, uint8_t inputs);
+
+    bool transmit(RF24* radio, uint64_t address, uint8_t channel, const uint8_t* data, uint8_t len) override;
+
+    // Delivers the fragments which are due, call it after every ms the clock advanced
+    void loop();
+
+    uint32_t getSentFragmentCount(); // fragments sent by the inverters, including lost ones
+
+    static uint8_t crc8(const uint8_t* buf, size_t len);
+    static uint16_t crc16(const uint8_t* buf, size_t len);
+
+private:
+    struct Delivery {
+        uint32_t time; // millis()
+        uint64_t address;
+        uint8_t data[NRF24_MAX_PAYLOAD_SIZE];
+        uint8_t len;
+    };
+
+    bool chance(float probability);
+    void sendResponse(const uint8_t* request, const std::vector<uint8_t>& data, uint8_t mainCmd, uint8_t onlyFragment);
+
+    uint8_t _irqPin;
+    RF24* _radio = nullptr;
+    std::mt19937 _random;
+    std::vector<std::unique_ptr<SimulatedInverter>> _inverters;
+    std::deque<Delivery> _deliveries;
+    uint32_t _sentFragmentCount = 0;
+};
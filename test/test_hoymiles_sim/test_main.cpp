@@ -0,0 +1,428 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2022 Thomas Basler and others
+ */
+#include "InverterSimulator.h"
+#include <Hoymiles.h>
+#include <NativeSim.h>
+#include <unity.h>
+
+#define PIN_CE 4
+#define PIN_IRQ 16
+
+#define DTU_SERIAL 0x199980000001ULL
+#define SERIAL_HM_1CH 0x112182345601ULL
+#define SERIAL_HM_2CH 0x114182345602ULL
+#define SERIAL_HM_4CH 0x116182345603ULL
+
+// The radio task of the library only exists once, every test uses a new air
+static InverterSimulator* sim;
+static std::shared_ptr<InverterAbstract> inv;
+
+// Logs of the library are only shown if a test fails
+class LogBuffer : public Print {
+public:
+    size_t write(uint8_t c) override
+    {
+        text += static_cast<char>(c);
+        return 1;
+    }
+    std::string text;
+};
+static LogBuffer logBuffer;
+
+static void step()
+{
+    NativeSim::advance(1);
+    sim->loop();
+    NativeSim::runTasks();
+}
+
+// Runs the radio until all queued commands are done, false if it takes longer than maxMs
+static bool runUntilIdle(uint32_t maxMs = 10000)
+{
+    HoymilesRadio* radio = Hoymiles.getRadio();
+    NativeSim::runTasks();
+    for (uint32_t ms = 0; ms < maxMs; ms++) {
+        if (radio->isIdle() && radio->isQueueEmpty()) {
+            return true;
+        }
+        step();
+    }
+    return false;
+}
+
+static SimulatedInverter& addInverter(uint64_t serial, uint8_t inputs)
+{
+    inv = Hoymiles.addInverter("sim", serial);
+    TEST_ASSERT_NOT_NULL(inv.get());
+    return sim->addInverter(serial, inputs);
+}
+
+void setUp()
+{
+    sim = new InverterSimulator(PIN_IRQ);
+    RF24::setAir(sim);
+    NativeSim::setLocalTimeValid(true);
+    logBuffer.text.clear();
+}
+
+void tearDown()
+{
+    if (Unity.CurrentTestFailed) {
+        printf("%s", logBuffer.text.c_str());
+    }
+
+    // Nothing may be left for the next test
+    runUntilIdle();
+    if (inv) {
+        Hoymiles.removeInverterBySerial(inv->serial());
+        inv.reset();
+    }
+    RF24::setAir(nullptr);
+    delete sim;
+    sim = nullptr;
+}
+
+static void checkStats(SimulatedInverter& siminv, uint8_t inputs)
+{
+    TEST_ASSERT_TRUE(inv->sendStatsRequest(Hoymiles.getRadio()));
+    TEST_ASSERT_TRUE(runUntilIdle());
+
+    StatisticsParser* stats = inv->Statistics();
+    TEST_ASSERT_TRUE(stats->getLastUpdate() > 0);
+    TEST_ASSERT_EQUAL(inputs, stats->getChannelCount());
+    TEST_ASSERT_FLOAT_WITHIN(0.05, 32.5, stats->getChannelFieldValue(CH1, FLD_UDC));
+    TEST_ASSERT_FLOAT_WITHIN(0.05, 123.4, stats->getChannelFieldValue(CH0, FLD_PAC));
+    TEST_ASSERT_FLOAT_WITHIN(0.05, 230.1, stats->getChannelFieldValue(CH0, FLD_UAC));
+    TEST_ASSERT_FLOAT_WITHIN(0.005, 50.01, stats->getChannelFieldValue(CH0, FLD_F));
+    TEST_ASSERT_EQUAL(3, stats->getChannelFieldValue(CH0, FLD_EVT_LOG));
+
+    const LinkStatistics& link = inv->RadioStats()->getLinkStatistics();
+    TEST_ASSERT_EQUAL(1, link.requests);
+    TEST_ASSERT_EQUAL(1, link.responses);
+    TEST_ASSERT_EQUAL(0, link.retransmits);
+    TEST_ASSERT_EQUAL(1, siminv.requests);
+}
+
+static void test_stats_hm1ch()
+{
+    SimulatedInverter& siminv = addInverter(SERIAL_HM_1CH, 1);
+    siminv.values.alarmCount = 3;
+    checkStats(siminv, 1);
+}
+
+static void test_stats_hm2ch()
+{
+    SimulatedInverter& siminv = addInverter(SERIAL_HM_2CH, 2);
+    siminv.values.alarmCount = 3;
+    checkStats(siminv, 2);
+    TEST_ASSERT_FLOAT_WITHIN(0.05, 32.5, inv->Statistics()->getChannelFieldValue(CH2, FLD_UDC));
+}
+
+static void test_stats_hm4ch()
+{
+    SimulatedInverter& siminv = addInverter(SERIAL_HM_4CH, 4);
+    siminv.values.alarmCount = 3;
+    checkStats(siminv, 4);
+    TEST_ASSERT_FLOAT_WITHIN(0.05, 32.5, inv->Statistics()->getChannelFieldValue(CH4, FLD_UDC));
+}
+
+// Lost fragments are requested again one by one
+static void test_stats_loss()
+{
+    SimulatedInverter& siminv = addInverter(SERIAL_HM_4CH, 4);
+    sim->config.loss = 0.2;
+
+    for (int i = 0; i < 20; i++) {
+        siminv.values.acPower = 100 + i;
+        TEST_ASSERT_TRUE(inv->sendStatsRequest(Hoymiles.getRadio()));
+        TEST_ASSERT_TRUE(runUntilIdle());
+        if (inv->Statistics()->getRxFailureCount() == 0) {
+            TEST_ASSERT_FLOAT_WITHIN(0.05, 100 + i, inv->Statistics()->getChannelFieldValue(CH0, FLD_PAC));
+        }
+    }
+
+    const LinkStatistics& link = inv->RadioStats()->getLinkStatistics();
+    TEST_ASSERT_EQUAL(20, link.requests);
+    TEST_ASSERT_EQUAL(20, link.responses + link.timeouts);
+    TEST_ASSERT_TRUE(link.retransmits > 0);
+    TEST_ASSERT_TRUE(link.responses >= 18);
+    TEST_ASSERT_TRUE(siminv.retransmitRequests > 0);
+}
+
+// Corrupted fragments are dropped by their CRC8 and requested again
+static void test_stats_corruption()
+{
+    SimulatedInverter& siminv = addInverter(SERIAL_HM_4CH, 4);
+    sim->config.corruption = 0.2;
+    uint32_t crcErrors = Hoymiles.getRadio()->getCrcErrorCount();
+
+    for (int i = 0; i < 20; i++) {
+        siminv.values.acPower = 100 + i;
+        TEST_ASSERT_TRUE(inv->sendStatsRequest(Hoymiles.getRadio()));
+        TEST_ASSERT_TRUE(runUntilIdle());
+        TEST_ASSERT_FLOAT_WITHIN(0.05, 100 + i, inv->Statistics()->getChannelFieldValue(CH0, FLD_PAC));
+    }
+
+    const LinkStatistics& link = inv->RadioStats()->getLinkStatistics();
+    TEST_ASSERT_EQUAL(20, link.responses);
+    TEST_ASSERT_TRUE(link.retransmits > 0);
+    TEST_ASSERT_TRUE(Hoymiles.getRadio()->getCrcErrorCount() > crcErrors);
+}
+
+// Without any answer the request is sent again and finally given up
+static void test_stats_timeout()
+{
+    addInverter(SERIAL_HM_1CH, 1);
+    sim->config.loss = 1;
+
+    TEST_ASSERT_TRUE(inv->sendStatsRequest(Hoymiles.getRadio()));
+    TEST_ASSERT_TRUE(runUntilIdle());
+
+    const LinkStatistics& link = inv->RadioStats()->getLinkStatistics();
+    TEST_ASSERT_EQUAL(0, link.responses);
+    TEST_ASSERT_EQUAL(MAX_RESEND_COUNT, link.resends);
+    TEST_ASSERT_EQUAL(1, link.timeouts);
+    TEST_ASSERT_EQUAL(1, inv->Statistics()->getRxFailureCount());
+    TEST_ASSERT_EQUAL(0, inv->Statistics()->getLastUpdate());
+}
+
+// The round trip includes the latency of the inverter
+static void test_stats_latency()
+{
+    addInverter(SERIAL_HM_2CH, 2);
+    sim->config.latency = 80;
+
+    uint32_t start = millis();
+    TEST_ASSERT_TRUE(inv->sendStatsRequest(Hoymiles.getRadio()));
+    TEST_ASSERT_TRUE(runUntilIdle());
+
+    const LinkStatistics& link = inv->RadioStats()->getLinkStatistics();
+    TEST_ASSERT_EQUAL(1, link.responses);
+    TEST_ASSERT_EQUAL(0, link.resends);
+    TEST_ASSERT_TRUE(link.latencySum >= 80);
+    TEST_ASSERT_EQUAL(1, link.latencyBuckets[1]); // 50 to 100 ms
+    TEST_ASSERT_TRUE(inv->Statistics()->getLastUpdate() - start >= 80);
+}
+
+// The short responses of one command type must not shorten the rx timeout of another
+static void test_rx_timeout_per_type()
+{
+    addInverter(SERIAL_HM_2CH, 2);
+
+    for (uint8_t i = 0; i < HOY_RX_TIMEOUT_MIN_SAMPLES; i++) {
+        TEST_ASSERT_TRUE(inv->sendDevInfoRequest(Hoymiles.getRadio()));
+        TEST_ASSERT_TRUE(runUntilIdle());
+    }
+
+    RadioStatistics* stats = inv->RadioStats();
+    TEST_ASSERT_TRUE(stats->getRxTimeout(CMD_TYPE_DEV_INFO, 1000) < 1000);
+    TEST_ASSERT_EQUAL(1000, stats->getRxTimeout(CMD_TYPE_ALARM_LOG, 1000));
+    TEST_ASSERT_EQUAL(1000, stats->getRxTimeout(CMD_TYPE_SYSTEM_CONFIG, 1000));
+}
+
+// A response later than the timeout is still taken while the request is resent
+static void test_stats_late_response()
+{
+    addInverter(SERIAL_HM_2CH, 2);
+    sim->config.latency = 300;
+
+    TEST_ASSERT_TRUE(inv->sendStatsRequest(Hoymiles.getRadio()));
+    TEST_ASSERT_TRUE(runUntilIdle());
+
+    const LinkStatistics& link = inv->RadioStats()->getLinkStatistics();
+    TEST_ASSERT_EQUAL(1, link.responses);
+    TEST_ASSERT_EQUAL(1, link.resends);
+    TEST_ASSERT_EQUAL(0, link.timeouts);
+}
+
+// All fragments at once overflow the three level FIFO of the module
+static void test_stats_fifo_overflow()
+{
+    SimulatedInverter& siminv = addInverter(SERIAL_HM_4CH, 4);
+    sim->config.fragmentGap = 0;
+
+    TEST_ASSERT_TRUE(inv->sendStatsRequest(Hoymiles.getRadio()));
+    TEST_ASSERT_TRUE(runUntilIdle());
+
+    const LinkStatistics& link = inv->RadioStats()->getLinkStatistics();
+    TEST_ASSERT_EQUAL(1, link.responses);
+    TEST_ASSERT_EQUAL(1, link.retransmits);
+    TEST_ASSERT_EQUAL(1, siminv.retransmitRequests);
+    TEST_ASSERT_EQUAL(1, inv->RadioStats()->getFragmentStatistics(4).recovered);
+}
+
+// Responses on a single channel are found by the rx channel hopping, which
+// then starts listening on it
+static void test_stats_fixed_channel()
+{
+    addInverter(SERIAL_HM_1CH, 1);
+    sim->config.channel = 40;
+    sim->config.latency = 1;
+    sim->config.jitter = 30;
+
+    for (int i = 0; i < 30; i++) {
+        TEST_ASSERT_TRUE(inv->sendStatsRequest(Hoymiles.getRadio()));
+        TEST_ASSERT_TRUE(runUntilIdle());
+    }
+
+    const LinkStatistics& link = inv->RadioStats()->getLinkStatistics();
+    TEST_ASSERT_EQUAL(30, link.responses + link.timeouts);
+    TEST_ASSERT_TRUE(link.responses > 0);
+    for (uint8_t chIdx = 0; chIdx < HOY_CHANNEL_COUNT; chIdx++) {
+        const ChannelStatistics& ch = inv->RadioStats()->getChannelStatistics(chIdx);
+        if (RadioStatistics::getChannel(chIdx) == 40) {
+            TEST_ASSERT_TRUE(ch.rxHits > 0);
+        } else {
+            TEST_ASSERT_EQUAL(0, ch.rxHits);
+        }
+    }
+
+    uint8_t order[HOY_CHANNEL_COUNT];
+    inv->RadioStats()->getRxHopOrder(order);
+    TEST_ASSERT_EQUAL(40, RadioStatistics::getChannel(order[0]));
+}
+
+static void test_dev_info()
+{
+    addInverter(SERIAL_HM_2CH, 2);
+
+    TEST_ASSERT_TRUE(inv->sendDevInfoRequest(Hoymiles.getRadio()));
+    TEST_ASSERT_TRUE(runUntilIdle());
+
+    TEST_ASSERT_TRUE(inv->DevInfo()->getLastUpdateAll() > 0);
+    TEST_ASSERT_TRUE(inv->DevInfo()->getLastUpdateSimple() > 0);
+    TEST_ASSERT_EQUAL_HEX32(0x10113000, inv->DevInfo()->getHwPartNumber());
+    TEST_ASSERT_EQUAL(800, inv->DevInfo()->getMaxPower());
+    TEST_ASSERT_EQUAL_STRING("HM-800", inv->DevInfo()->getHwModelName().c_str());
+}
+
+static void test_limit()
+{
+    SimulatedInverter& siminv = addInverter(SERIAL_HM_1CH, 1);
+
+    TEST_ASSERT_TRUE(inv->sendActivePowerControlRequest(Hoymiles.getRadio(), 50, PowerLimitControlType::RelativNonPersistent));
+    TEST_ASSERT_EQUAL(CMD_PENDING, inv->SystemConfigPara()->getLastLimitCommandSuccess());
+    TEST_ASSERT_TRUE(runUntilIdle());
+
+    TEST_ASSERT_EQUAL(CMD_OK, inv->SystemConfigPara()->getLastLimitCommandSuccess());
+    TEST_ASSERT_EQUAL_FLOAT(50, siminv.lastLimit);
+    TEST_ASSERT_EQUAL(PowerLimitControlType::RelativNonPersistent, siminv.lastLimitType);
+    TEST_ASSERT_FLOAT_WITHIN(0.05, 50, inv->SystemConfigPara()->getLimitPercent());
+
+    // Read back what the inverter reports
+    siminv.values.limitPercent = 42.5;
+    TEST_ASSERT_TRUE(inv->sendSystemConfigParaRequest(Hoymiles.getRadio()));
+    TEST_ASSERT_TRUE(runUntilIdle());
+    TEST_ASSERT_EQUAL(CMD_OK, inv->SystemConfigPara()->getLastLimitRequestSuccess());
+    TEST_ASSERT_FLOAT_WITHIN(0.05, 42.5, inv->SystemConfigPara()->getLimitPercent());
+}
+
+static void test_limit_timeout()
+{
+    addInverter(SERIAL_HM_1CH, 1);
+    sim->config.loss = 1;
+
+    TEST_ASSERT_TRUE(inv->sendActivePowerControlRequest(Hoymiles.getRadio(), 300, PowerLimitControlType::AbsolutNonPersistent));
+    TEST_ASSERT_TRUE(runUntilIdle(30000));
+    TEST_ASSERT_EQUAL(CMD_NOK, inv->SystemConfigPara()->getLastLimitCommandSuccess());
+}
+
+static void test_power()
+{
+    SimulatedInverter& siminv = addInverter(SERIAL_HM_4CH, 4);
+
+    TEST_ASSERT_TRUE(inv->sendPowerControlRequest(Hoymiles.getRadio(), false));
+    TEST_ASSERT_TRUE(runUntilIdle());
+    TEST_ASSERT_EQUAL(CMD_OK, inv->PowerCommand()->getLastPowerCommandSuccess());
+    TEST_ASSERT_EQUAL(1, siminv.lastPowerCommand);
+
+    TEST_ASSERT_TRUE(inv->sendRestartControlRequest(Hoymiles.getRadio()));
+    TEST_ASSERT_TRUE(runUntilIdle());
+    TEST_ASSERT_EQUAL(CMD_OK, inv->PowerCommand()->getLastPowerCommandSuccess());
+    TEST_ASSERT_EQUAL(2, siminv.lastPowerCommand);
+}
+
+static void test_alarm_log()
+{
+    SimulatedInverter& siminv = addInverter(SERIAL_HM_2CH, 2);
+    siminv.values.alarmCount = 4;
+
+    TEST_ASSERT_TRUE(inv->sendAlarmLogRequest(Hoymiles.getRadio(), true));
+    TEST_ASSERT_TRUE(runUntilIdle());
+    TEST_ASSERT_EQUAL(CMD_OK, inv->EventLog()->getLastAlarmRequestSuccess());
+    TEST_ASSERT_EQUAL(4, inv->EventLog()->getEntryCount());
+}
+
+// Without a valid time nothing is requested and the poll is not recorded
+static void test_alarm_log_needs_time()
+{
+    SimulatedInverter& siminv = addInverter(SERIAL_HM_1CH, 1);
+    siminv.values.alarmCount = 2;
+    inv->Poll()->setAlarmLogInterval(60000);
+
+    NativeSim::setLocalTimeValid(false);
+    TEST_ASSERT_FALSE(inv->sendAlarmLogRequest(Hoymiles.getRadio()));
+    TEST_ASSERT_TRUE(inv->Poll()->isAlarmLogDue(millis()));
+    TEST_ASSERT_TRUE(runUntilIdle());
+    TEST_ASSERT_EQUAL(0, siminv.requests);
+
+    // The counter in the stats tells that there are new entries
+    NativeSim::setLocalTimeValid(true);
+    TEST_ASSERT_TRUE(inv->sendStatsRequest(Hoymiles.getRadio()));
+    TEST_ASSERT_TRUE(runUntilIdle());
+    TEST_ASSERT_TRUE(inv->sendAlarmLogRequest(Hoymiles.getRadio()));
+    TEST_ASSERT_FALSE(inv->Poll()->isAlarmLogDue(millis()));
+    TEST_ASSERT_TRUE(runUntilIdle());
+    TEST_ASSERT_EQUAL(2, inv->EventLog()->getEntryCount());
+}
+
+// The poll loop fetches stats first and the background data afterwards
+static void test_poll_loop()
+{
+    addInverter(SERIAL_HM_4CH, 4);
+    Hoymiles.setPollInterval(5);
+
+    for (uint32_t ms = 0; ms < 20000; ms++) {
+        Hoymiles.loop();
+        step();
+    }
+    Hoymiles.setPollInterval(0);
+
+    TEST_ASSERT_TRUE(inv->Statistics()->getLastUpdate() > 0);
+    TEST_ASSERT_TRUE(inv->DevInfo()->getLastUpdateSimple() > 0);
+    TEST_ASSERT_EQUAL(CMD_OK, inv->SystemConfigPara()->getLastLimitRequestSuccess());
+    TEST_ASSERT_TRUE(inv->Poll()->getStatistics().statsUpdates >= 4);
+}
+
+int main(int argc, char** argv)
+{
+    Hoymiles.setMessageOutput(&logBuffer);
+    Hoymiles.setLogLevel(HOY_LOG_RADIO, HOY_LOG_LEVEL_DEBUG);
+    Hoymiles.init(new SPIClass(HSPI), PIN_CE, PIN_IRQ);
+    Hoymiles.getRadio()->setDtuSerial(DTU_SERIAL);
+    Hoymiles.setPollInterval(0);
+    NativeSim::runTasks();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_stats_hm1ch);
+    RUN_TEST(test_stats_hm2ch);
+    RUN_TEST(test_stats_hm4ch);
+    RUN_TEST(test_stats_loss);
+    RUN_TEST(test_stats_corruption);
+    RUN_TEST(test_stats_timeout);
+    RUN_TEST(test_stats_latency);
+    RUN_TEST(test_stats_late_response);
+    RUN_TEST(test_rx_timeout_per_type);
+    RUN_TEST(test_stats_fifo_overflow);
+    RUN_TEST(test_stats_fixed_channel);
+    RUN_TEST(test_dev_info);
+    RUN_TEST(test_limit);
+    RUN_TEST(test_limit_timeout);
+    RUN_TEST(test_power);
+    RUN_TEST(test_alarm_log);
+    RUN_TEST(test_alarm_log_needs_time);
+    RUN_TEST(test_poll_loop);
+    return UNITY_END();
+}
@@ -0,0 +1,8 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#pragma once
+
+#include <cstdint>
+
+// Number of heap allocations of the program so far. The global operator new is replaced in
+// a translation unit of its own, so the compiler can not match it with an inlined delete.
+uint32_t getAllocationCount();
@@ -0,0 +1,30 @@
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# Copyright (C) 2022 Thomas Basler and others
+#
+# Records the data of a VE.Direct device in the capture format of test_vedirect_replay,
+# see corpus/README.md. Stop it with Ctrl+C.
+#
+#   python capture.py /dev/ttyUSB0 corpus/mydevice.vecap [seconds]
+#
+import sys
+import time
+
+import serial
+
+if len(sys.argv) < 3:
+    sys.exit("usage: capture.py <port> <file> [seconds]")
+
+duration = float(sys.argv[3]) if len(sys.argv) > 3 else None
+
+with serial.Serial(sys.argv[1], 19200, timeout=0.01) as port, open(sys.argv[2], "w") as capture:
+    capture.write("# recorded from %s on %s\n" % (sys.argv[1], time.strftime("%Y-%m-%d %H:%M:%S")))
+    start = time.monotonic()
+    try:
+        while duration is None or time.monotonic() - start < duration:
+            data = port.read(max(1, port.in_waiting))
+            if data:
+                ms = int((time.monotonic() - start) * 1000)
+                capture.write("%d %s\n" % (ms, " ".join("%02x" % b for b in data)))
+    except KeyboardInterrupt:
+        pass
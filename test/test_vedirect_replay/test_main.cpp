@@ -0,0 +1,287 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (C) 2022 Thomas Basler and others
+ */
+#include "AllocationCounter.h"
+#include <NativeSim.h>
+#include <VeDirectFrameHandler.h>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unity.h>
+#include <vector>
+
+#define VE_UART 1
+#define VE_RX_PIN 22
+#define VE_TX_PIN 21
+
+#define THROUGHPUT_MIN_SECONDS 0.5
+
+// see corpus/README.md for the format
+struct Chunk {
+    uint32_t ms;
+    std::vector<uint8_t> data;
+};
+
+struct Expectation {
+    unsigned line;
+    std::string key;
+    std::string value;
+};
+
+struct Capture {
+    std::vector<Chunk> chunks;
+    std::vector<Expectation> expectations;
+};
+
+static const char* const corpus[] = {
+    "mppt.vecap",
+    "smartshunt.vecap",
+    "mppt_hex.vecap",
+    "checksum.vecap",
+    "truncated.vecap",
+    "hex_errors.vecap",
+    "noise.vecap",
+    "overflow.vecap"
+};
+
+static const struct {
+    const char* name;
+    uint32_t VeDirectParserStats::*counter;
+} counters[] = {
+    { "bytes", &VeDirectParserStats::bytes },
+    { "frames", &VeDirectParserStats::frames },
+    { "checksumErrors", &VeDirectParserStats::checksumErrors },
+    { "hexFrames", &VeDirectParserStats::hexFrames },
+    { "hexErrors", &VeDirectParserStats::hexErrors },
+    { "uartOverruns", &VeDirectParserStats::uartOverruns }
+};
+
+static uint32_t asyncMessages;
+
+// The corpus is next to this file, VEDIRECT_CORPUS replaces it by another directory
+static bool openCapture(const char* name, std::ifstream& file)
+{
+    const char* dir = getenv("VEDIRECT_CORPUS");
+    if (dir != nullptr) {
+        file.open(std::string(dir) + "/" + name);
+        return file.is_open();
+    }
+
+    std::string source = __FILE__;
+    file.open(source.substr(0, source.find_last_of("/\\") + 1) + "corpus/" + name);
+    if (!file.is_open()) {
+        // __FILE__ is relative to the project directory
+        file.open(std::string("test/test_vedirect_replay/corpus/") + name);
+    }
+    return file.is_open();
+}
+
+static void loadCapture(const char* name, Capture& capture)
+{
+    char message[128];
+    std::ifstream file;
+    snprintf(message, sizeof(message), "%s not found, set VEDIRECT_CORPUS", name);
+    TEST_ASSERT_TRUE_MESSAGE(openCapture(name, file), message);
+
+    std::string text;
+    for (unsigned line = 1; std::getline(file, text); line++) {
+        text = text.substr(0, text.find('#'));
+        std::istringstream in(text);
+        std::string word;
+        if (!(in >> word)) {
+            continue;
+        }
+
+        if (word == "expect") {
+            Expectation expectation;
+            expectation.line = line;
+            in >> expectation.key >> std::ws;
+            std::getline(in, expectation.value);
+            expectation.value.erase(expectation.value.find_last_not_of(" \t\r") + 1);
+            capture.expectations.push_back(expectation);
+            continue;
+        }
+
+        Chunk chunk;
+        char* end;
+        chunk.ms = strtoul(word.c_str(), &end, 10);
+        bool valid = *end == '\0';
+        while (valid && in >> word) {
+            unsigned long value = strtoul(word.c_str(), &end, 16);
+            valid = *end == '\0' && value <= 0xff;
+            chunk.data.push_back(value);
+        }
+        snprintf(message, sizeof(message), "%s:%u: invalid chunk", name, line);
+        TEST_ASSERT_TRUE_MESSAGE(valid && !chunk.data.empty(), message);
+        capture.chunks.push_back(chunk);
+    }
+}
+
+// The rx task of a handler never ends, so the handlers are not deleted
+static VeDirectFrameHandler* createHandler()
+{
+    VeDirectFrameHandler* handler = new VeDirectFrameHandler(VE_UART);
+    handler->init(VE_RX_PIN, VE_TX_PIN);
+    handler->setHexAsyncCallback([](const VeDirectHexData& data) { asyncMessages++; });
+    NativeSim::runTasks();
+    return handler;
+}
+
+// Passes the chunks to the uart at the recorded times, the rx task decodes them
+static void replay(const Capture& capture)
+{
+    HardwareSerial* uart = HardwareSerial::getPort(VE_UART);
+    uint32_t start = NativeSim::now();
+
+    for (const Chunk& chunk : capture.chunks) {
+        if (start + chunk.ms > NativeSim::now()) {
+            NativeSim::advance(start + chunk.ms - NativeSim::now());
+        }
+        uart->receive(chunk.data.data(), chunk.data.size());
+        NativeSim::runTasks();
+    }
+}
+
+// Value of a field of the frame by its label as getFieldAsString() prints it
+static bool getValue(const VeDirectRecord& frame, const std::string& label, char* buffer, size_t len)
+{
+    for (uint8_t field = 0; field < VE_FIELD_COUNT; field++) {
+        if (label == VeDirectFrameHandler::getFieldName(field)) {
+            return VeDirectFrameHandler::getFieldAsString(frame, field, buffer, len);
+        }
+    }
+    for (uint8_t i = 0; i < frame.extraCount; i++) {
+        if (label == frame.extra[i].name) {
+            strlcpy(buffer, frame.extra[i].value, len);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void checkCapture(const char* name)
+{
+    Capture capture;
+    loadCapture(name, capture);
+    TEST_ASSERT_TRUE(!capture.expectations.empty());
+
+    VeDirectFrameHandler* handler = createHandler();
+    asyncMessages = 0;
+    replay(capture);
+
+    VeDirectParserStats stats;
+    VeDirectRecord frame;
+    handler->getParserStats(stats);
+    handler->getFrame(frame);
+
+    for (const Expectation& expectation : capture.expectations) {
+        char message[128];
+        snprintf(message, sizeof(message), "%s:%u: %s", name, expectation.line, expectation.key.c_str());
+        uint32_t expected = strtoul(expectation.value.c_str(), nullptr, 10);
+
+        if (expectation.key == "async") {
+            TEST_ASSERT_EQUAL_UINT32_MESSAGE(expected, asyncMessages, message);
+            continue;
+        }
+
+        bool isCounter = false;
+        for (const auto& counter : counters) {
+            if (expectation.key == counter.name) {
+                TEST_ASSERT_EQUAL_UINT32_MESSAGE(expected, stats.*counter.counter, message);
+                isCounter = true;
+            }
+        }
+        if (isCounter) {
+            continue;
+        }
+
+        char value[VE_MAX_VALUE_LEN];
+        if (!getValue(frame, expectation.key, value, sizeof(value))) {
+            TEST_FAIL_MESSAGE(message);
+        }
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(expectation.value.c_str(), value, message);
+    }
+}
+
+static void test_mppt() { checkCapture("mppt.vecap"); }
+static void test_smartshunt() { checkCapture("smartshunt.vecap"); }
+static void test_mppt_hex() { checkCapture("mppt_hex.vecap"); }
+static void test_checksum() { checkCapture("checksum.vecap"); }
+static void test_truncated() { checkCapture("truncated.vecap"); }
+static void test_hex_errors() { checkCapture("hex_errors.vecap"); }
+static void test_noise() { checkCapture("noise.vecap"); }
+static void test_overflow() { checkCapture("overflow.vecap"); }
+
+// Feeds the whole corpus to the parser as fast as possible, without the uart and the rx task
+static void test_throughput()
+{
+    std::vector<uint8_t> stream;
+    for (const char* name : corpus) {
+        Capture capture;
+        loadCapture(name, capture);
+        for (const Chunk& chunk : capture.chunks) {
+            stream.insert(stream.end(), chunk.data.begin(), chunk.data.end());
+        }
+    }
+
+    VeDirectFrameHandler* handler = createHandler();
+    VeDirectParserStats before;
+    VeDirectParserStats after;
+
+    // the first pass is not measured
+    handler->feed(stream.data(), stream.size());
+    handler->getParserStats(before);
+
+    uint32_t passes = 0;
+    std::chrono::duration<double> elapsed;
+    uint32_t allocations = getAllocationCount();
+    auto start = std::chrono::steady_clock::now();
+    do {
+        handler->feed(stream.data(), stream.size());
+        passes++;
+        elapsed = std::chrono::steady_clock::now() - start;
+    } while (elapsed.count() < THROUGHPUT_MIN_SECONDS);
+    // the parser must not allocate at all
+    uint32_t allocated = getAllocationCount() - allocations;
+    handler->getParserStats(after);
+
+    uint32_t frames = after.frames - before.frames;
+    TEST_ASSERT_TRUE(frames > 0);
+
+    printf("VE.Direct replay of %u bytes, %u passes in %.3f s\n", static_cast<unsigned>(stream.size()), passes, elapsed.count());
+    printf("  %.0f frames/s, %.0f bytes/s\n", frames / elapsed.count(), (after.bytes - before.bytes) / elapsed.count());
+    printf("  %.3f allocations per frame\n", static_cast<double>(allocated) / frames);
+    printf("  per pass: %u frames, %u checksum errors, %u hex frames, %u hex errors\n",
+        frames / passes, (after.checksumErrors - before.checksumErrors) / passes,
+        (after.hexFrames - before.hexFrames) / passes, (after.hexErrors - before.hexErrors) / passes);
+
+    TEST_ASSERT_EQUAL_UINT32(0, allocated);
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+int main(int argc, char** argv)
+{
+    // the errors in the corpus are expected, the test checks the counters instead
+    Serial.setConsoleOutput(false);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_mppt);
+    RUN_TEST(test_smartshunt);
+    RUN_TEST(test_mppt_hex);
+    RUN_TEST(test_checksum);
+    RUN_TEST(test_truncated);
+    RUN_TEST(test_hex_errors);
+    RUN_TEST(test_noise);
+    RUN_TEST(test_overflow);
+    RUN_TEST(test_throughput);
+    return UNITY_END();
+}
@@ -48,4 +48,10 @@ export interface LiveData {
     inverters: Inverter[];
     total: Total;
     hints: Hints;
+}
+
+// a websocket message, it contains the inverter at position index of count inverters
+export interface LiveDataUpdate extends LiveData {
+    index: number;
+    count: number;
 }
\ No newline at end of file